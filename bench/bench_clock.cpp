@@ -0,0 +1,87 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Per-message timestamp cost: the original ostringstream/gmtime path vs
+ * the cached Clock service
+ *
+ * Usage: bench_clock [--iterations N]
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include "../shared/clock.h"
+#include "../shared/protocol.h"
+
+using namespace ChatUtils;
+using SteadyClock = std::chrono::steady_clock;
+
+// What every message used to pay
+static std::string legacy_timestamp() {
+    auto now = std::chrono::system_clock::now();
+    auto time = std::chrono::system_clock::to_time_t(now);
+    std::ostringstream oss;
+    oss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
+    return oss.str();
+}
+
+// gmtime_r + strftime on every call, no cache
+static void uncached_timestamp(char* out, size_t cap) {
+    time_t now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    strftime(out, cap, "%Y-%m-%dT%H:%M:%SZ", &utc);
+}
+
+template <typename Fn>
+static void run(const char* name, int iterations, double baseline_ns, double& result_ns, Fn fn) {
+    volatile size_t sink = 0;
+    auto start = SteadyClock::now();
+    for (int i = 0; i < iterations; ++i) sink = sink + fn();
+    double ns = std::chrono::duration<double, std::nano>(SteadyClock::now() - start).count() / iterations;
+    result_ns = ns;
+    std::cout << std::left << std::setw(34) << name << std::right << std::setw(9) << std::fixed
+              << std::setprecision(1) << ns << " ns/call";
+    if (baseline_ns > 0) std::cout << "   " << std::setprecision(1) << baseline_ns / ns << "x faster";
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::atoi(argv[++i]);
+        }
+    }
+
+    char buffer[MAX_TIMESTAMP_LEN];
+    double legacy = 0, ignored = 0;
+
+    std::cout << "iterations=" << iterations << std::endl;
+    run("legacy ostringstream + gmtime", iterations, 0, legacy, [] { return legacy_timestamp().size(); });
+    run("gmtime_r + strftime", iterations, legacy, ignored, [&buffer] {
+        uncached_timestamp(buffer, sizeof(buffer));
+        return static_cast<size_t>(buffer[18]);
+    });
+    run("Clock, seconds", iterations, legacy, ignored, [&buffer] {
+        return Clock::format_now(buffer, sizeof(buffer), Clock::Precision::SECONDS);
+    });
+    run("Clock, milliseconds", iterations, legacy, ignored, [&buffer] {
+        return Clock::format_now(buffer, sizeof(buffer), Clock::Precision::MILLIS);
+    });
+    run("Clock, microseconds", iterations, legacy, ignored, [&buffer] {
+        return Clock::format_now(buffer, sizeof(buffer), Clock::Precision::MICROS);
+    });
+    run("Clock::monotonic_ns", iterations, legacy, ignored, [] {
+        return static_cast<size_t>(Clock::monotonic_ns());
+    });
+
+    Clock::format_now(buffer, sizeof(buffer), Clock::Precision::MICROS);
+    std::cout << "sample: " << buffer << std::endl;
+    return 0;
+}
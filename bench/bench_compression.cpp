@@ -0,0 +1,108 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Compressed batches: bytes saved vs CPU spent
+ *
+ * Usage: bench_compression [--frames N] [--batch N]
+ *
+ * Frames are encoded chat messages (names, timestamps, sequence numbers
+ * and text from a small vocabulary). "replay" packs --frames of history
+ * into MAX_BATCH_LEN batches, as a resume does; "batches" sends them
+ * --batch frames at a time, as a backlogged connection does, once with
+ * one stream per connection (the window carries over) and once with a
+ * fresh stream per batch. Each row reports the wire size against the raw
+ * frames and the CPU cost per raw MB.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../shared/common.h"
+#include "../shared/compression.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Row {
+    size_t raw = 0;
+    size_t wire = 0;
+    double seconds = 0;
+};
+
+static void report(const char* name, int level, const Row& row) {
+    std::cout << std::left << std::setw(22) << name << " level " << level << std::right << "  "
+              << std::setw(9) << row.raw << " -> " << std::setw(8) << row.wire << " bytes  (" << std::fixed
+              << std::setprecision(1) << 100.0 * row.wire / row.raw << "%)  " << std::setprecision(2)
+              << row.seconds * 1e3 / (row.raw / 1e6) << " ms/MB" << std::endl;
+}
+
+// Pack `frames` into blocks of at most `per_block` frames / MAX_BATCH_LEN bytes
+static Row pack(const std::vector<std::string>& frames, size_t per_block, int level, bool shared_window) {
+    Row row;
+    std::vector<char> out(MAX_COMPRESSED_LEN);
+    std::unique_ptr<ChatUtils::DeflateStream> stream(new ChatUtils::DeflateStream(level));
+    auto start = Clock::now();
+    size_t i = 0;
+    while (i < frames.size()) {
+        if (!shared_window) stream.reset(new ChatUtils::DeflateStream(level));
+        stream->begin(out.data(), out.size());
+        size_t raw = 0, count = 0;
+        while (i < frames.size() && count < per_block && raw + frames[i].size() <= MAX_BATCH_LEN) {
+            stream->write(frames[i].data(), frames[i].size());
+            raw += frames[i].size();
+            count++;
+            i++;
+        }
+        row.raw += raw;
+        row.wire += 4 + stream->end();
+    }
+    row.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return row;
+}
+
+int main(int argc, char* argv[]) {
+    int count = 20000;
+    size_t batch = 8;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            count = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = static_cast<size_t>(std::atoi(argv[++i]));
+        }
+    }
+
+    const char* users[] = {"alice", "bob", "carol", "dave", "erin", "frank", "grace", "heidi"};
+    const char* words[] = {"the", "build", "is", "green", "deploy", "staging", "review", "please", "merged",
+                           "lunch", "anyone", "ticket", "fixed", "tests", "flaky", "again", "ok", "thanks",
+                           "looks", "good", "to", "me", "rollback", "prod", "latency", "graph", "spike"};
+    std::minstd_rand rng(11);
+    std::vector<std::string> frames;
+    char buffer[MAX_FRAME_LEN + 4];
+    for (int i = 0; i < count; ++i) {
+        Message msg;
+        std::strncpy(msg.user, users[rng() % 8], MAX_USERNAME_LEN - 1);
+        std::snprintf(msg.timestamp, MAX_TIMESTAMP_LEN, "2025-12-08T%02d:%02d:%02dZ", 9 + i / 3600 % 10,
+                      i / 60 % 60, i % 60);
+        std::strncpy(msg.room, "lobby", MAX_ROOMNAME_LEN - 1);
+        msg.seq = static_cast<uint64_t>(i + 1);
+        std::string text;
+        for (size_t w = 3 + rng() % 12; w > 0; --w) text += std::string(words[rng() % 27]) + " ";
+        std::strncpy(msg.text, text.c_str(), MAX_MESSAGE_LEN - 1);
+        frames.emplace_back(buffer, ChatUtils::encode_frame(msg, buffer, sizeof(buffer)));
+    }
+
+    std::cout << "frames=" << count << " batch=" << batch << std::endl;
+    for (int level : {1, 3, 6, 9}) {
+        report("replay", level, pack(frames, SIZE_MAX, level, true));
+        report("batches, one stream", level, pack(frames, batch, level, true));
+        report("batches, fresh each", level, pack(frames, batch, level, false));
+        report("single frames", level, pack(frames, 1, level, true));
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Direct-message latency and user-directory lookups with 10k users online
+ *
+ * Usage: bench_dm [--users N] [--live N] [--messages N] [--readers N]
+ *
+ * --users handlers are registered in the server's UserDirectory; --live of
+ * them are real connections (socketpairs, one handler thread each) joined
+ * through the normal hello, the rest are idle entries that only fill the
+ * directory. One thread sends DMs between random live pairs and times each
+ * from the sender's write to the recipient's read, so the number covers
+ * decode, the pipeline, the directory lookup and the single send. The
+ * lookup phase then runs --readers threads doing find() on random names.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../server/client_handler.h"
+#include "../server/room.h"
+#include "../server/server_context.h"
+#include "../shared/common.h"
+#include "../shared/hdr_histogram.h"
+#include "../shared/logger.h"
+
+using Clock = std::chrono::steady_clock;
+using ChatUtils::HdrHistogram;
+
+static std::string name_of(int i) {
+    return "user" + std::to_string(i);
+}
+
+int main(int argc, char* argv[]) {
+    int users = 10000;
+    int live = 100;
+    int messages = 20000;
+    int readers = 4;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--users") == 0 && i + 1 < argc) {
+            users = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--readers") == 0 && i + 1 < argc) {
+            readers = std::atoi(argv[++i]);
+        }
+    }
+    if (live < 2) live = 2;
+    if (users < live) users = live;
+
+    std::cout << "users=" << users << " live=" << live << " messages=" << messages << " readers=" << readers
+              << std::endl;
+    ChatUtils::Logger::instance().set_level(ChatUtils::LogLevel::WARN);
+
+    ServerContext context;
+    std::vector<std::shared_ptr<ClientHandler>> handlers;
+    std::vector<int> client_fds;
+
+    for (int i = 0; i < live; ++i) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            perror("socketpair");
+            return 1;
+        }
+        auto handler = std::make_shared<ClientHandler>(sv[0], i + 1, context);
+        handler->start();
+        handlers.push_back(handler);
+        client_fds.push_back(sv[1]);
+
+        Message hello;
+        std::strncpy(hello.user, name_of(i).c_str(), MAX_USERNAME_LEN - 1);
+        std::strncpy(hello.room, "dm-bench", MAX_ROOMNAME_LEN - 1);
+        std::strncpy(hello.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+        ChatUtils::send_message(sv[1], hello);
+    }
+    for (int i = live; i < users; ++i) {
+        auto idle = std::make_shared<ClientHandler>(-1, i + 1, context);
+        context.users.add(name_of(i), idle);
+        handlers.push_back(idle);
+    }
+    auto deadline = Clock::now() + std::chrono::seconds(30);
+    while (context.users.size() < static_cast<size_t>(users) && Clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cout << "directory: " << context.users.size() << " users" << std::endl;
+
+    // Round trips between random live pairs, one at a time
+    std::minstd_rand rng(42);
+    HdrHistogram latency;
+    Message msg, got;
+    int lost = 0;
+    auto start = Clock::now();
+    for (int n = 0; n < messages; ++n) {
+        int from = static_cast<int>(rng() % live);
+        int to = static_cast<int>(rng() % (live - 1));
+        if (to >= from) to++;
+        std::strncpy(msg.user, name_of(from).c_str(), MAX_USERNAME_LEN - 1);
+        std::strncpy(msg.to, name_of(to).c_str(), MAX_USERNAME_LEN - 1);
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "dm %d", n);
+
+        auto sent = Clock::now();
+        if (!ChatUtils::send_message(client_fds[from], msg) || !ChatUtils::recv_message(client_fds[to], got)) {
+            lost++;
+            break;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sent);
+        latency.record(static_cast<uint64_t>(elapsed.count()));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    auto us = [&](double p) { return latency.value_at_percentile(p) / 1000.0; };
+    std::cout << "dm latency us: p50 " << us(50) << "  p99 " << us(99) << "  p99.9 " << us(99.9) << "  max "
+              << latency.max() / 1000.0 << "  (" << static_cast<uint64_t>(latency.count() / seconds)
+              << " round trips/s" << (lost ? ", FAILED" : "") << ")" << std::endl;
+
+    // Directory reads alone, all readers at once
+    const int lookups = 1000000;
+    std::atomic<uint64_t> found(0);
+    std::vector<std::thread> threads;
+    start = Clock::now();
+    for (int t = 0; t < readers; ++t) {
+        threads.emplace_back([&, t]() {
+            std::minstd_rand local(static_cast<unsigned>(t + 1));
+            std::vector<std::string> names;
+            for (int i = 0; i < 1024; ++i) names.push_back(name_of(static_cast<int>(local() % users)));
+            uint64_t hits = 0;
+            for (int i = 0; i < lookups; ++i) {
+                if (context.users.find(names[i & 1023])) hits++;
+            }
+            found += hits;
+        });
+    }
+    for (auto& t : threads) t.join();
+    seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "lookups: " << static_cast<uint64_t>(static_cast<double>(readers) * lookups / seconds)
+              << "/s across " << readers << " readers (" << found.load() << " found)" << std::endl;
+
+    for (int fd : client_fds) shutdown(fd, SHUT_RDWR);
+    for (auto& handler : handlers) handler->stop();
+    for (int fd : client_fds) close(fd);
+    context.users.clear();
+    handlers.clear();
+    context.rooms.clear();
+    return lost ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Interned names: frame size and the cost of "is this mine?"
+ *
+ * Usage: bench_interning [--frames N] [--passes N]
+ *
+ * Frames are room messages from eight users with realistic names. Each
+ * is encoded with names (what every client gets without "intern") and
+ * with ids (what an interning client gets once the names are bound), then
+ * parsed back; the ids row includes filling the names back in from the
+ * session's dictionary. The last two rows pick out our own messages the
+ * way a client does: a string compare per message, or an id compare and
+ * a string compare only when the ids agree.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include "../shared/common.h"
+#include "../shared/intern_table.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double ns_per(Clock::time_point start, size_t count) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+int main(int argc, char* argv[]) {
+    int count = 4096;  // Small enough to stay in cache: this measures the work, not the misses
+    int passes = 50;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            count = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) {
+            passes = std::atoi(argv[++i]);
+        }
+    }
+    size_t total = static_cast<size_t>(count) * passes;
+
+    const char* users[] = {"alice.johnson", "bob_from_ops", "carol-sre", "dave.oncall",
+                           "erin_frontend", "frank.backend", "grace-design", "heidi.product"};
+    ChatUtils::InternTable table;
+    uint32_t room_id = table.intern("engineering-general");
+    std::minstd_rand rng(5);
+    std::vector<Message> messages(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        Message& msg = messages[i];
+        std::strncpy(msg.user, users[rng() % 8], MAX_USERNAME_LEN - 1);
+        msg.uid = table.intern(msg.user);
+        std::strncpy(msg.room, "engineering-general", MAX_ROOMNAME_LEN - 1);
+        msg.rid = room_id;
+        std::snprintf(msg.timestamp, MAX_TIMESTAMP_LEN, "2025-12-08T10:%02d:%02d.%03dZ", i / 60000 % 60,
+                      i / 1000 % 60, i % 1000);
+        msg.seq = static_cast<uint64_t>(i + 1);
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "deploy %d looks good", i % 97);
+    }
+
+    std::cout << "frames=" << count << " passes=" << passes << std::endl;
+    char frame[MAX_FRAME_LEN + 4];
+    std::vector<std::string> encoded[2];
+    for (NameForm form : {NameForm::NAMES, NameForm::IDS}) {
+        bool ids = form == NameForm::IDS;
+        size_t bytes = 0;
+        auto start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const Message& msg : messages) bytes += ChatUtils::encode_frame(msg, frame, sizeof(frame), form);
+        }
+        double encode_ns = ns_per(start, total);
+        for (const Message& msg : messages) {
+            size_t len = ChatUtils::encode_frame(msg, frame, sizeof(frame), form);
+            encoded[ids].emplace_back(frame + 4, len - 5);
+        }
+
+        // Receiving side: the dictionary already holds every binding
+        ChatUtils::NameDictionary names;
+        for (const Message& msg : messages) {
+            names.bind(msg.uid, msg.user);
+            names.bind(msg.rid, msg.room);
+        }
+        Message msg;
+        start = Clock::now();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (const std::string& json : encoded[ids]) {
+                Message::parse(json.data(), json.size(), msg);
+                if (ids) {
+                    std::strncpy(msg.user, names.find(msg.uid), MAX_USERNAME_LEN - 1);
+                    std::strncpy(msg.room, names.find(msg.rid), MAX_ROOMNAME_LEN - 1);
+                }
+            }
+        }
+        double decode_ns = ns_per(start, total);
+        std::cout << std::left << std::setw(10) << (ids ? "ids" : "names") << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(7) << static_cast<double>(bytes) / total
+                  << " bytes/frame  encode " << std::setw(6) << encode_ns << " ns  parse " << std::setw(6)
+                  << decode_ns << " ns" << std::endl;
+    }
+
+    // Picking out our own messages, as the GUI does for every one it shows
+    const std::string self = "frank.backend";
+    uint32_t self_id = table.intern(self);
+    size_t own = 0;
+    auto start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const Message& msg : messages) own += self == msg.user;
+    }
+    double by_name = ns_per(start, total);
+    size_t own_by_id = 0;
+    start = Clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (const Message& msg : messages) own_by_id += msg.uid == self_id && self == msg.user;
+    }
+    double by_id = ns_per(start, total);
+    std::cout << "own by name " << std::setprecision(2) << by_name << " ns, by id " << by_id << " ns ("
+              << own / passes << " = " << own_by_id / passes << " of " << messages.size() << ")" << std::endl;
+    return own == own_by_id ? 0 : 1;
+}
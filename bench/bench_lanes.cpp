@@ -0,0 +1,100 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Control-frame delay behind a bulk backlog: one FIFO vs priority lanes
+ *
+ * Usage: bench_lanes [--link-bytes N] [--ticks N] [--ping-every N]
+ *
+ * One connection's socket drains --link-bytes per tick while its room
+ * sends more than that, so a backlog builds in its Outbox. Every
+ * --ping-every ticks a control frame (a pong) is queued. "fifo" puts
+ * everything in one lane, as a plain send queue would; "lanes" puts the
+ * pong on the control lane. Both report how many ticks pongs waited.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "../server/outbox.h"
+
+struct Result {
+    double mean_ticks;
+    uint64_t max_ticks;
+    size_t backlog;
+};
+
+static FrameRef frame_of(char tag, size_t size) {
+    FrameRef frame(FrameBuffer::acquire(size));
+    std::memset(frame->data(), tag, size);
+    frame->set_size(size);
+    return frame;
+}
+
+static Result run(bool lanes, size_t link_bytes, uint64_t ticks, uint64_t ping_every) {
+    Outbox outbox;
+    std::vector<uint64_t> pending;  // Ticks the queued pongs were sent on, oldest first
+    uint64_t waited = 0, worst = 0, answered = 0;
+    size_t budget = 0;
+    FrameRef sending;
+    size_t offset = 0;
+
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        // The room sends 1.5x what the link carries
+        for (size_t bytes = 0; bytes < link_bytes * 3 / 2; bytes += 450) outbox.push(Outbox::ROOM, frame_of('r', 450));
+        if (tick % ping_every == 0) {
+            outbox.push(lanes ? Outbox::CONTROL : Outbox::ROOM, frame_of('c', 40));
+            pending.push_back(tick);
+        }
+
+        budget += link_bytes;
+        while (budget) {
+            if (!sending) {
+                sending = outbox.pop();
+                offset = 0;
+                if (!sending) break;
+            }
+            size_t n = std::min(budget, sending->size() - offset);
+            offset += n;
+            budget -= n;
+            if (offset < sending->size()) break;
+            if (sending->data()[0] == 'c') {
+                uint64_t wait = tick - pending.front();
+                pending.erase(pending.begin());
+                waited += wait;
+                worst = std::max(worst, wait);
+                answered++;
+            }
+            sending.reset();
+        }
+        budget = 0;  // A socket does not bank unused room
+    }
+    return Result{answered ? static_cast<double>(waited) / answered : 0, worst, outbox.bytes()};
+}
+
+int main(int argc, char* argv[]) {
+    size_t link_bytes = 64 * 1024;
+    uint64_t ticks = 2000;
+    uint64_t ping_every = 50;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--link-bytes") == 0 && i + 1 < argc) {
+            link_bytes = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = static_cast<uint64_t>(std::atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--ping-every") == 0 && i + 1 < argc) {
+            ping_every = static_cast<uint64_t>(std::atoll(argv[++i]));
+        }
+    }
+
+    std::cout << "link_bytes/tick=" << link_bytes << " ticks=" << ticks << " ping_every=" << ping_every << std::endl;
+    FrameBuffer::reserve(450, 1024);
+
+    for (bool lanes : {false, true}) {
+        Result r = run(lanes, link_bytes, ticks, ping_every);
+        std::cout << (lanes ? "lanes: " : "fifo:  ") << "pong wait mean " << r.mean_ticks << " ticks, max "
+                  << r.max_ticks << " ticks (backlog " << r.backlog / 1024 << " KiB at the end)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Logging cost on the calling thread: std::cerr + std::endl vs Logger
+ *
+ * Usage: bench_logger [--threads N] [--lines N]
+ *
+ * Each thread logs a connect-style line (string + int arguments). Output
+ * goes to /dev/null so only the call path is measured, as a busy server
+ * would see it.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "../shared/common.h"
+
+using namespace ChatUtils;
+using SteadyClock = std::chrono::steady_clock;
+
+template <typename Fn>
+static double run_threads(int threads, int lines, Fn log_line) {
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < lines; ++i) log_line(t, i);
+        });
+    }
+    auto start = SteadyClock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    return std::chrono::duration<double>(SteadyClock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int threads = 4;
+    int lines = 50000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines = std::atoi(argv[++i]);
+        }
+    }
+
+    int devnull = open("/dev/null", O_WRONLY);
+    int saved_stderr = dup(STDERR_FILENO);
+    const std::string user = "alice";
+    const double total = static_cast<double>(threads) * lines;
+
+    // Old path: synchronous, flushed, serialised on the stream
+    dup2(devnull, STDERR_FILENO);
+    double sync_s = run_threads(threads, lines, [&user](int t, int i) {
+        std::cerr << "[INFO] [ClientHandler] Client " << t * 1000000 + i << " connected as \""
+                  << user << "\"" << std::endl;
+    });
+    dup2(saved_stderr, STDERR_FILENO);
+
+    // New path: record into the thread's ring, format on the drain thread
+    Logger& logger = Logger::instance();
+    logger.set_output(devnull);
+    uint64_t dropped_before = logger.dropped();
+    double async_s = run_threads(threads, lines, [&user](int t, int i) {
+        LOG_INFO("ClientHandler", "Client ", t * 1000000 + i, " connected as \"", user, "\"");
+    });
+    logger.flush();
+    uint64_t dropped = logger.dropped() - dropped_before;
+    logger.set_output(saved_stderr);
+
+    std::cout << "threads=" << threads << " lines/thread=" << lines << std::endl;
+    std::cout << "cerr+endl: " << static_cast<uint64_t>(total / sync_s) << " lines/s, "
+              << sync_s * 1e9 / total << " ns/call" << std::endl;
+    std::cout << "Logger:    " << static_cast<uint64_t>(total / async_s) << " lines/s, "
+              << async_s * 1e9 / total << " ns/call, dropped " << dropped << std::endl;
+
+    close(devnull);
+    return 0;
+}
@@ -0,0 +1,422 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Microbenchmarks for the protocol and transport building blocks
+ *
+ * Usage: bench_micro [--filter SUBSTR] [--sizes 16,64,256,511]
+ *                    [--threads 1,2,4] [--min-time S] [--json]
+ *
+ * Every case runs for each text size and thread count. Threads run the
+ * same case concurrently, each on its own data (its own socketpair, its
+ * own ring), so the thread sweep shows contention. The ring rows also
+ * give overruns and generation (grows): either being non-zero means the
+ * row timed recovery, not a round trip.
+ *
+ * Cycles and instructions per op come from perf_event_open (user space
+ * only). Where the kernel does not allow it (perf_event_paranoid,
+ * containers) those columns read "-".
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../shared/common.h"
+#include "../shared/shm_ring.h"
+
+using namespace ChatUtils;
+
+namespace {
+
+// ===== Hardware counters =====
+
+// Cycles + instructions for the calling thread, read as one group
+class PerfCounters {
+public:
+    PerfCounters() {
+        leader_ = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (leader_ >= 0) instructions_ = open_counter(PERF_COUNT_HW_INSTRUCTIONS, leader_);
+        if (instructions_ < 0 && leader_ >= 0) {
+            close(leader_);
+            leader_ = -1;
+        }
+    }
+
+    ~PerfCounters() {
+        if (instructions_ >= 0) close(instructions_);
+        if (leader_ >= 0) close(leader_);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return leader_ >= 0; }
+
+    void start() {
+        if (!available()) return;
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void stop(uint64_t& cycles, uint64_t& instructions) {
+        cycles = instructions = 0;
+        if (!available()) return;
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        uint64_t values[3] = {};  // nr, cycles, instructions
+        if (read(leader_, values, sizeof(values)) == static_cast<ssize_t>(sizeof(values))) {
+            cycles = values[1];
+            instructions = values[2];
+        }
+    }
+
+private:
+    static int open_counter(uint64_t config, int group) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    int leader_ = -1;
+    int instructions_ = -1;
+};
+
+// ===== Harness =====
+
+struct Result;
+
+// One thread's view of a case: setup once, then op() in a loop
+class Case {
+public:
+    virtual ~Case() = default;
+    virtual bool op() = 0;                     // false aborts the run
+    virtual void annotate(Result&) const {}    // Case-specific totals, after the run
+};
+
+// Builds the per-thread state for (text size, thread index)
+using CaseFactory = std::function<std::unique_ptr<Case>(int size, int thread)>;
+
+struct Benchmark {
+    const char* name;
+    CaseFactory make;
+};
+
+struct Result {
+    uint64_t ops = 0;
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double seconds = 0;
+    bool counters = false;
+    bool failed = false;
+    bool ring = false;  // ShmRing cases: the two below are filled in
+    unsigned long overruns = 0;
+    int generation = 0;
+};
+
+Message make_message(int size) {
+    Message msg;
+    std::strcpy(msg.user, "alice");
+    std::strcpy(msg.room, "lobby");
+    Message::format_timestamp(msg.timestamp, sizeof(msg.timestamp));
+    msg.seq = 123456;
+    std::memset(msg.text, 'x', static_cast<size_t>(size));
+    msg.text[size] = '\0';
+    return msg;
+}
+
+Result run(const Benchmark& bench, int size, int threads, double min_time) {
+    std::vector<std::unique_ptr<Case>> cases;
+    for (int t = 0; t < threads; ++t) cases.push_back(bench.make(size, t));
+
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<Result> per_thread(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+    const uint64_t budget_ns = static_cast<uint64_t>(min_time * 1e9);
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            Case& c = *cases[static_cast<size_t>(t)];
+            Result& r = per_thread[static_cast<size_t>(t)];
+            PerfCounters counters;
+            for (int i = 0; i < 100; ++i) c.op();  // Warm caches and pools
+
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            counters.start();
+            uint64_t start = Clock::monotonic_ns();
+            uint64_t now = start;
+            // Check the clock every 64 ops so it stays out of the per-op cost
+            while (now - start < budget_ns) {
+                for (int i = 0; i < 64; ++i) {
+                    if (!c.op()) {
+                        r.failed = true;
+                        break;
+                    }
+                }
+                r.ops += 64;
+                if (r.failed) break;
+                now = Clock::monotonic_ns();
+            }
+            counters.stop(r.cycles, r.instructions);
+            r.seconds = (Clock::monotonic_ns() - start) / 1e9;
+            r.counters = counters.available();
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    Result total;
+    for (const auto& c : cases) c->annotate(total);
+    cases.clear();
+
+    total.counters = true;
+    for (const Result& r : per_thread) {
+        total.ops += r.ops;
+        total.cycles += r.cycles;
+        total.instructions += r.instructions;
+        total.seconds = std::max(total.seconds, r.seconds);
+        total.counters = total.counters && r.counters;
+        total.failed = total.failed || r.failed;
+    }
+    return total;
+}
+
+// ===== Cases =====
+
+class ToJson : public Case {
+public:
+    explicit ToJson(int size) : msg_(make_message(size)) {}
+    bool op() override { return !msg_.to_json().empty(); }
+
+private:
+    Message msg_;
+};
+
+class Encode : public Case {
+public:
+    explicit Encode(int size) : msg_(make_message(size)) {}
+    bool op() override { return msg_.encode(buffer_, sizeof(buffer_)) > 0; }
+
+private:
+    Message msg_;
+    char buffer_[MAX_FRAME_LEN];
+};
+
+class FromJson : public Case {
+public:
+    explicit FromJson(int size) : json_(make_message(size).to_json()) {}
+    bool op() override { return Message::from_json(json_).seq != 0; }
+
+private:
+    std::string json_;
+};
+
+class Parse : public Case {
+public:
+    explicit Parse(int size) : json_(make_message(size).to_json()) {}
+    bool op() override { return Message::parse(json_.data(), json_.size(), msg_); }
+
+private:
+    std::string json_;
+    Message msg_;
+};
+
+// send_message on one end of a socketpair, recv_message on the other
+class SocketRoundTrip : public Case {
+public:
+    explicit SocketRoundTrip(int size) : msg_(make_message(size)) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds_) != 0) fds_[0] = fds_[1] = -1;
+    }
+    ~SocketRoundTrip() override {
+        if (fds_[0] >= 0) close(fds_[0]);
+        if (fds_[1] >= 0) close(fds_[1]);
+    }
+    bool op() override { return fds_[0] >= 0 && send_message(fds_[0], msg_) && recv_message(fds_[1], in_); }
+
+private:
+    Message msg_;
+    Message in_;
+    int fds_[2];
+};
+
+const char* kShmName = "/os_chat_bench_micro";
+const char* kShmMutex = "/os_chat_bench_micro_mutex";
+
+// What ShmClient::write_to_buffer / read_from_buffer do: one write, one
+// read. Each thread has its own ring: on a shared one a thread that loses
+// its time slice falls a ring behind the others, so the row would time
+// overruns and grows instead.
+class ShmRoundTrip : public Case {
+public:
+    ShmRoundTrip(int size, int thread)
+        : msg_(make_message(size)),
+          name_(std::string(kShmName) + "_" + std::to_string(thread)),
+          mutex_(std::string(kShmMutex) + "_" + std::to_string(thread)) {
+        ShmRing::unlink(name_, mutex_);
+        ring_.open(name_, mutex_);
+    }
+    ~ShmRoundTrip() override {
+        ring_.close();
+        ShmRing::unlink(name_, mutex_);
+    }
+    bool op() override { return ring_.write(msg_) && ring_.read(in_, 0); }
+    void annotate(Result& r) const override {
+        r.ring = true;
+        r.overruns += ring_.overruns();
+        r.generation = std::max(r.generation, ring_.generation());
+    }
+
+private:
+    ShmRing ring_;
+    Message msg_;
+    Message in_;
+    std::string name_;
+    std::string mutex_;
+};
+
+class Timestamp : public Case {
+public:
+    bool op() override { return !Message::get_current_timestamp().empty(); }
+};
+
+class TimestampInPlace : public Case {
+public:
+    bool op() override {
+        Message::format_timestamp(buffer_, sizeof(buffer_));
+        return buffer_[0] != '\0';
+    }
+
+private:
+    char buffer_[MAX_TIMESTAMP_LEN];
+};
+
+std::vector<int> parse_list(const char* s) {
+    std::vector<int> out;
+    for (const char* p = s; *p;) {
+        out.push_back(std::atoi(p));
+        const char* comma = std::strchr(p, ',');
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::vector<int> sizes = {16, 64, 256, MAX_MESSAGE_LEN - 1};
+    std::vector<int> thread_counts = {1, 2, 4};
+    double min_time = 0.2;
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            sizes = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_counts = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        }
+    }
+    for (int& s : sizes) s = std::max(0, std::min(s, MAX_MESSAGE_LEN - 1));
+
+    const std::vector<Benchmark> benchmarks = {
+        {"Message::to_json", [](int size, int) { return std::make_unique<ToJson>(size); }},
+        {"Message::encode", [](int size, int) { return std::make_unique<Encode>(size); }},
+        {"Message::from_json", [](int size, int) { return std::make_unique<FromJson>(size); }},
+        {"Message::parse", [](int size, int) { return std::make_unique<Parse>(size); }},
+        {"send_message+recv_message", [](int size, int) { return std::make_unique<SocketRoundTrip>(size); }},
+        {"ShmRing write+read", [](int size, int thread) { return std::make_unique<ShmRoundTrip>(size, thread); }},
+        {"get_current_timestamp", [](int, int) { return std::make_unique<Timestamp>(); }},
+        {"format_timestamp", [](int, int) { return std::make_unique<TimestampInPlace>(); }},
+    };
+
+    if (!json) {
+        PerfCounters probe;
+        std::cout << "hardware counters: " << (probe.available() ? "on" : "unavailable") << std::endl;
+        std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(6) << "size"
+                  << std::setw(8) << "threads" << std::setw(12) << "ns/op" << std::setw(14) << "ops/s"
+                  << std::setw(12) << "cycles/op" << std::setw(12) << "instr/op" << std::setw(7) << "IPC"
+                  << std::endl;
+    }
+
+    for (const Benchmark& bench : benchmarks) {
+        if (!filter.empty() && std::string(bench.name).find(filter) == std::string::npos) continue;
+        // Timestamps do not depend on message size
+        bool sized = std::strstr(bench.name, "timestamp") == nullptr;
+        for (size_t s = 0; s < (sized ? sizes.size() : 1); ++s) {
+            int size = sized ? sizes[s] : 0;
+            for (int threads : thread_counts) {
+                if (threads <= 0) continue;
+                Result r = run(bench, size, threads, min_time);
+                if (r.failed || r.ops == 0) {
+                    std::cerr << bench.name << ": failed (size " << size << ", threads " << threads << ")"
+                              << std::endl;
+                    continue;
+                }
+                // ns/op is per thread (latency); ops/s is all threads together
+                double ns_per_op = r.seconds * 1e9 * threads / static_cast<double>(r.ops);
+                double ops_per_s = static_cast<double>(r.ops) / r.seconds;
+                double cycles = r.counters ? static_cast<double>(r.cycles) / r.ops : -1;
+                double instructions = r.counters ? static_cast<double>(r.instructions) / r.ops : -1;
+
+                if (json) {
+                    // Counters are null where perf_event_open is not permitted
+                    char hw[96] = "\"cycles_per_op\":null,\"instructions_per_op\":null";
+                    if (r.counters) {
+                        std::snprintf(hw, sizeof(hw), "\"cycles_per_op\":%.1f,\"instructions_per_op\":%.1f", cycles,
+                                      instructions);
+                    }
+                    char ring[64] = "";
+                    if (r.ring) {
+                        std::snprintf(ring, sizeof(ring), ",\"overruns\":%lu,\"generation\":%d", r.overruns,
+                                      r.generation);
+                    }
+                    std::printf("{\"bench\":\"%s\",\"size\":%d,\"threads\":%d,\"ops\":%llu,\"ns_per_op\":%.2f,"
+                                "\"ops_per_s\":%.0f,%s%s}\n",
+                                bench.name, size, threads, static_cast<unsigned long long>(r.ops), ns_per_op,
+                                ops_per_s, hw, ring);
+                    continue;
+                }
+                std::cout << std::left << std::setw(28) << bench.name << std::right << std::setw(6)
+                          << (sized ? std::to_string(size) : "-") << std::setw(8) << threads << std::fixed
+                          << std::setprecision(1) << std::setw(12) << ns_per_op << std::setprecision(0)
+                          << std::setw(14) << ops_per_s;
+                if (r.counters) {
+                    std::cout << std::setprecision(1) << std::setw(12) << cycles << std::setw(12) << instructions
+                              << std::setprecision(2) << std::setw(7)
+                              << (cycles > 0 ? instructions / cycles : 0.0);
+                } else {
+                    std::cout << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(7) << "-";
+                }
+                if (r.ring) std::cout << "  overruns " << r.overruns << ", generation " << r.generation;
+                std::cout << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Sequenced vs unordered room fan-out throughput
+ *
+ * Usage: bench_sequencer [--producers N] [--recipients N] [--messages N]
+ *
+ * "unordered" reproduces the old path: every handler thread takes the
+ * clients mutex and sends to each recipient itself. "sequenced" submits to
+ * the room's Sequencer and lets its thread do the fan-out.
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../server/sequencer.h"
+#include "../shared/common.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct Recipient {
+    int server_fd = -1;  // Written by the fan-out path
+    int client_fd = -1;  // Drained by the reader thread
+    std::vector<std::pair<int, int>> order;  // (producer, n) as received
+    uint64_t last_seq = 0;
+    uint64_t seq_errors = 0;
+    std::thread reader;
+};
+
+struct Result {
+    double seconds = 0;
+    uint64_t disagreements = 0;  // Positions where a recipient's order differs from recipient 0's
+    uint64_t seq_errors = 0;
+};
+
+static void drain(Recipient* r, size_t expected) {
+    Message msg;
+    r->order.reserve(expected);
+    while (r->order.size() < expected && ChatUtils::recv_message(r->client_fd, msg)) {
+        if (msg.seq) {
+            if (r->last_seq && msg.seq != r->last_seq + 1) r->seq_errors++;
+            r->last_seq = msg.seq;
+        }
+        r->order.emplace_back(std::atoi(msg.user + 1), std::atoi(msg.text));
+    }
+}
+
+static Result run(bool sequenced, int producers, int recipients, int messages) {
+    std::vector<Recipient> rs(recipients);
+    for (auto& r : rs) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            perror("socketpair");
+            std::exit(1);
+        }
+        r.server_fd = sv[0];
+        r.client_fd = sv[1];
+    }
+    const size_t expected = static_cast<size_t>(producers) * messages;
+    for (auto& r : rs) {
+        r.reader = std::thread(drain, &r, expected);
+    }
+
+    std::mutex clients_mutex;
+    auto fan_out = [&](const Message& msg) {
+        for (auto& r : rs) {
+            ChatUtils::send_message(r.server_fd, msg);
+        }
+    };
+    Sequencer sequencer([&](const Message& msg, int) { fan_out(msg); });
+    if (sequenced) sequencer.start();
+
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            Message msg;
+            std::snprintf(msg.user, MAX_USERNAME_LEN, "p%d", p);
+            for (int n = 0; n < messages; ++n) {
+                std::snprintf(msg.text, MAX_MESSAGE_LEN, "%d", n);
+                if (sequenced) {
+                    sequencer.submit(msg, p);
+                } else {
+                    std::lock_guard<std::mutex> lock(clients_mutex);
+                    fan_out(msg);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (auto& r : rs) r.reader.join();
+    Result result;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    sequencer.stop();
+
+    for (auto& r : rs) {
+        result.seq_errors += r.seq_errors;
+        for (size_t i = 0; i < r.order.size() && i < rs[0].order.size(); ++i) {
+            if (r.order[i] != rs[0].order[i]) result.disagreements++;
+        }
+        close(r.server_fd);
+        close(r.client_fd);
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int producers = 4;
+    int recipients = 8;
+    int messages = 20000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--producers") == 0 && i + 1 < argc) {
+            producers = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--recipients") == 0 && i + 1 < argc) {
+            recipients = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = std::atoi(argv[++i]);
+        }
+    }
+
+    std::cout << "producers=" << producers << " recipients=" << recipients
+              << " messages/producer=" << messages << std::endl;
+
+    for (bool sequenced : {false, true}) {
+        Result r = run(sequenced, producers, recipients, messages);
+        double total = static_cast<double>(producers) * messages;
+        std::cout << (sequenced ? "sequenced " : "unordered ")
+                  << " throughput " << static_cast<uint64_t>(total / r.seconds) << " msg/s"
+                  << "  delivered " << static_cast<uint64_t>(total * recipients / r.seconds) << " frames/s"
+                  << "  order disagreements " << r.disagreements
+                  << "  seq gaps " << r.seq_errors << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Work-stealing pool scaling: 1..N workers
+ *
+ * Usage: bench_task_pool [--max-workers N] [--clients N] [--messages N] [--work-us N]
+ *
+ * Simulates bursty ingest: a few "hot" clients send most of the traffic.
+ * Each message is a task that burns roughly --work-us of CPU (standing in
+ * for validation, indexing and moderation stages).
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../server/task_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Busy work that the optimiser cannot drop
+static uint64_t spin_work(int micros) {
+    uint64_t h = 1469598103934665603ULL;
+    auto until = Clock::now() + std::chrono::microseconds(micros);
+    while (Clock::now() < until) {
+        for (int i = 0; i < 64; ++i) h = (h ^ static_cast<uint64_t>(i)) * 1099511628211ULL;
+    }
+    return h;
+}
+
+struct MessageTask : PoolTask {
+    std::atomic<uint64_t>* done = nullptr;
+    std::atomic<uint64_t>* sink = nullptr;
+    int work_us = 0;
+    void execute() override {
+        sink->fetch_add(spin_work(work_us), std::memory_order_relaxed);
+        done->fetch_add(1, std::memory_order_release);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int max_workers = static_cast<int>(std::thread::hardware_concurrency());
+    int clients = 8;
+    int messages = 20000;
+    int work_us = 20;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--max-workers") == 0 && i + 1 < argc) {
+            max_workers = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            clients = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) {
+            messages = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--work-us") == 0 && i + 1 < argc) {
+            work_us = std::atoi(argv[++i]);
+        }
+    }
+    if (max_workers < 1) max_workers = 1;
+
+    std::cout << "clients=" << clients << " messages=" << messages
+              << " work/message=" << work_us << "us" << std::endl;
+
+    std::vector<MessageTask> tasks(static_cast<size_t>(messages));
+    double base_rate = 0;
+
+    for (int workers = 1; workers <= max_workers; ++workers) {
+        std::atomic<uint64_t> done(0);
+        std::atomic<uint64_t> sink(0);
+        for (auto& t : tasks) {
+            t.done = &done;
+            t.sink = &sink;
+            t.work_us = work_us;
+        }
+
+        TaskPool pool(static_cast<size_t>(workers));
+        pool.start();
+
+        auto start = Clock::now();
+        std::vector<std::thread> ingest;
+        // Client 0 is hot and sends half of all traffic in one burst;
+        // the other clients share the rest
+        const int hot = clients > 1 ? messages / 2 : messages;
+        for (int c = 0; c < clients; ++c) {
+            ingest.emplace_back([&, c]() {
+                int first = c == 0 ? 0 : hot + (c - 1);
+                int last = c == 0 ? hot : messages;
+                int step = c == 0 ? 1 : clients - 1;
+                for (int m = first; m < last; m += step) {
+                    pool.submit(&tasks[static_cast<size_t>(m)]);
+                }
+            });
+        }
+        for (auto& t : ingest) t.join();
+        while (done.load(std::memory_order_acquire) < static_cast<uint64_t>(messages)) {
+            std::this_thread::yield();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        uint64_t steals = pool.steals();
+        pool.stop();
+
+        double rate = messages / seconds;
+        if (workers == 1) base_rate = rate;
+        std::cout << "workers=" << workers
+                  << "  " << static_cast<uint64_t>(rate) << " msg/s"
+                  << "  speedup " << rate / base_rate
+                  << "  steals " << steals << std::endl;
+    }
+    return 0;
+}
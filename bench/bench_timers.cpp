@@ -0,0 +1,72 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Idle-timeout bookkeeping for many connections: timer wheel vs scanning
+ *
+ * Usage: bench_timers [--connections N] [--interval-ticks N] [--ticks N]
+ *
+ * Every connection has a deadline --interval-ticks ahead and re-arms it
+ * when it fires, as the IdleMonitor does for a quiet connection. "scan"
+ * checks every connection's deadline on every tick; "wheel" advances a
+ * TimerWheel one tick. Both report the cost per tick and how many
+ * deadlines fired, which must agree.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include "../server/timer_wheel.h"
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+    int connections = 100000;
+    uint64_t interval = 300;  // 30 s at the monitor's 100 ms tick
+    uint64_t ticks = 3000;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            connections = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--interval-ticks") == 0 && i + 1 < argc) {
+            interval = static_cast<uint64_t>(std::atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = static_cast<uint64_t>(std::atoll(argv[++i]));
+        }
+    }
+
+    std::cout << "connections=" << connections << " interval_ticks=" << interval << " ticks=" << ticks
+              << std::endl;
+
+    // Deadlines spread over one interval, as connections arrive over time
+    std::vector<uint64_t> deadlines(connections);
+    for (int i = 0; i < connections; ++i) deadlines[i] = 1 + static_cast<uint64_t>(i) % interval;
+
+    uint64_t scan_fired = 0;
+    auto start = Clock::now();
+    for (uint64_t tick = 1; tick <= ticks; ++tick) {
+        for (uint64_t& deadline : deadlines) {
+            if (deadline <= tick) {
+                deadline = tick + interval;
+                scan_fired++;
+            }
+        }
+    }
+    double scan_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ticks;
+
+    TimerWheel wheel;
+    std::vector<TimerWheel::Timer> timers(connections);
+    for (int i = 0; i < connections; ++i) wheel.schedule(&timers[i], 1 + static_cast<uint64_t>(i) % interval);
+    uint64_t wheel_fired = 0;
+    start = Clock::now();
+    for (uint64_t tick = 1; tick <= ticks; ++tick) {
+        wheel_fired += wheel.advance(tick, [&](TimerWheel::Timer* t) { wheel.schedule(t, tick + interval); });
+    }
+    double wheel_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ticks;
+
+    std::cout << "scan:  " << static_cast<uint64_t>(scan_ns) << " ns/tick  (" << scan_fired << " fired)" << std::endl;
+    std::cout << "wheel: " << static_cast<uint64_t>(wheel_ns) << " ns/tick  (" << wheel_fired << " fired)"
+              << std::endl;
+    return scan_fired == wheel_fired ? 0 : 1;
+}
@@ -0,0 +1,703 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Load generator: many headless clients over TCP or the shared-memory ring
+ *
+ * Usage: chat_bench [--mode tcp|shm] [--host H] [--port P] [--spawn PATH]
+ *                   [--server-pid PID] [--clients N] [--rooms N]
+ *                   [--layout even|zipf] [--senders FRACTION] [--rate MSG/S]
+ *                   [--size fixed:N|uniform:A-B|exp:MEAN] [--duration S]
+ *                   [--warmup S] [--threads N] [--seed N] [--label STR] [--quiet]
+ *
+ * Clients are spread over rooms (evenly, or Zipf-skewed so room 0 is the
+ * busiest). In each room the first FRACTION of members send at MSG/S each;
+ * everybody, senders included, receives. Every message carries its send
+ * time, so each delivery yields an end-to-end latency sample.
+ *
+ * One JSON object goes to stdout (compare runs across commits); a readable
+ * summary goes to stderr unless --quiet. With --spawn (or --server-pid) the
+ * server's CPU time and RSS are reported too. CPU per message is CPU time
+ * over the window divided by messages sent (not deliveries).
+ *
+ *   chat_bench --spawn build/server/chat_server --clients 2000 --rooms 20 \
+ *              --senders 0.05 --rate 20 --label $(git rev-parse --short HEAD)
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../shared/common.h"
+#include "../shared/hdr_histogram.h"
+#include "../shared/shm_ring.h"
+
+using namespace ChatUtils;
+
+namespace {
+
+struct Options {
+    std::string mode = "tcp";
+    std::string host = "127.0.0.1";
+    int port = 0;  // 0: DEFAULT_PORT, or a free one when spawning
+    std::string spawn;
+    pid_t server_pid = 0;
+    int clients = 1000;
+    int rooms = 10;
+    std::string layout = "even";
+    double senders = 0.1;
+    double rate = 10.0;
+    std::string size = "uniform:32-256";
+    double duration = 10.0;
+    double warmup = 1.0;
+    int threads = 0;
+    uint64_t seed = 1;
+    std::string label;
+    bool quiet = false;
+};
+
+// ===== Message sizes =====
+
+struct SizeDist {
+    enum Kind { FIXED, UNIFORM, EXP } kind = UNIFORM;
+    int a = 32;
+    int b = 256;
+
+    // Header "B <ns> " needs room; text is capped by the protocol
+    static constexpr int kMin = 24;
+    static constexpr int kMax = MAX_MESSAGE_LEN - 1;
+
+    bool parse(const std::string& spec) {
+        if (spec.compare(0, 6, "fixed:") == 0) {
+            kind = FIXED;
+            a = b = std::atoi(spec.c_str() + 6);
+        } else if (spec.compare(0, 8, "uniform:") == 0 && spec.find('-') != std::string::npos) {
+            kind = UNIFORM;
+            a = std::atoi(spec.c_str() + 8);
+            b = std::atoi(spec.c_str() + spec.find('-') + 1);
+        } else if (spec.compare(0, 4, "exp:") == 0) {
+            kind = EXP;
+            a = std::atoi(spec.c_str() + 4);
+        } else {
+            return false;
+        }
+        return a > 0 && (kind == EXP || b >= a);
+    }
+
+    int sample(std::mt19937_64& rng) const {
+        double v = a;
+        if (kind == UNIFORM) {
+            v = std::uniform_int_distribution<int>(a, b)(rng);
+        } else if (kind == EXP) {
+            v = std::exponential_distribution<double>(1.0 / a)(rng);
+        }
+        return std::clamp(static_cast<int>(v), kMin, kMax);
+    }
+};
+
+// Text = "B <send ns> xxxx..." padded to `size` bytes
+void fill_text(char* text, int size, uint64_t send_ns) {
+    int n = std::snprintf(text, MAX_MESSAGE_LEN, "B %llu ", static_cast<unsigned long long>(send_ns));
+    if (size > n) std::memset(text + n, 'x', static_cast<size_t>(size - n));
+    text[std::max(size, n)] = '\0';
+}
+
+// Send time of a bench message, or 0 for anything else
+uint64_t parse_send_ns(const char* text, const char* end) {
+    if (end - text < 3 || text[0] != 'B' || text[1] != ' ') return 0;
+    uint64_t ns = 0;
+    for (const char* p = text + 2; p < end && *p >= '0' && *p <= '9'; ++p) ns = ns * 10 + static_cast<uint64_t>(*p - '0');
+    return ns;
+}
+
+// ===== Client layout =====
+
+struct ClientSpec {
+    int room;
+    bool sender;
+};
+
+std::vector<ClientSpec> plan_clients(const Options& opt, std::vector<int>& members) {
+    // Members per room: equal shares, or proportional to 1/(r+1)
+    std::vector<double> weight(static_cast<size_t>(opt.rooms), 1.0);
+    if (opt.layout == "zipf") {
+        for (int r = 0; r < opt.rooms; ++r) weight[static_cast<size_t>(r)] = 1.0 / (r + 1);
+    }
+    double total = 0;
+    for (double w : weight) total += w;
+
+    members.assign(static_cast<size_t>(opt.rooms), 0);
+    int assigned = 0;
+    for (int r = 0; r < opt.rooms; ++r) {
+        int n = static_cast<int>(opt.clients * weight[static_cast<size_t>(r)] / total);
+        members[static_cast<size_t>(r)] = n;
+        assigned += n;
+    }
+    for (int r = 0; assigned < opt.clients; r = (r + 1) % opt.rooms, ++assigned) members[static_cast<size_t>(r)]++;
+
+    std::vector<ClientSpec> clients;
+    for (int r = 0; r < opt.rooms; ++r) {
+        int m = members[static_cast<size_t>(r)];
+        int senders = m == 0 ? 0 : std::max(1, static_cast<int>(std::lround(m * opt.senders)));
+        for (int k = 0; k < m; ++k) clients.push_back(ClientSpec{r, k < senders});
+    }
+    return clients;
+}
+
+// ===== Per-thread results =====
+
+struct WorkerStats {
+    uint64_t sent = 0;           // Messages sent inside the measured window
+    uint64_t expected = 0;       // Deliveries those should cause
+    uint64_t delivered = 0;      // Deliveries of windowed messages received
+    uint64_t errors = 0;         // Connect/send failures, disconnects, overruns
+    HdrHistogram latency;
+};
+
+struct Window {
+    uint64_t warm_ns;   // Senders start
+    uint64_t start_ns;  // Warmup ends, measuring begins
+    uint64_t stop_ns;   // Senders stop
+    uint64_t drain_ns;  // Receivers give up waiting
+};
+
+bool in_window(const Window& w, uint64_t ns) {
+    return ns >= w.start_ns && ns < w.stop_ns;
+}
+
+void sleep_until(uint64_t ns) {
+    uint64_t now = Clock::monotonic_ns();
+    if (ns > now) std::this_thread::sleep_for(std::chrono::nanoseconds(ns - now));
+}
+
+// Sender pacing: fixed interval with a random phase so senders do not burst together
+struct Pacer {
+    uint64_t next_ns = 0;
+    uint64_t interval_ns = 0;
+
+    void init(double rate, uint64_t start_ns, std::mt19937_64& rng) {
+        interval_ns = static_cast<uint64_t>(1e9 / rate);
+        next_ns = start_ns + std::uniform_int_distribution<uint64_t>(0, interval_ns)(rng);
+    }
+};
+
+// ===== TCP =====
+
+struct TcpClient {
+    int fd = -1;
+    ClientSpec spec;
+    Pacer pacer;
+    std::vector<char> in;   // Partial frames
+    size_t in_len = 0;
+    std::string out;        // Bytes the socket would not take yet
+    size_t out_off = 0;
+    bool closed = false;
+};
+
+int connect_tcp(const Options& opt) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(opt.port));
+    inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool flush_out(TcpClient& c) {
+    while (c.out_off < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        c.out_off += static_cast<size_t>(n);
+    }
+    c.out.clear();
+    c.out_off = 0;
+    return true;
+}
+
+// Pull whatever is readable and account for every complete frame
+bool drain_in(TcpClient& c, const Window& w, WorkerStats& stats) {
+    for (;;) {
+        ssize_t n = recv(c.fd, c.in.data() + c.in_len, c.in.size() - c.in_len, MSG_DONTWAIT);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        uint64_t now = Clock::monotonic_ns();
+        c.in_len += static_cast<size_t>(n);
+
+        size_t off = 0;
+        while (c.in_len - off >= 4) {
+            uint32_t len;
+            std::memcpy(&len, c.in.data() + off, 4);
+            len = ntohl(len);
+            if (len > MAX_FRAME_LEN) return false;
+            if (c.in_len - off < 4 + len) break;
+
+            const char* payload = c.in.data() + off + 4;
+            const char* text = static_cast<const char*>(memmem(payload, len, "\"text\":\"", 8));
+            if (memmem(payload, text ? static_cast<size_t>(text - payload) : len, "\"ping\":1", 8)) {
+                // Keep quiet receivers from being reaped as idle
+                Message pong;
+                pong.heartbeat = HEARTBEAT_PONG;
+                char frame[MAX_FRAME_LEN + 4];
+                c.out.append(frame, encode_frame(pong, frame, sizeof(frame)));
+                if (!flush_out(c)) return false;
+            }
+            uint64_t sent_ns = text ? parse_send_ns(text + 8, payload + len) : 0;
+            if (sent_ns && in_window(w, sent_ns)) {
+                stats.delivered++;
+                stats.latency.record(now - sent_ns);
+            }
+            off += 4 + len;
+        }
+        std::memmove(c.in.data(), c.in.data() + off, c.in_len - off);
+        c.in_len -= off;
+    }
+}
+
+void tcp_worker(const Options& opt, std::vector<TcpClient>& clients, const std::vector<int>& members,
+                std::atomic<int>& ready, const std::atomic<bool>& go, const Window& w, WorkerStats& stats, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    SizeDist sizes;
+    sizes.parse(opt.size);
+
+    int ep = epoll_create1(0);
+    for (size_t i = 0; i < clients.size(); ++i) {
+        TcpClient& c = clients[i];
+        c.fd = connect_tcp(opt);
+        if (c.fd < 0) {
+            c.closed = true;
+            stats.errors++;
+            continue;
+        }
+        Message hello;
+        std::snprintf(hello.user, MAX_USERNAME_LEN, "bench%d_%zu", static_cast<int>(seed % 1000), i);
+        std::snprintf(hello.room, MAX_ROOMNAME_LEN, "bench-%d", c.spec.room);
+        std::strcpy(hello.text, "[JOINED]");
+        if (!send_message(c.fd, hello)) {
+            close(c.fd);
+            c.fd = -1;
+            c.closed = true;
+            stats.errors++;
+            continue;
+        }
+        c.in.resize(64 * 1024);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i;
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+    ready.fetch_add(1);
+    while (!go.load(std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    for (auto& c : clients) {
+        if (c.spec.sender) c.pacer.init(opt.rate, w.warm_ns, rng);
+    }
+
+    std::vector<epoll_event> events(256);
+    Message msg;
+    char frame[MAX_FRAME_LEN + 4];
+    uint64_t window_deliveries = 0;  // Expected deliveries, to end the drain early
+
+    for (;;) {
+        uint64_t now = Clock::monotonic_ns();
+        if (now >= w.drain_ns || (now >= w.stop_ns && stats.delivered >= window_deliveries)) break;
+
+        if (now < w.stop_ns) {
+            for (auto& c : clients) {
+                if (!c.spec.sender || c.closed) continue;
+                while (c.pacer.next_ns <= now && c.pacer.next_ns < w.stop_ns) {
+                    uint64_t send_ns = Clock::monotonic_ns();
+                    std::snprintf(msg.user, MAX_USERNAME_LEN, "bench");
+                    fill_text(msg.text, sizes.sample(rng), send_ns);
+                    size_t n = encode_frame(msg, frame, sizeof(frame));
+                    c.out.append(frame, n);
+                    if (in_window(w, send_ns)) {
+                        stats.sent++;
+                        stats.expected += static_cast<uint64_t>(members[static_cast<size_t>(c.spec.room)]);
+                    }
+                    c.pacer.next_ns += c.pacer.interval_ns;
+                }
+                if (!c.out.empty() && !flush_out(c)) {
+                    c.closed = true;
+                    stats.errors++;
+                }
+            }
+        }
+
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), 1);
+        for (int i = 0; i < n; ++i) {
+            TcpClient& c = clients[events[i].data.u64];
+            if (!c.closed && !drain_in(c, w, stats)) {
+                c.closed = true;
+                stats.errors++;
+                epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+            }
+        }
+        window_deliveries = stats.expected;
+    }
+
+    for (auto& c : clients) {
+        if (c.fd >= 0) close(c.fd);
+    }
+    close(ep);
+}
+
+// ===== Shared memory =====
+
+std::string shm_room_name(int room) {
+    return "/os_chat_bench_" + std::to_string(getpid()) + "_" + std::to_string(room);
+}
+
+std::string shm_mutex_name(int room) {
+    return "/os_chat_bench_mx_" + std::to_string(getpid()) + "_" + std::to_string(room);
+}
+
+void shm_worker(const Options& opt, const std::vector<ClientSpec>& specs, const std::vector<int>& members,
+                std::atomic<int>& ready, const std::atomic<bool>& go, const Window& w, WorkerStats& stats, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    SizeDist sizes;
+    sizes.parse(opt.size);
+
+    std::vector<std::unique_ptr<ShmRing>> rings;
+    std::vector<Pacer> pacers(specs.size());
+    for (const auto& spec : specs) {
+        rings.push_back(std::make_unique<ShmRing>());
+        if (!rings.back()->open(shm_room_name(spec.room), shm_mutex_name(spec.room))) stats.errors++;
+    }
+    ready.fetch_add(1);
+    while (!go.load(std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (size_t i = 0; i < specs.size(); ++i) {
+        if (specs[i].sender) pacers[i].init(opt.rate, w.warm_ns, rng);
+    }
+
+    Message msg;
+    for (;;) {
+        uint64_t now = Clock::monotonic_ns();
+        if (now >= w.drain_ns || (now >= w.stop_ns && stats.delivered >= stats.expected)) break;
+
+        bool idle = true;
+        for (size_t i = 0; i < specs.size(); ++i) {
+            ShmRing& ring = *rings[i];
+            if (!ring.is_open()) continue;
+            if (specs[i].sender) {
+                Pacer& p = pacers[i];
+                while (p.next_ns <= now && p.next_ns < w.stop_ns) {
+                    uint64_t send_ns = Clock::monotonic_ns();
+                    Message out;
+                    std::strcpy(out.user, "bench");
+                    fill_text(out.text, sizes.sample(rng), send_ns);
+                    if (!ring.write(out)) stats.errors++;
+                    if (in_window(w, send_ns)) {
+                        stats.sent++;
+                        stats.expected += static_cast<uint64_t>(members[static_cast<size_t>(specs[i].room)]);
+                    }
+                    p.next_ns += p.interval_ns;
+                    idle = false;
+                }
+            }
+            while (ring.read(msg, 0)) {
+                uint64_t recv_ns = Clock::monotonic_ns();
+                uint64_t sent_ns = parse_send_ns(msg.text, msg.text + strnlen(msg.text, MAX_MESSAGE_LEN));
+                if (sent_ns && in_window(w, sent_ns)) {
+                    stats.delivered++;
+                    stats.latency.record(recv_ns - sent_ns);
+                }
+                idle = false;
+            }
+        }
+        if (idle) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    for (auto& ring : rings) stats.errors += ring->overruns();
+}
+
+// ===== Process accounting =====
+
+// utime + stime in microseconds (/proc/<pid>/stat fields 14 and 15)
+uint64_t process_cpu_us(pid_t pid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+    FILE* f = std::fopen(path, "r");
+    if (!f) return 0;
+    char buf[1024];
+    size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+    std::fclose(f);
+    buf[n] = '\0';
+    const char* p = std::strrchr(buf, ')');
+    if (!p) return 0;
+    unsigned long long utime = 0, stime = 0;
+    // After ')' come state (field 3) ... utime is field 14
+    if (std::sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) return 0;
+    return (utime + stime) * 1000000ULL / static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+}
+
+uint64_t self_cpu_us() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return static_cast<uint64_t>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000ULL +
+           static_cast<uint64_t>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+// A "Vm...:" line of /proc/<pid>/status in kB
+uint64_t process_status_kb(pid_t pid, const char* key) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid));
+    FILE* f = std::fopen(path, "r");
+    if (!f) return 0;
+    char line[256];
+    uint64_t kb = 0;
+    size_t key_len = std::strlen(key);
+    while (std::fgets(line, sizeof(line), f)) {
+        if (std::strncmp(line, key, key_len) == 0) {
+            kb = std::strtoull(line + key_len, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(f);
+    return kb;
+}
+
+int free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+pid_t spawn_server(const Options& opt) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        std::string port = std::to_string(opt.port);
+        execl(opt.spawn.c_str(), opt.spawn.c_str(), "--port", port.c_str(), "--log-level", "warn",
+              static_cast<char*>(nullptr));
+        perror("exec");
+        _exit(127);
+    }
+    // Wait for the listener
+    for (int i = 0; i < 100 && pid > 0; ++i) {
+        int fd = connect_tcp(opt);
+        if (fd >= 0) {
+            close(fd);
+            return pid;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (pid > 0) kill(pid, SIGKILL);
+    return -1;
+}
+
+void raise_fd_limit(int needed) {
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return;
+    rlim_t want = static_cast<rlim_t>(needed);
+    if (rl.rlim_cur >= want) return;
+    rl.rlim_cur = std::min(want, rl.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+void usage() {
+    std::cerr << "Usage: chat_bench [--mode tcp|shm] [--host H] [--port P] [--spawn PATH] [--server-pid PID]\n"
+                 "                  [--clients N] [--rooms N] [--layout even|zipf] [--senders FRACTION]\n"
+                 "                  [--rate MSG/S] [--size fixed:N|uniform:A-B|exp:MEAN] [--duration S]\n"
+                 "                  [--warmup S] [--threads N] [--seed N] [--label STR] [--quiet]"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char* name) { return strcmp(argv[i], name) == 0 && i + 1 < argc; };
+        if (arg("--mode")) opt.mode = argv[++i];
+        else if (arg("--host")) opt.host = argv[++i];
+        else if (arg("--port")) opt.port = std::atoi(argv[++i]);
+        else if (arg("--spawn")) opt.spawn = argv[++i];
+        else if (arg("--server-pid")) opt.server_pid = static_cast<pid_t>(std::atoi(argv[++i]));
+        else if (arg("--clients")) opt.clients = std::atoi(argv[++i]);
+        else if (arg("--rooms")) opt.rooms = std::atoi(argv[++i]);
+        else if (arg("--layout")) opt.layout = argv[++i];
+        else if (arg("--senders")) opt.senders = std::atof(argv[++i]);
+        else if (arg("--rate")) opt.rate = std::atof(argv[++i]);
+        else if (arg("--size")) opt.size = argv[++i];
+        else if (arg("--duration")) opt.duration = std::atof(argv[++i]);
+        else if (arg("--warmup")) opt.warmup = std::atof(argv[++i]);
+        else if (arg("--threads")) opt.threads = std::atoi(argv[++i]);
+        else if (arg("--seed")) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg("--label")) opt.label = argv[++i];
+        else if (strcmp(argv[i], "--quiet") == 0) opt.quiet = true;
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    SizeDist sizes;
+    bool tcp = opt.mode == "tcp";
+    if ((!tcp && opt.mode != "shm") || (opt.layout != "even" && opt.layout != "zipf") || !sizes.parse(opt.size) ||
+        opt.clients <= 0 || opt.rooms <= 0 || opt.rooms > opt.clients || opt.senders <= 0 || opt.senders > 1 ||
+        opt.rate <= 0 || opt.duration <= 0 || opt.warmup < 0) {
+        usage();
+        return 1;
+    }
+    if (opt.threads <= 0) {
+        opt.threads = static_cast<int>(std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2)));
+    }
+    opt.threads = std::min(opt.threads, opt.clients);
+    raise_fd_limit(opt.clients * (tcp ? 1 : 2) + 64);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    pid_t spawned = 0;
+    if (tcp) {
+        if (opt.port == 0) opt.port = opt.spawn.empty() ? DEFAULT_PORT : free_port();
+        if (!opt.spawn.empty()) {
+            spawned = spawn_server(opt);
+            if (spawned < 0) {
+                std::cerr << "chat_bench: could not start " << opt.spawn << std::endl;
+                return 1;
+            }
+            opt.server_pid = spawned;
+        }
+    } else {
+        for (int r = 0; r < opt.rooms; ++r) ShmRing::unlink(shm_room_name(r), shm_mutex_name(r));
+    }
+
+    std::vector<int> members;
+    std::vector<ClientSpec> specs = plan_clients(opt, members);
+    int sender_count = 0;
+    for (const auto& s : specs) sender_count += s.sender;
+
+    // Deal clients round-robin so every thread gets a mix of rooms and roles
+    std::vector<std::vector<ClientSpec>> shards(static_cast<size_t>(opt.threads));
+    for (size_t i = 0; i < specs.size(); ++i) shards[i % shards.size()].push_back(specs[i]);
+    std::vector<std::vector<TcpClient>> tcp_shards(shards.size());
+    for (size_t t = 0; t < shards.size() && tcp; ++t) {
+        for (const auto& s : shards[t]) {
+            TcpClient c;
+            c.spec = s;
+            tcp_shards[t].push_back(std::move(c));
+        }
+    }
+
+    // Workers connect (or map) their clients, then wait for the timeline
+    std::atomic<int> ready(0);
+    std::atomic<bool> go(false);
+    Window window{};
+    std::vector<WorkerStats> stats(shards.size());
+    std::vector<std::thread> workers;
+    uint64_t connect_start = Clock::monotonic_ns();
+    for (size_t t = 0; t < shards.size(); ++t) {
+        uint64_t seed = opt.seed * 1000003ULL + t;
+        workers.emplace_back([&, t, seed]() {
+            if (tcp) {
+                tcp_worker(opt, tcp_shards[t], members, ready, go, window, stats[t], seed);
+            } else {
+                shm_worker(opt, shards[t], members, ready, go, window, stats[t], seed);
+            }
+        });
+    }
+    while (ready.load() < static_cast<int>(workers.size())) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    double connect_s = (Clock::monotonic_ns() - connect_start) / 1e9;
+
+    // Give the server a moment to register the last joins, then:
+    // warmup (unmeasured), window (measured), drain (late deliveries only)
+    std::this_thread::sleep_for(std::chrono::milliseconds(tcp ? 500 : 0));
+    window.warm_ns = Clock::monotonic_ns();
+    window.start_ns = window.warm_ns + static_cast<uint64_t>(opt.warmup * 1e9);
+    window.stop_ns = window.start_ns + static_cast<uint64_t>(opt.duration * 1e9);
+    window.drain_ns = window.stop_ns + 2000000000ULL;
+    go.store(true, std::memory_order_release);
+
+    sleep_until(window.start_ns);
+    uint64_t client_cpu_start = self_cpu_us();
+    uint64_t server_cpu_start = opt.server_pid ? process_cpu_us(opt.server_pid) : 0;
+    sleep_until(window.stop_ns);
+    uint64_t client_cpu = self_cpu_us() - client_cpu_start;
+    uint64_t server_cpu = opt.server_pid ? process_cpu_us(opt.server_pid) - server_cpu_start : 0;
+    uint64_t server_rss_kb = opt.server_pid ? process_status_kb(opt.server_pid, "VmRSS:") : 0;
+    uint64_t server_hwm_kb = opt.server_pid ? process_status_kb(opt.server_pid, "VmHWM:") : 0;
+
+    for (auto& w : workers) w.join();
+    uint64_t client_hwm_kb = process_status_kb(getpid(), "VmHWM:");
+
+    if (spawned > 0) {
+        kill(spawned, SIGTERM);
+        waitpid(spawned, nullptr, 0);
+    }
+    if (!tcp) {
+        for (int r = 0; r < opt.rooms; ++r) ShmRing::unlink(shm_room_name(r), shm_mutex_name(r));
+    }
+
+    WorkerStats total;
+    for (const auto& s : stats) {
+        total.sent += s.sent;
+        total.expected += s.expected;
+        total.delivered += s.delivered;
+        total.errors += s.errors;
+        total.latency.merge(s.latency);
+    }
+
+    const HdrHistogram& lat = total.latency;
+    auto us = [&](double p) { return lat.value_at_percentile(p) / 1000.0; };
+    double per_msg = total.sent ? 1.0 / static_cast<double>(total.sent) : 0.0;
+    uint64_t lost = total.expected > total.delivered ? total.expected - total.delivered : 0;
+
+    // One line of JSON, keys stable across versions
+    std::printf("{\"bench\":\"chat_bench\",\"label\":\"%s\",\"mode\":\"%s\",\"clients\":%d,\"rooms\":%d,"
+                "\"layout\":\"%s\",\"senders\":%d,\"rate_per_sender\":%.3f,\"size\":\"%s\",\"threads\":%d,"
+                "\"duration_s\":%.3f,\"connect_s\":%.3f,\"sent\":%llu,\"expected\":%llu,\"delivered\":%llu,"
+                "\"lost\":%llu,\"errors\":%llu,\"send_rate\":%.1f,\"delivery_rate\":%.1f,"
+                "\"latency_us\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f,\"mean\":%.1f},"
+                "\"client_cpu_us_per_msg\":%.3f,\"server_cpu_us_per_msg\":%.3f,"
+                "\"client_hwm_kb\":%llu,\"server_rss_kb\":%llu,\"server_hwm_kb\":%llu}\n",
+                opt.label.c_str(), opt.mode.c_str(), opt.clients, opt.rooms, opt.layout.c_str(), sender_count,
+                opt.rate, opt.size.c_str(), opt.threads, opt.duration, connect_s,
+                static_cast<unsigned long long>(total.sent), static_cast<unsigned long long>(total.expected),
+                static_cast<unsigned long long>(total.delivered), static_cast<unsigned long long>(lost),
+                static_cast<unsigned long long>(total.errors), total.sent / opt.duration,
+                total.delivered / opt.duration, us(50), us(90), us(99), us(99.9), lat.max() / 1000.0,
+                lat.mean() / 1000.0, client_cpu * per_msg, server_cpu * per_msg,
+                static_cast<unsigned long long>(client_hwm_kb), static_cast<unsigned long long>(server_rss_kb),
+                static_cast<unsigned long long>(server_hwm_kb));
+    std::fflush(stdout);
+
+    if (!opt.quiet) {
+        std::cerr << opt.mode << ": " << opt.clients << " clients (" << sender_count << " senders) in "
+                  << opt.rooms << " rooms, " << total.sent / opt.duration << " msg/s in, "
+                  << total.delivered / opt.duration << " deliveries/s out" << std::endl;
+        std::cerr << "  latency us: p50 " << us(50) << "  p99 " << us(99) << "  p99.9 " << us(99.9) << "  max "
+                  << lat.max() / 1000.0 << std::endl;
+        std::cerr << "  lost " << lost << " of " << total.expected << ", errors " << total.errors << std::endl;
+        std::cerr << "  cpu us/msg: client " << client_cpu * per_msg;
+        if (opt.server_pid) std::cerr << ", server " << server_cpu * per_msg << "  (server rss " << server_rss_kb << " kB)";
+        std::cerr << std::endl;
+    }
+    return 0;
+}
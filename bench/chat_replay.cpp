@@ -0,0 +1,381 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Replay a capture (chat_server --capture FILE) against a server
+ *
+ * Usage: chat_replay FILE [--host H] [--port P] [--spawn PATH]
+ *                    [--speed N|max] [--label STR] [--quiet]
+ *
+ * Every captured connection gets its own TCP connection, opened at its
+ * HELLO and closed after its BYE once its own echoes are back. Frames are
+ * sent at their captured offsets divided by the speed (1 = real time,
+ * max = back to back, order kept). Hellos go without their offer of
+ * compression or their request for ids, since replies are read as plain
+ * frames and matched by sender name.
+ *
+ * Latency is send -> own echo: the server fans a message back to its
+ * sender too, so each connection matches incoming frames from its own user
+ * against the texts it sent. Prints one JSON line to stdout and a summary
+ * to stderr unless --quiet.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../shared/capture.h"
+#include "../shared/common.h"
+#include "../shared/hdr_histogram.h"
+
+using namespace ChatUtils;
+
+namespace {
+
+struct Options {
+    std::string file;
+    std::string host = "127.0.0.1";
+    int port = 0;
+    std::string spawn;
+    double speed = 1.0;  // 0: as fast as possible
+    std::string label;
+    bool quiet = false;
+};
+
+struct Pending {
+    uint64_t sent_ns;
+    size_t text_hash;
+};
+
+struct Conn {
+    int fd = -1;
+    std::string user;
+    std::deque<Pending> pending;  // Sent, echo not seen yet
+    std::vector<char> in = std::vector<char>(64 * 1024);
+    size_t in_len = 0;
+    std::string out;
+    uint64_t bye_ns = 0;  // Captured BYE reached; close once echoes are in
+};
+
+struct Stats {
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t echoed = 0;
+    uint64_t unmatched = 0;  // Sends whose echo never came
+    uint64_t errors = 0;
+    HdrHistogram latency;
+};
+
+size_t text_hash(const Message& msg) {
+    return std::hash<std::string_view>()(std::string_view(msg.text, strnlen(msg.text, MAX_MESSAGE_LEN)));
+}
+
+int connect_tcp(const Options& opt) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(opt.port));
+    inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+void append_frame(std::string& out, const std::string& payload) {
+    uint32_t len = htonl(static_cast<uint32_t>(payload.size() + 1));
+    out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    out += payload;
+    out += MESSAGE_SEPARATOR;
+}
+
+bool flush_out(Conn& c) {
+    size_t off = 0;
+    while (off < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + off, c.out.size() - off, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    c.out.erase(0, off);
+    return true;
+}
+
+bool drain_in(Conn& c, Stats& stats) {
+    Message msg;
+    for (;;) {
+        ssize_t n = recv(c.fd, c.in.data() + c.in_len, c.in.size() - c.in_len, MSG_DONTWAIT);
+        if (n == 0) return false;
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        uint64_t now = Clock::monotonic_ns();
+        c.in_len += static_cast<size_t>(n);
+
+        size_t off = 0;
+        while (c.in_len - off >= 4) {
+            uint32_t len;
+            std::memcpy(&len, c.in.data() + off, 4);
+            len = ntohl(len);
+            if (len > MAX_FRAME_LEN) return false;
+            if (c.in_len - off < 4 + len) break;
+            stats.received++;
+
+            // Ours? Match the oldest pending text; skip sends the server dropped
+            if (Message::parse(c.in.data() + off + 4, len, msg) && c.user == msg.user) {
+                size_t h = text_hash(msg);
+                auto it = std::find_if(c.pending.begin(), c.pending.end(),
+                                       [h](const Pending& p) { return p.text_hash == h; });
+                if (it != c.pending.end()) {
+                    stats.echoed++;
+                    stats.latency.record(now - it->sent_ns);
+                    c.pending.erase(c.pending.begin(), it + 1);
+                }
+            }
+            off += 4 + len;
+        }
+        std::memmove(c.in.data(), c.in.data() + off, c.in_len - off);
+        c.in_len -= off;
+    }
+}
+
+pid_t spawn_server(const Options& opt) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        std::string port = std::to_string(opt.port);
+        execl(opt.spawn.c_str(), opt.spawn.c_str(), "--port", port.c_str(), "--log-level", "warn",
+              static_cast<char*>(nullptr));
+        perror("exec");
+        _exit(127);
+    }
+    for (int i = 0; i < 100 && pid > 0; ++i) {
+        int fd = connect_tcp(opt);
+        if (fd >= 0) {
+            close(fd);
+            return pid;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if (pid > 0) kill(pid, SIGKILL);
+    return -1;
+}
+
+int free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+void usage() {
+    std::cerr << "Usage: chat_replay FILE [--host H] [--port P] [--spawn PATH] [--speed N|max] [--label STR] [--quiet]"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        auto arg = [&](const char* name) { return strcmp(argv[i], name) == 0 && i + 1 < argc; };
+        if (arg("--host")) opt.host = argv[++i];
+        else if (arg("--port")) opt.port = std::atoi(argv[++i]);
+        else if (arg("--spawn")) opt.spawn = argv[++i];
+        else if (arg("--speed")) {
+            ++i;
+            opt.speed = strcmp(argv[i], "max") == 0 ? 0.0 : std::atof(argv[i]);
+            if (opt.speed < 0 || (opt.speed == 0 && strcmp(argv[i], "max") != 0)) {
+                usage();
+                return 1;
+            }
+        } else if (arg("--label")) opt.label = argv[++i];
+        else if (strcmp(argv[i], "--quiet") == 0) opt.quiet = true;
+        else if (argv[i][0] != '-' && opt.file.empty()) opt.file = argv[i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (opt.file.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::vector<CaptureRecord> records;
+    if (!read_capture(opt.file, records)) {
+        std::cerr << "chat_replay: " << opt.file << " is not a capture" << std::endl;
+        return 1;
+    }
+
+    size_t connections = 0;
+    for (const auto& r : records) connections += r.kind == CaptureRecord::HELLO;
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < connections + 64) {
+        rl.rlim_cur = std::min<rlim_t>(connections + 64, rl.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    pid_t spawned = 0;
+    if (opt.port == 0) opt.port = opt.spawn.empty() ? DEFAULT_PORT : free_port();
+    if (!opt.spawn.empty()) {
+        spawned = spawn_server(opt);
+        if (spawned < 0) {
+            std::cerr << "chat_replay: could not start " << opt.spawn << std::endl;
+            return 1;
+        }
+    }
+
+    std::unordered_map<uint32_t, Conn> conns;
+    Stats stats;
+    int ep = epoll_create1(0);
+    std::vector<epoll_event> events(256);
+    Message msg;
+
+    auto drop = [&](uint32_t id) {
+        auto it = conns.find(id);
+        if (it == conns.end()) return;
+        stats.unmatched += it->second.pending.size();
+        epoll_ctl(ep, EPOLL_CTL_DEL, it->second.fd, nullptr);
+        close(it->second.fd);
+        conns.erase(it);
+    };
+
+    // Hang up connections past their BYE once their echoes are in (or 1s later)
+    auto reap = [&] {
+        uint64_t now = Clock::monotonic_ns();
+        std::vector<uint32_t> done;
+        for (auto& [id, c] : conns) {
+            if (c.bye_ns && c.out.empty() && (c.pending.empty() || now - c.bye_ns > 1000000000ULL)) done.push_back(id);
+        }
+        for (uint32_t id : done) drop(id);
+    };
+
+    auto poll_once = [&](int timeout_ms) {
+        for (auto& [id, c] : conns) {
+            if (!c.out.empty() && !flush_out(c)) stats.errors++;
+        }
+        int n = epoll_wait(ep, events.data(), static_cast<int>(events.size()), timeout_ms);
+        for (int i = 0; i < n; ++i) {
+            uint32_t id = static_cast<uint32_t>(events[i].data.u64);
+            auto it = conns.find(id);
+            if (it != conns.end() && !drain_in(it->second, stats)) {
+                stats.errors++;
+                drop(id);
+            }
+        }
+        reap();
+    };
+
+    uint64_t start = Clock::monotonic_ns();
+    for (const CaptureRecord& r : records) {
+        // Wait for the record's (scaled) offset, servicing sockets meanwhile
+        if (opt.speed > 0) {
+            uint64_t due = start + static_cast<uint64_t>(static_cast<double>(r.ns) / opt.speed);
+            for (uint64_t now = Clock::monotonic_ns(); now < due; now = Clock::monotonic_ns()) {
+                poll_once(static_cast<int>(std::min<uint64_t>((due - now) / 1000000, 10)));
+            }
+        }
+
+        if (r.kind == CaptureRecord::HELLO) {
+            int fd = connect_tcp(opt);
+            if (fd < 0 || !Message::parse(r.payload.data(), r.payload.size(), msg)) {
+                if (fd >= 0) close(fd);
+                stats.errors++;
+                continue;
+            }
+            Conn& c = conns[r.connection];
+            c.fd = fd;
+            c.user = msg.user;
+            append_frame(c.out, replay_hello(r.payload));
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = r.connection;
+            epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+        } else if (r.kind == CaptureRecord::FRAME) {
+            auto it = conns.find(r.connection);
+            if (it == conns.end()) continue;  // HELLO was dropped from the capture
+            Conn& c = it->second;
+            Message::parse(r.payload.data(), r.payload.size(), msg);
+            c.pending.push_back(Pending{Clock::monotonic_ns(), text_hash(msg)});
+            append_frame(c.out, r.payload);
+            stats.sent++;
+            if (opt.speed == 0 && c.out.size() > 64 * 1024) poll_once(0);
+        } else if (r.kind == CaptureRecord::BYE) {
+            auto it = conns.find(r.connection);
+            if (it != conns.end()) it->second.bye_ns = Clock::monotonic_ns();
+        }
+    }
+    uint64_t send_end = Clock::monotonic_ns();
+
+    // Wait up to 2s for the remaining echoes
+    auto outstanding = [&] {
+        size_t n = 0;
+        for (auto& [id, c] : conns) n += c.pending.size() + c.out.size();
+        return n;
+    };
+    while (outstanding() > 0 && Clock::monotonic_ns() - send_end < 2000000000ULL) poll_once(1);
+    double elapsed = (Clock::monotonic_ns() - start) / 1e9;
+    double sending = std::max((send_end - start) / 1e9, 1e-9);
+
+    for (auto& [id, c] : conns) {
+        stats.unmatched += c.pending.size();
+        close(c.fd);
+    }
+    close(ep);
+    if (spawned > 0) {
+        kill(spawned, SIGTERM);
+        waitpid(spawned, nullptr, 0);
+    }
+
+    const HdrHistogram& lat = stats.latency;
+    auto us = [&](double p) { return lat.value_at_percentile(p) / 1000.0; };
+    double captured_s = records.empty() ? 0.0 : records.back().ns / 1e9;
+    std::printf("{\"bench\":\"chat_replay\",\"label\":\"%s\",\"file\":\"%s\",\"speed\":%s,\"connections\":%zu,"
+                "\"captured_s\":%.3f,\"elapsed_s\":%.3f,\"sent\":%llu,\"received\":%llu,\"echoed\":%llu,"
+                "\"unmatched\":%llu,\"errors\":%llu,\"send_rate\":%.1f,\"receive_rate\":%.1f,"
+                "\"latency_us\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f,\"mean\":%.1f}}\n",
+                opt.label.c_str(), opt.file.c_str(), opt.speed > 0 ? std::to_string(opt.speed).c_str() : "\"max\"",
+                connections, captured_s, elapsed, static_cast<unsigned long long>(stats.sent),
+                static_cast<unsigned long long>(stats.received), static_cast<unsigned long long>(stats.echoed),
+                static_cast<unsigned long long>(stats.unmatched), static_cast<unsigned long long>(stats.errors),
+                stats.sent / sending, stats.received / elapsed,
+                us(50), us(90), us(99), us(99.9), lat.max() / 1000.0, lat.mean() / 1000.0);
+    std::fflush(stdout);
+
+    if (!opt.quiet) {
+        std::cerr << "replayed " << stats.sent << " frames over " << connections << " connections in " << elapsed
+                  << " s (captured " << captured_s << " s)" << std::endl;
+        std::cerr << "  " << stats.sent / sending << " frames/s in, " << stats.received / elapsed
+                  << " frames/s out, " << stats.echoed << " echoes matched, " << stats.unmatched << " missing"
+                  << std::endl;
+        std::cerr << "  latency us: p50 " << us(50) << "  p99 " << us(99) << "  p99.9 " << us(99.9) << "  max "
+                  << lat.max() / 1000.0 << std::endl;
+    }
+    return 0;
+}
@@ -10,9 +10,14 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QApplication>
+#include <QScrollBar>
+#include <QDir>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget* parent)
-    : QMainWindow(parent), is_connected_(false), current_mode_(0) {
+    : QMainWindow(parent), is_connected_(false), resuming_(false), current_mode_(0) {
     setWindowTitle("OS Chat Client - Socket & Shared Memory");
     setGeometry(100, 100, 800, 600);
 
@@ -21,13 +26,14 @@ MainWindow::MainWindow(QWidget* parent)
 
     // Connect signals
     connect(socket_client_.get(), &SocketClient::connected, this, &MainWindow::on_connected);
+    connect(socket_client_.get(), &SocketClient::reconnecting, this, &MainWindow::on_reconnecting);
     connect(socket_client_.get(), &SocketClient::disconnected, this, &MainWindow::on_disconnected);
-    connect(socket_client_.get(), &SocketClient::message_received, this, &MainWindow::on_message_received);
+    connect(socket_client_.get(), &SocketClient::messages_received, this, &MainWindow::on_messages_received);
     connect(socket_client_.get(), QOverload<QString>::of(&SocketClient::error_occurred), this, &MainWindow::on_error);
 
     connect(shm_client_.get(), &ShmClient::joined, this, &MainWindow::on_connected);
     connect(shm_client_.get(), &ShmClient::left, this, &MainWindow::on_disconnected);
-    connect(shm_client_.get(), &ShmClient::message_received, this, &MainWindow::on_message_received);
+    connect(shm_client_.get(), &ShmClient::messages_received, this, &MainWindow::on_messages_received);
     connect(shm_client_.get(), QOverload<QString>::of(&ShmClient::error_occurred), this, &MainWindow::on_error);
 
     setup_ui();
@@ -84,6 +90,12 @@ void MainWindow::setup_ui() {
     username_input_ = new QLineEdit();
     username_input_->setPlaceholderText("Enter your username");
     user_layout->addWidget(username_input_);
+    user_layout->addWidget(new QLabel("Scrollback:"));
+    scrollback_input_ = new QSpinBox();
+    scrollback_input_->setRange(100, 1000000);
+    scrollback_input_->setSingleStep(1000);
+    scrollback_input_->setValue(MessageListModel::kDefaultCapacity);
+    user_layout->addWidget(scrollback_input_);
     user_layout->addStretch();
     settings_layout->addLayout(user_layout);
 
@@ -98,9 +110,18 @@ void MainWindow::setup_ui() {
     main_layout->addWidget(settings_group);
 
     // ===== Chat Area =====
-    messages_display_ = new QTextEdit();
-    messages_display_->setReadOnly(true);
-    messages_display_->setStyleSheet("QTextEdit { background-color: #1e1e1e; color: #e0e0e0; font-family: monospace; font-size: 11pt; }");
+    // Only visible rows are laid out; every row is one line (full text in the tooltip)
+    messages_model_ = new MessageListModel(scrollback_input_->value(), this);
+    messages_display_ = new QListView();
+    messages_display_->setModel(messages_model_);
+    messages_display_->setUniformItemSizes(true);
+    messages_display_->setWordWrap(false);
+    messages_display_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    messages_display_->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    messages_display_->setStyleSheet("QListView { background-color: #1e1e1e; color: #e0e0e0; font-family: monospace; font-size: 11pt; }");
+    connect(scrollback_input_, QOverload<int>::of(&QSpinBox::valueChanged), messages_model_,
+            &MessageListModel::set_capacity);
+    connect(messages_display_->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::on_scrolled);
     main_layout->addWidget(new QLabel("Messages:"));
     main_layout->addWidget(messages_display_);
 
@@ -187,8 +208,31 @@ void MainWindow::on_send_button_clicked() {
     QString text = message_input_->text().trimmed();
     if (text.isEmpty()) return;
 
+    // "/msg <user> <text>" sends a direct message and "/filter a, ^b" sets
+    // the subscription filter ("/filter" alone clears it); socket mode only
+    if (text == "/filter" || text.startsWith("/filter ")) {
+        if (current_mode_ != 0 || !socket_client_->set_filter(text.mid(7).trimmed())) {
+            on_error("Filters need a socket connection");
+            return;
+        }
+        message_input_->clear();
+        return;
+    }
+
+    QString from = username_input_->text();
     bool success = false;
-    if (current_mode_ == 0) {
+    if (text.startsWith("/msg ")) {
+        QString rest = text.mid(5).trimmed();
+        int space = rest.indexOf(' ');
+        if (space <= 0 || current_mode_ != 0) {
+            on_error(current_mode_ != 0 ? "Direct messages need socket mode" : "Usage: /msg <user> <text>");
+            return;
+        }
+        QString to = rest.left(space);
+        text = rest.mid(space + 1).trimmed();
+        success = socket_client_->send_direct(to, text);
+        from += " -> " + to;
+    } else if (current_mode_ == 0) {
         success = socket_client_->send_message(text);
     } else {
         success = shm_client_->send_message(text);
@@ -196,35 +240,59 @@ void MainWindow::on_send_button_clicked() {
 
     if (success) {
         // Show our message immediately
-        append_message(username_input_->text(), QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ssZ"), text);
+        append_message(from, QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ssZ"), text);
         message_input_->clear();
     } else {
         on_error("Failed to send message");
     }
 }
 
-void MainWindow::on_message_received(QString user, QString timestamp, QString text) {
-    append_message(user, timestamp, text);
+void MainWindow::on_messages_received(const QVector<ChatMessage>& batch) {
+    // One model insert for the whole batch
+    bool follow = at_bottom() && messages_model_->at_tail();
+    messages_model_->append(batch);
+    if (follow) messages_display_->scrollToBottom();
 }
 
 void MainWindow::on_connected() {
     is_connected_ = true;
     status_label_->setText("Connected");
     status_label_->setStyleSheet("QLabel { color: green; font-weight: bold; }");
-    connect_button_->setText("Disconnect");
     message_input_->setEnabled(true);
     send_button_->setEnabled(true);
+    if (resuming_) {
+        // Same session and history file; the server replayed what we missed
+        resuming_ = false;
+        show_notice("[System]", "Reconnected");
+        return;
+    }
+    connect_button_->setText("Disconnect");
     mode_combo_->setEnabled(false);
     username_input_->setEnabled(false);
     ip_input_->setEnabled(false);
     port_input_->setEnabled(false);
     shm_name_input_->setEnabled(false);
-    messages_display_->clear();
-    append_message("[System]", "", "Connected successfully");
+    if (!messages_model_->attach_history(history_path())) {
+        show_notice("[Error]", "History file unavailable; scrollback is in memory only");
+    }
+    messages_display_->scrollToBottom();
+    show_notice("[System]", "Connected successfully");
+}
+
+void MainWindow::on_reconnecting(int attempt, int delay_ms) {
+    status_label_->setText(QString("Reconnecting (attempt %1)...").arg(attempt));
+    status_label_->setStyleSheet("QLabel { color: orange; font-weight: bold; }");
+    message_input_->setEnabled(false);
+    send_button_->setEnabled(false);
+    if (!resuming_) {
+        resuming_ = true;
+        show_notice("[System]", QString("Connection lost; reconnecting in %1 ms").arg(delay_ms));
+    }
 }
 
 void MainWindow::on_disconnected() {
     is_connected_ = false;
+    resuming_ = false;
     status_label_->setText("Disconnected");
     status_label_->setStyleSheet("QLabel { color: red; font-weight: bold; }");
     connect_button_->setText("Connect");
@@ -233,19 +301,61 @@ void MainWindow::on_disconnected() {
     mode_combo_->setEnabled(true);
     username_input_->setEnabled(true);
     update_ui_for_mode();
-    append_message("[System]", "", "Disconnected");
+    show_notice("[System]", "Disconnected");
 }
 
 void MainWindow::on_error(QString error) {
-    append_message("[Error]", "", error);
+    show_notice("[Error]", error);
 }
 
 void MainWindow::append_message(const QString& user, const QString& timestamp, const QString& text) {
-    QString formatted;
-    if (!timestamp.isEmpty()) {
-        formatted = QString("[%1] %2: %3").arg(timestamp, user, text);
-    } else {
-        formatted = QString("%1: %2").arg(user, text);
+    bool follow = at_bottom() && messages_model_->at_tail();
+    messages_model_->append(user, timestamp, text);
+    if (follow) messages_display_->scrollToBottom();
+}
+
+void MainWindow::show_notice(const QString& user, const QString& text) {
+    bool follow = at_bottom() && messages_model_->at_tail();
+    messages_model_->append_notice(user, text);
+    if (follow) messages_display_->scrollToBottom();
+}
+
+bool MainWindow::at_bottom() const {
+    // Keep following new messages unless the user scrolled up to read
+    const QScrollBar* bar = messages_display_->verticalScrollBar();
+    return bar->value() >= bar->maximum();
+}
+
+void MainWindow::on_scrolled(int value) {
+    // Slide the model's window over the history file at either end, keeping
+    // the row that was on top in place
+    const QScrollBar* bar = messages_display_->verticalScrollBar();
+    int top = messages_display_->indexAt(QPoint(0, 0)).row();
+    if (value <= bar->minimum()) {
+        int added = messages_model_->load_older(MessageListModel::kPageRows);
+        if (added > 0) {
+            messages_display_->scrollTo(messages_model_->index(std::max(0, top) + added, 0),
+                                        QAbstractItemView::PositionAtTop);
+        }
+    } else if (value >= bar->maximum() && !messages_model_->at_tail()) {
+        int before = messages_model_->rowCount();
+        int added = messages_model_->load_newer(MessageListModel::kPageRows);
+        int dropped = before + added - messages_model_->rowCount();
+        if (added > 0 && dropped > 0) {
+            messages_display_->scrollTo(messages_model_->index(std::max(0, top - dropped), 0),
+                                        QAbstractItemView::PositionAtTop);
+        }
     }
-    messages_display_->append(formatted);
+}
+
+std::string MainWindow::history_path() const {
+    // One history per endpoint and user, under the per-user app data directory
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (dir.isEmpty() || !QDir().mkpath(dir + "/history")) return std::string();
+
+    QString key = current_mode_ == 0
+        ? QString("tcp_%1_%2_%3").arg(ip_input_->text().trimmed()).arg(port_input_->value()).arg(username_input_->text().trimmed())
+        : QString("shm_%1_%2").arg(shm_name_input_->text().trimmed(), username_input_->text().trimmed());
+    key.replace(QRegularExpression("[^A-Za-z0-9_.-]"), "_");
+    return QDir(dir + "/history").filePath(key).toStdString();
 }
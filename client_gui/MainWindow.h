@@ -9,13 +9,15 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTextEdit>
+#include <QListView>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QComboBox>
 #include <QLabel>
 #include <QSpinBox>
 #include <memory>
+#include <string>
+#include "MessageListModel.h"
 #include "SocketClient.h"
 #include "ShmClient.h"
 
@@ -30,15 +32,20 @@ private slots:
     void on_mode_changed(int index);
     void on_connect_button_clicked();
     void on_send_button_clicked();
-    void on_message_received(QString user, QString timestamp, QString text);
+    void on_messages_received(const QVector<ChatMessage>& batch);
     void on_connected();
+    void on_reconnecting(int attempt, int delay_ms);
     void on_disconnected();
     void on_error(QString error);
+    void on_scrolled(int value);
 
 private:
     void setup_ui();
     void update_ui_for_mode();
     void append_message(const QString& user, const QString& timestamp, const QString& text);
+    void show_notice(const QString& user, const QString& text);  // Local status; kept out of the history
+    bool at_bottom() const;
+    std::string history_path() const;
 
     // UI components
     QComboBox* mode_combo_;
@@ -46,9 +53,11 @@ private:
     QSpinBox* port_input_;
     QLineEdit* shm_name_input_;
     QLineEdit* username_input_;
+    QSpinBox* scrollback_input_;
     QPushButton* connect_button_;
     
-    QTextEdit* messages_display_;
+    QListView* messages_display_;
+    MessageListModel* messages_model_;
     QLineEdit* message_input_;
     QPushButton* send_button_;
     
@@ -61,6 +70,7 @@ private:
 
     // State
     bool is_connected_;
+    bool resuming_;     // Socket dropped; the client is reconnecting
     int current_mode_;  // 0 = Socket, 1 = Shared Memory
 };
 
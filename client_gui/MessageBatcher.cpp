@@ -0,0 +1,56 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "MessageBatcher.h"
+#include <QMetaObject>
+#include <chrono>
+#include <thread>
+
+MessageBatcher::MessageBatcher(QObject* parent) : QObject(parent) {
+    timer_.setSingleShot(true);
+    connect(&timer_, &QTimer::timeout, this, &MessageBatcher::flush);
+    last_drain_.start();
+}
+
+bool MessageBatcher::push(const Message& msg, const std::atomic<bool>& stop) {
+    while (!queue_.push(msg)) {
+        if (stop) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Only the first message since the last drain posts an event
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, "on_wake", Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void MessageBatcher::on_wake() {
+    if (timer_.isActive()) return;
+    qint64 since = last_drain_.elapsed();
+    if (since >= kFrameIntervalMs) {
+        flush();
+    } else {
+        timer_.start(static_cast<int>(kFrameIntervalMs - since));
+    }
+}
+
+void MessageBatcher::flush() {
+    timer_.stop();
+    last_drain_.restart();
+
+    // Clear the flag first: a push racing with the drain below then posts
+    // a fresh wake-up instead of being stranded
+    wake_pending_.store(false, std::memory_order_release);
+
+    QVector<ChatMessage> batch;
+    batch.reserve(static_cast<int>(queue_.size()));
+    Message msg;
+    while (queue_.pop(msg)) {
+        QString user = QString::fromUtf8(msg.user);
+        if (msg.to[0]) user += " (direct)";
+        batch.push_back(ChatMessage{user, QString::fromUtf8(msg.timestamp), QString::fromUtf8(msg.text)});
+    }
+    if (!batch.isEmpty()) emit messages_received(batch);
+}
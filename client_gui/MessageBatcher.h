@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Hands received messages from a transport thread to the GUI in batches
+ */
+
+#ifndef MESSAGE_BATCHER_H
+#define MESSAGE_BATCHER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include "../shared/protocol.h"
+#include "../shared/spsc_queue.h"
+
+// One received message, as the GUI shows it
+struct ChatMessage {
+    QString user;
+    QString timestamp;
+    QString text;
+};
+
+/**
+ * The receive thread push()es raw Messages into an SPSC ring; nothing Qt
+ * happens on that thread except, at most once per batch, a queued wake-up.
+ * On the GUI thread the ring is drained at most once per frame interval
+ * and everything that arrived meanwhile goes out as one
+ * messages_received() signal, so a burst costs one event and one repaint
+ * instead of one per message.
+ *
+ * A full ring makes the receive thread wait (the socket then backs up
+ * into the server) rather than drop messages.
+ */
+class MessageBatcher : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kFrameIntervalMs = 16;
+    static constexpr size_t kCapacity = 1024;
+
+    explicit MessageBatcher(QObject* parent = nullptr);
+
+    // Receive thread; returns false only if `stop` was raised while full
+    bool push(const Message& msg, const std::atomic<bool>& stop);
+
+public slots:
+    // GUI thread: deliver everything queued right now
+    void flush();
+
+signals:
+    void messages_received(const QVector<ChatMessage>& batch);
+
+private slots:
+    void on_wake();
+
+private:
+    SpscQueue<Message, kCapacity> queue_;
+    std::atomic<bool> wake_pending_{false};
+    QTimer timer_;              // Defers a drain to the end of the frame interval
+    QElapsedTimer last_drain_;
+};
+
+#endif  // MESSAGE_BATCHER_H
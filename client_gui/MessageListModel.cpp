@@ -0,0 +1,247 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "MessageListModel.h"
+#include <algorithm>
+
+namespace {
+
+// First byte of a record: whether the row is in the history file
+constexpr char kStored = 's';
+constexpr char kNotice = 'n';
+
+bool is_notice(const std::string& record) { return record[0] == kNotice; }
+
+// Split a record back into its three fields
+void unpack(const std::string& record, QString& user, QString& timestamp, QString& text) {
+    size_t a = record.find('\0', 1);
+    size_t b = record.find('\0', a + 1);
+    user = QString::fromUtf8(record.data() + 1, static_cast<int>(a - 1));
+    timestamp = QString::fromUtf8(record.data() + a + 1, static_cast<int>(b - a - 1));
+    text = QString::fromUtf8(record.data() + b + 1, static_cast<int>(record.size() - b - 1));
+}
+
+// Build the in-memory record for a row
+std::string pack(const std::string& user, const std::string& timestamp, const std::string& text,
+                 char kind = kStored) {
+    std::string record;
+    record.reserve(user.size() + timestamp.size() + text.size() + 3);
+    record += kind;
+    record += user;
+    record += '\0';
+    record += timestamp;
+    record += '\0';
+    record += text;
+    return record;
+}
+
+}  // namespace
+
+MessageListModel::MessageListModel(int capacity, QObject* parent)
+    : QAbstractListModel(parent), capacity_(std::max(1, capacity)) {}
+
+int MessageListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : size_;
+}
+
+QVariant MessageListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= size_) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole) return QVariant();
+
+    // Formatted on demand, only for rows the view is painting
+    QString user, timestamp, text;
+    unpack(at(index.row()), user, timestamp, text);
+    if (!timestamp.isEmpty()) {
+        return QString("[%1] %2: %3").arg(timestamp, user, text);
+    }
+    return QString("%1: %2").arg(user, text);
+}
+
+std::string& MessageListModel::slot(size_t index) {
+    index %= static_cast<size_t>(capacity_);
+    if (index >= ring_.size()) ring_.resize(index + 1);
+    return ring_[index];
+}
+
+void MessageListModel::push_back(std::string record) {
+    notices_ += is_notice(record);
+    slot(head_ + static_cast<size_t>(size_)) = std::move(record);
+    size_++;
+}
+
+void MessageListModel::push_front(std::string record) {
+    notices_ += is_notice(record);
+    head_ = (head_ + static_cast<size_t>(capacity_) - 1) % static_cast<size_t>(capacity_);
+    slot(head_) = std::move(record);
+    size_++;
+}
+
+void MessageListModel::drop_front(int count) {
+    if (count <= 0) return;
+    beginRemoveRows(QModelIndex(), 0, count - 1);
+    for (int row = 0; row < count; ++row) {
+        if (is_notice(at(row))) {
+            notices_--;
+        } else {
+            first_++;
+        }
+    }
+    head_ = (head_ + static_cast<size_t>(count)) % static_cast<size_t>(capacity_);
+    size_ -= count;
+    endRemoveRows();
+}
+
+void MessageListModel::drop_back(int count) {
+    if (count <= 0) return;
+    beginRemoveRows(QModelIndex(), size_ - count, size_ - 1);
+    for (int row = size_ - count; row < size_; ++row) notices_ -= is_notice(at(row));
+    size_ -= count;
+    endRemoveRows();
+}
+
+void MessageListModel::append(const QString& user, const QString& timestamp, const QString& text) {
+    append(QVector<ChatMessage>{ChatMessage{user, timestamp, text}});
+}
+
+void MessageListModel::append(const QVector<ChatMessage>& batch) {
+    if (batch.isEmpty()) return;
+    bool follow = at_tail();
+
+    std::vector<std::string> records;
+    records.reserve(static_cast<size_t>(batch.size()));
+    bool failed = false;
+    for (const ChatMessage& msg : batch) {
+        std::string user = msg.user.toUtf8().toStdString();
+        std::string timestamp = msg.timestamp.toUtf8().toStdString();
+        std::string text = msg.text.toUtf8().toStdString();
+        if (history_.is_open() && history_.append(user, timestamp, text) == UINT64_MAX) {
+            history_.close();
+            failed = true;
+        }
+        records.push_back(pack(user, timestamp, text));
+    }
+    if (failed) {
+        // Disk trouble: keep going as a plain in-memory scrollback. A window
+        // scrolled back can no longer page down to the tail, so it starts
+        // over from this batch rather than hiding everything in between.
+        if (!follow) clear();
+        first_ = 0;
+        follow = true;
+    }
+    // Scrolled back into the history: the new rows are on disk, not shown yet
+    if (!follow) return;
+
+    push_rows(records);
+}
+
+void MessageListModel::append_notice(const QString& user, const QString& text) {
+    std::vector<std::string> records;
+    records.push_back(pack(user.toUtf8().toStdString(), "", text.toUtf8().toStdString(), kNotice));
+    push_rows(records);
+}
+
+void MessageListModel::push_rows(std::vector<std::string>& records) {
+    // Only the newest `capacity_` of a huge batch could ever be shown
+    int count = std::min(static_cast<int>(records.size()), capacity_);
+    drop_front(std::max(0, size_ + count - capacity_));
+
+    beginInsertRows(QModelIndex(), size_, size_ + count - 1);
+    for (size_t i = records.size() - static_cast<size_t>(count); i < records.size(); ++i) {
+        push_back(std::move(records[i]));
+    }
+    endInsertRows();
+    if (history_.is_open() && at_tail()) first_ = history_.count() - static_cast<uint64_t>(size_ - notices_);
+}
+
+int MessageListModel::load_older(int count) {
+    if (!history_.is_open() || first_ == 0) return 0;
+    count = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(std::min(count, capacity_)), first_));
+    if (count <= 0) return 0;
+
+    // Make room by letting the newest rows go back to disk
+    drop_back(std::max(0, size_ + count - capacity_));
+
+    beginInsertRows(QModelIndex(), 0, count - 1);
+    std::string user, timestamp, text;
+    for (int i = 0; i < count; ++i) {
+        if (history_.get(first_ - 1, user, timestamp, text)) {
+            push_front(pack(user, timestamp, text));
+        } else {
+            push_front(pack("[Error]", "", "History record unreadable"));
+        }
+        first_--;
+    }
+    endInsertRows();
+    return count;
+}
+
+int MessageListModel::load_newer(int count) {
+    if (at_tail()) return 0;
+    uint64_t available = history_.count() - first_ - static_cast<uint64_t>(size_ - notices_);
+    count = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(std::min(count, capacity_)), available));
+    if (count <= 0) return 0;
+
+    drop_front(std::max(0, size_ + count - capacity_));
+
+    beginInsertRows(QModelIndex(), size_, size_ + count - 1);
+    std::string user, timestamp, text;
+    for (int i = 0; i < count; ++i) {
+        uint64_t index = first_ + static_cast<uint64_t>(size_ - notices_);
+        if (history_.get(index, user, timestamp, text)) {
+            push_back(pack(user, timestamp, text));
+        } else {
+            push_back(pack("[Error]", "", "History record unreadable"));
+        }
+    }
+    endInsertRows();
+    return count;
+}
+
+void MessageListModel::clear() {
+    beginResetModel();
+    std::vector<std::string>().swap(ring_);
+    head_ = 0;
+    size_ = 0;
+    notices_ = 0;
+    first_ = history_.count();
+    endResetModel();
+}
+
+bool MessageListModel::attach_history(const std::string& base_path) {
+    history_.close();
+    clear();
+    if (base_path.empty() || !history_.open(base_path)) return false;
+
+    // Start at the tail; everything older stays on disk until scrolled to
+    first_ = history_.count();
+    load_older(kPageRows);
+    return true;
+}
+
+void MessageListModel::set_capacity(int capacity) {
+    capacity = std::max(1, capacity);
+    if (capacity == capacity_) return;
+
+    // Re-lay the newest rows from slot 0
+    beginResetModel();
+    int keep = std::min(size_, capacity);
+    std::vector<std::string> rows;
+    rows.reserve(static_cast<size_t>(keep));
+    for (int row = 0; row < size_ - keep; ++row) {
+        if (is_notice(at(row))) {
+            notices_--;
+        } else {
+            first_++;
+        }
+    }
+    for (int row = size_ - keep; row < size_; ++row) {
+        rows.push_back(std::move(ring_[(head_ + static_cast<size_t>(row)) % static_cast<size_t>(capacity_)]));
+    }
+    ring_.swap(rows);
+    head_ = 0;
+    size_ = keep;
+    capacity_ = capacity;
+    endResetModel();
+}
@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Bounded list model behind the chat view
+ */
+
+#ifndef MESSAGE_LIST_MODEL_H
+#define MESSAGE_LIST_MODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <string>
+#include <vector>
+#include "MessageBatcher.h"
+#include "../shared/history_store.h"
+
+/**
+ * Keeps the newest `capacity` messages in a ring of compact UTF-8 records
+ * (user, timestamp and text in one buffer, no QString or layout per row).
+ * The display string is built only when the view asks for a visible row,
+ * so memory and paint time stay flat however long the session runs.
+ * Older messages fall off the top once the cap is reached.
+ *
+ * With a history file attached every message is also appended to a
+ * HistoryStore, and the ring becomes a window onto it: attaching loads
+ * only the newest page, and load_older() / load_newer() slide the window
+ * as the user scrolls, so startup time and memory do not grow with the
+ * length of the history. New messages enter the ring only while the
+ * window is at the tail; otherwise they are just persisted. Notices (the
+ * client's own status lines) are shown but never persisted, so they do
+ * not come back as chat in a later session.
+ */
+class MessageListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    static constexpr int kDefaultCapacity = 10000;
+
+    explicit MessageListModel(int capacity = kDefaultCapacity, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void append(const QString& user, const QString& timestamp, const QString& text);
+    void append(const QVector<ChatMessage>& batch);
+
+    // Show a local status line below the resident rows; not written to the history
+    void append_notice(const QString& user, const QString& text);
+    void clear();
+
+    // Switch to the history at `base_path` (empty: none) and show its newest page
+    bool attach_history(const std::string& base_path);
+
+    // Page rows in from the store above/below the window; return rows added
+    int load_older(int count);
+    int load_newer(int count);
+
+    // True when the last row is the newest message
+    bool at_tail() const {
+        return !history_.is_open() || first_ + static_cast<uint64_t>(size_ - notices_) >= history_.count();
+    }
+
+    // Scrollback cap; shrinking drops the oldest rows
+    void set_capacity(int capacity);
+    int capacity() const { return capacity_; }
+
+    static constexpr int kPageRows = 200;
+
+private:
+    // Record for a row: a kind byte, then "user\0timestamp\0text" in UTF-8
+    const std::string& at(int row) const { return ring_[(head_ + static_cast<size_t>(row)) % static_cast<size_t>(capacity_)]; }
+    std::string& slot(size_t index);
+    void push_back(std::string record);
+    void push_front(std::string record);
+    void drop_front(int count);
+    void drop_back(int count);
+    void push_rows(std::vector<std::string>& records);  // Below the window, dropping from the top to fit
+
+    std::vector<std::string> ring_;  // Slots are created on first use, up to capacity_
+    size_t head_ = 0;                // Slot of the oldest row
+    int size_ = 0;
+    int notices_ = 0;                // Resident rows that are not in the store
+    int capacity_;
+
+    ChatUtils::HistoryStore history_;
+    uint64_t first_ = 0;             // Store index of the first stored row
+};
+
+#endif  // MESSAGE_LIST_MODEL_H
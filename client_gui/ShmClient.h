@@ -10,11 +10,18 @@
 
 #include <QObject>
 #include <QString>
-#include <thread>
 #include <atomic>
-#include <semaphore.h>
-#include "../shared/protocol.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include "MessageBatcher.h"
+#include "../libchatclient/event_loop.h"
+#include "../libchatclient/shm_session.h"
 
+/**
+ * Qt adapter over ChatClient::ShmSession, run on its own event loop
+ * thread like SocketClient.
+ */
 class ShmClient : public QObject {
     Q_OBJECT
 
@@ -35,27 +42,18 @@ public:
     bool send_message(const QString& text);
 
 private:
-    void read_loop();
-    bool initialize_shared_memory(const QString& shm_name);
-    bool write_to_buffer(const Message& msg);
-    bool read_from_buffer(Message& msg);
-
-    int shm_fd_;
-    void* shm_ptr_;
-    ShmLayout* layout_;
-    sem_t* mutex_sem_;
-    sem_t* count_sem_;
-    
+    ChatClient::EventLoop loop_;
+    std::unique_ptr<ChatClient::ShmSession> session_;  // Loop thread only while it runs
+    std::thread loop_thread_;
     std::atomic<bool> joined_;
     std::atomic<bool> should_stop_;
-    std::thread read_thread_;
-    QString username_;
-    int last_read_index_;
+    std::string username_;
+    MessageBatcher batcher_;  // Loop thread -> GUI thread
 
 signals:
     void joined();
     void left();
-    void message_received(QString user, QString timestamp, QString text);
+    void messages_received(const QVector<ChatMessage>& batch);  // GUI thread, one per frame at most
     void error_occurred(QString error_msg);
 };
 
@@ -4,21 +4,15 @@
  */
 
 #include "SocketClient.h"
-#include "../shared/common.h"
-#include <unistd.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <cstring>
-#include <QDebug>
-
-using namespace ChatUtils;
 
 SocketClient::SocketClient(QObject* parent)
-    : QObject(parent), socket_fd_(-1), connected_(false), should_stop_(false) {}
+    : QObject(parent), connected_(false), online_(false), should_stop_(false) {
+    connect(&batcher_, &MessageBatcher::messages_received, this, &SocketClient::messages_received);
+}
 
 SocketClient::~SocketClient() {
     disconnect();
+    stop_loop();
 }
 
 bool SocketClient::connect_to_server(const QString& host, int port, const QString& username) {
@@ -26,92 +20,90 @@ bool SocketClient::connect_to_server(const QString& host, int port, const QStrin
         emit error_occurred("Already connected");
         return false;
     }
-
-    username_ = username;
-
-    // Create socket
-    socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd_ < 0) {
-        emit error_occurred("Failed to create socket");
-        return false;
-    }
-
-    // Connect to server
-    sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    inet_pton(AF_INET, host.toStdString().c_str(), &server_addr.sin_addr);
-
-    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    stop_loop();  // A session the server dropped may still own the loop
+
+    username_ = username.toStdString();
+
+    // Callbacks run on the loop thread; signals reach the GUI queued
+    ChatClient::Callbacks callbacks;
+    callbacks.on_connected = [this]() {
+        connected_ = true;
+        online_ = true;
+        emit connected();
+    };
+    callbacks.on_reconnecting = [this](int attempt, int delay_ms) {
+        online_ = false;
+        emit reconnecting(attempt, delay_ms);
+    };
+    callbacks.on_message = [this](const Message& msg) {
+        // The server echoes our own messages so the sequence has no holes;
+        // the window already showed them when they were sent
+        if (!session_->is_own(msg)) batcher_.push(msg, should_stop_);
+    };
+    callbacks.on_error = [this](const std::string& error) {
+        emit error_occurred(QString::fromStdString(error));
+    };
+    callbacks.on_disconnected = [this]() {
+        online_ = false;
+        if (connected_.exchange(false)) emit disconnected();
+    };
+
+    session_.reset(new ChatClient::SocketSession(loop_, callbacks));
+    session_->set_reconnect(ChatClient::ReconnectPolicy());
+    if (!session_->connect(host.toStdString(), port, username_)) {
+        session_.reset();
         emit error_occurred("Failed to connect to server");
-        close(socket_fd_);
-        socket_fd_ = -1;
         return false;
     }
 
-    // Send username
-    Message msg;
-    strncpy(msg.user, username_.toStdString().c_str(), MAX_USERNAME_LEN - 1);
-    strncpy(msg.timestamp, Message::get_current_timestamp().c_str(), MAX_TIMESTAMP_LEN - 1);
-    strncpy(msg.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
-
-    if (!ChatUtils::send_message(socket_fd_, msg)) {
-        emit error_occurred("Failed to send username");
-        close(socket_fd_);
-        socket_fd_ = -1;
-        return false;
-    }
-
-    connected_ = true;
     should_stop_ = false;
-    receive_thread_ = std::thread(&SocketClient::receive_loop, this);
-
-    emit connected();
+    loop_thread_ = std::thread([this]() { loop_.run(); });
     return true;
 }
 
 void SocketClient::disconnect() {
-    if (!connected_) return;
-
-    should_stop_ = true;
-    connected_ = false;
+    if (!loop_thread_.joinable()) return;
+    stop_loop();
+    online_ = false;
+    if (connected_.exchange(false)) emit disconnected();
+}
 
-    if (socket_fd_ >= 0) {
-        // Shutdown both send and receive to unblock any blocking recv() calls
-        shutdown(socket_fd_, SHUT_RDWR);
-        close(socket_fd_);
-        socket_fd_ = -1;
-    }
+void SocketClient::stop_loop() {
+    if (!loop_thread_.joinable()) return;
 
-    // Detach the thread instead of joining to avoid blocking the GUI thread
-    if (receive_thread_.joinable()) {
-        receive_thread_.detach();
-    }
+    // Unblocks a receive callback waiting on a full batcher
+    should_stop_ = true;
+    loop_.stop();
+    loop_thread_.join();
 
-    emit disconnected();
+    // The loop is ours now: close, and let sends still queued fail harmlessly
+    session_->close();
+    loop_.run_once(0);
+    session_.reset();
 }
 
 bool SocketClient::send_message(const QString& text) {
-    if (!connected_) return false;
+    if (!online_) return false;
 
-    Message msg;
-    strncpy(msg.user, username_.toStdString().c_str(), MAX_USERNAME_LEN - 1);
-    strncpy(msg.timestamp, Message::get_current_timestamp().c_str(), MAX_TIMESTAMP_LEN - 1);
-    strncpy(msg.text, text.toStdString().c_str(), MAX_MESSAGE_LEN - 1);
+    // Converted once here; the loop thread frames and sends it
+    std::string utf8 = text.toStdString();
+    loop_.post([this, utf8]() { session_->send(utf8); });
+    return true;
+}
+
+bool SocketClient::send_direct(const QString& user, const QString& text) {
+    if (!online_) return false;
 
-    return ChatUtils::send_message(socket_fd_, msg);
+    std::string to = user.toStdString();
+    std::string utf8 = text.toStdString();
+    loop_.post([this, to, utf8]() { session_->send_to(to, utf8); });
+    return true;
 }
 
-void SocketClient::receive_loop() {
-    Message msg;
-    while (!should_stop_ && ChatUtils::recv_message(socket_fd_, msg)) {
-        emit message_received(
-            QString::fromUtf8(msg.user),
-            QString::fromUtf8(msg.timestamp),
-            QString::fromUtf8(msg.text)
-        );
-    }
+bool SocketClient::set_filter(const QString& spec) {
+    if (!connected_) return false;
 
-    connected_ = false;
-    emit disconnected();
+    std::string utf8 = spec.toStdString();
+    loop_.post([this, utf8]() { session_->set_filter(utf8); });
+    return true;
 }
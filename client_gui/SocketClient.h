@@ -10,11 +10,24 @@
 
 #include <QObject>
 #include <QString>
-#include <QThread>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <thread>
-#include "../shared/protocol.h"
+#include "MessageBatcher.h"
+#include "../libchatclient/event_loop.h"
+#include "../libchatclient/socket_session.h"
 
+/**
+ * Qt adapter over ChatClient::SocketSession. The session and its event
+ * loop run on one background thread; GUI calls are posted to that loop
+ * and received messages come back through the MessageBatcher.
+ *
+ * Once connected, a dropped connection is retried with backoff
+ * (reconnecting(), then connected() again) and resumes from the last
+ * sequence number seen; disconnected() means the session is over.
+ */
 class SocketClient : public QObject {
     Q_OBJECT
 
@@ -22,31 +35,44 @@ public:
     SocketClient(QObject* parent = nullptr);
     ~SocketClient();
 
-    // Connect to server
+    // Start connecting; connected() follows once the server accepted us
     bool connect_to_server(const QString& host, int port, const QString& username);
 
     // Disconnect from server
     void disconnect();
 
-    // Check if connected
+    // Check if connected (true while reconnecting, too)
     bool is_connected() const { return connected_; }
 
     // Send a message
     bool send_message(const QString& text);
 
+    // Send a direct message to one user
+    bool send_direct(const QString& user, const QString& text);
+
+    // Only receive room messages matching `spec` (empty: all of them)
+    bool set_filter(const QString& spec);
+
+    // Messages the server sequenced but we never received
+    uint64_t missed_messages() const { return session_ ? session_->missed() : 0; }
+
 private:
-    void receive_loop();
+    void stop_loop();
 
-    int socket_fd_;
+    ChatClient::EventLoop loop_;
+    std::unique_ptr<ChatClient::SocketSession> session_;  // Loop thread only while it runs
+    std::thread loop_thread_;
     std::atomic<bool> connected_;
+    std::atomic<bool> online_;  // The socket is up; false during reconnect backoff
     std::atomic<bool> should_stop_;
-    std::thread receive_thread_;
-    QString username_;
+    std::string username_;
+    MessageBatcher batcher_;  // Loop thread -> GUI thread
 
 signals:
     void connected();
+    void reconnecting(int attempt, int delay_ms);
     void disconnected();
-    void message_received(QString user, QString timestamp, QString text);
+    void messages_received(const QVector<ChatMessage>& batch);  // GUI thread, one per frame at most
     void error_occurred(QString error_msg);
 };
 
@@ -0,0 +1,211 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "coro_io.h"
+#include "../shared/protocol.h"
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace ChatClient {
+
+namespace {
+
+constexpr size_t kInBufferBytes = 4 * (MAX_FRAME_LEN + 4);
+
+}  // namespace
+
+Connection::Connection(EventLoop& loop) : loop_(loop) {}
+
+Connection::~Connection() {
+    unregister();
+}
+
+bool Connection::attach(int fd) {
+    if (is_open() || fd < 0) return false;
+    if (!loop_.add(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, [this](uint32_t events) { on_events(events); })) {
+        return false;
+    }
+    fd_ = fd;
+    in_.resize(kInBufferBytes);
+    in_start_ = in_end_ = 0;
+    return true;
+}
+
+Task<bool> Connection::connect(const std::string& host, int port) {
+    close();
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) co_return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) co_return false;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if ((::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 && errno != EINPROGRESS) ||
+        !attach(fd)) {
+        ::close(fd);
+        co_return false;
+    }
+    owned_ = true;
+
+    // The loop reports the socket writable once the handshake is over
+    connecting_ = true;
+    write_left_ = 0;
+    if (!co_await WriteAwaiter(*this)) {
+        close();
+        co_return false;
+    }
+    co_return true;
+}
+
+Connection::ReadAwaiter Connection::read_frame(char* out, size_t& len) {
+    read_out_ = out;
+    read_len_ = &len;
+    return ReadAwaiter(*this);
+}
+
+Connection::WriteAwaiter Connection::write(const char* data, size_t len) {
+    write_data_ = data;
+    write_left_ = len;
+    return WriteAwaiter(*this);
+}
+
+void Connection::close() {
+    std::coroutine_handle<> reader = std::exchange(reader_, {});
+    std::coroutine_handle<> writer = std::exchange(writer_, {});
+    unregister();
+    read_ok_ = write_ok_ = false;
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+}
+
+void Connection::unregister() {
+    if (fd_ < 0) return;
+    loop_.remove(fd_);
+    if (owned_) ::close(fd_);
+    fd_ = -1;
+    owned_ = false;
+    connecting_ = false;
+}
+
+void Connection::on_events(uint32_t events) {
+    // Decide both sides before resuming either: a resumed coroutine may
+    // close or destroy this connection
+    std::coroutine_handle<> reader, writer;
+    if (reader_ && (events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && read_step()) {
+        reader = std::exchange(reader_, {});
+    }
+    if (writer_ && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+        bool done;
+        if (connecting_) {
+            connecting_ = false;
+            int error = 0;
+            socklen_t len = sizeof(error);
+            write_ok_ = getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+            done = true;
+        } else {
+            done = write_step();
+        }
+        if (done) writer = std::exchange(writer_, {});
+    }
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+}
+
+bool Connection::read_step() {
+    if (fd_ < 0) {
+        read_ok_ = false;
+        return true;
+    }
+    for (;;) {
+        // A whole frame buffered already?
+        if (in_end_ - in_start_ >= 4) {
+            uint32_t len_net;
+            std::memcpy(&len_net, in_.data() + in_start_, sizeof(len_net));
+            size_t len = ntohl(len_net);
+            if (len > MAX_FRAME_LEN) {
+                read_ok_ = false;
+                return true;
+            }
+            if (in_end_ - in_start_ >= 4 + len) {
+                std::memcpy(read_out_, in_.data() + in_start_ + 4, len);
+                in_start_ += 4 + len;
+                if (in_start_ == in_end_) in_start_ = in_end_ = 0;
+                if (len > 0 && read_out_[len - 1] == MESSAGE_SEPARATOR) len--;
+                *read_len_ = len;
+                read_ok_ = true;
+                return true;
+            }
+        }
+        if (in_end_ == in_.size()) {
+            std::memmove(in_.data(), in_.data() + in_start_, in_end_ - in_start_);
+            in_end_ -= in_start_;
+            in_start_ = 0;
+        }
+
+        // Edge-triggered: only park after the kernel said EAGAIN
+        ssize_t n = recv(fd_, in_.data() + in_end_, in_.size() - in_end_, MSG_DONTWAIT);
+        if (n > 0) {
+            in_end_ += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        read_ok_ = false;
+        return true;
+    }
+}
+
+bool Connection::write_step() {
+    if (fd_ < 0) {
+        write_ok_ = false;
+        return true;
+    }
+    if (connecting_) return false;
+    while (write_left_ > 0) {
+        ssize_t n = send(fd_, write_data_, write_left_, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            write_data_ += n;
+            write_left_ -= static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return false;
+        write_ok_ = false;
+        return true;
+    }
+    write_ok_ = true;
+    return true;
+}
+
+bool SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return false;  // Do not suspend; resume right away
+    itimerspec spec{};
+    spec.it_value.tv_sec = ms_ / 1000;
+    spec.it_value.tv_nsec = static_cast<long>(ms_ % 1000) * 1000000L;
+    EventLoop& loop = loop_;
+    if (timerfd_settime(fd, 0, &spec, nullptr) != 0 ||
+        !loop.add(fd, EPOLLIN, [&loop, fd, h](uint32_t) {
+            loop.remove(fd);
+            ::close(fd);
+            h.resume();
+        })) {
+        ::close(fd);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace ChatClient
@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Awaitable socket I/O on the EventLoop (built with CHAT_COROUTINES)
+ */
+
+#ifndef CHATCLIENT_CORO_IO_H
+#define CHATCLIENT_CORO_IO_H
+
+#include <coroutine>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "coro_task.h"
+#include "event_loop.h"
+
+namespace ChatClient {
+
+/**
+ * A framed stream socket driven by coroutines:
+ *
+ *     size_t len;
+ *     while (co_await conn.read_frame(buffer, len)) {
+ *         ...
+ *         co_await conn.write(frame, frame_len);
+ *     }
+ *
+ * The fd is registered edge-triggered once; a read or write that would
+ * block parks the coroutine and the loop resumes it when the socket is
+ * ready, so the code keeps its sequential shape without a thread per
+ * connection. Reads and writes use MSG_DONTWAIT and never change the fd's
+ * blocking mode, so an adopted socket may also be written from elsewhere:
+ * the server only reads through its Connection, while its sends go out
+ * through the handler's Outbox and the SendPoller on other threads.
+ *
+ * At most one read and one write may be pending at a time, and the
+ * Connection must outlive both. All of it runs on the loop thread.
+ */
+class Connection {
+public:
+    class ReadAwaiter;
+    class WriteAwaiter;
+
+    explicit Connection(EventLoop& loop);
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // Adopt a connected socket; the caller keeps ownership of the fd
+    bool attach(int fd);
+
+    // Open a TCP connection; the fd is then owned and closed by close()
+    Task<bool> connect(const std::string& host, int port);
+
+    // Next frame's payload (trailing newline stripped) into `out`, which
+    // holds MAX_FRAME_LEN bytes; false once the peer is gone
+    ReadAwaiter read_frame(char* out, size_t& len);
+
+    // All `len` bytes, or false on error
+    WriteAwaiter write(const char* data, size_t len);
+
+    // Unregister (closing an owned fd); pending reads/writes resume with false
+    void close();
+
+    int fd() const { return fd_; }
+    bool is_open() const { return fd_ >= 0; }
+
+    class ReadAwaiter {
+    public:
+        explicit ReadAwaiter(Connection& conn) : conn_(conn) {}
+        bool await_ready() { return conn_.read_step(); }
+        void await_suspend(std::coroutine_handle<> h) { conn_.reader_ = h; }
+        bool await_resume() { return conn_.read_ok_; }
+
+    private:
+        Connection& conn_;
+    };
+
+    class WriteAwaiter {
+    public:
+        explicit WriteAwaiter(Connection& conn) : conn_(conn) {}
+        bool await_ready() { return conn_.write_step(); }
+        void await_suspend(std::coroutine_handle<> h) { conn_.writer_ = h; }
+        bool await_resume() { return conn_.write_ok_; }
+
+    private:
+        Connection& conn_;
+    };
+
+private:
+    void on_events(uint32_t events);
+    bool read_step();   // True when the pending read finished (either way)
+    bool write_step();  // Same for the pending write
+    void unregister();
+
+    EventLoop& loop_;
+    int fd_ = -1;
+    bool owned_ = false;
+    bool connecting_ = false;  // Waiting for a non-blocking connect
+
+    std::vector<char> in_;
+    size_t in_start_ = 0;
+    size_t in_end_ = 0;
+
+    std::coroutine_handle<> reader_;
+    char* read_out_ = nullptr;
+    size_t* read_len_ = nullptr;
+    bool read_ok_ = false;
+
+    std::coroutine_handle<> writer_;
+    const char* write_data_ = nullptr;
+    size_t write_left_ = 0;
+    bool write_ok_ = false;
+};
+
+// Resume on the next loop iteration, after everything already runnable
+class YieldAwaiter {
+public:
+    explicit YieldAwaiter(EventLoop& loop) : loop_(loop) {}
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) { loop_.post([h]() { h.resume(); }); }
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop& loop_;
+};
+
+inline YieldAwaiter yield(EventLoop& loop) {
+    return YieldAwaiter(loop);
+}
+
+// Resume after `ms` milliseconds (one timerfd per sleep; for slow paths)
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop& loop, int ms) : loop_(loop), ms_(ms) {}
+    bool await_ready() const noexcept { return ms_ <= 0; }
+    bool await_suspend(std::coroutine_handle<> h);
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop& loop_;
+    int ms_;
+};
+
+inline SleepAwaiter sleep_for(EventLoop& loop, int ms) {
+    return SleepAwaiter(loop, ms);
+}
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_CORO_IO_H
@@ -0,0 +1,141 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Minimal C++20 coroutine task type (built with CHAT_COROUTINES)
+ */
+
+#ifndef CHATCLIENT_CORO_TASK_H
+#define CHATCLIENT_CORO_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace ChatClient {
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+// Resumes whoever awaited the task once it finishes (symmetric transfer,
+// so long await chains do not grow the stack)
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+        std::coroutine_handle<> next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+    T result() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+}  // namespace detail
+
+/**
+ * Lazy coroutine: nothing runs until the task is co_awaited (or handed to
+ * spawn()). Awaiting it runs the body and yields its co_return value;
+ * exceptions travel to the awaiter. Move-only; owns its frame.
+ */
+template <typename T = void>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> detail::Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+namespace detail {
+
+// Fire-and-forget frame that owns a task and frees itself at the end
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+inline Detached run_detached(Task<void> task) {
+    co_await task;
+}
+
+}  // namespace detail
+
+// Start `task` now on the calling thread; it runs until its first
+// suspension and cleans up after itself. An escaping exception terminates.
+inline void spawn(Task<void> task) {
+    detail::run_detached(std::move(task));
+}
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_CORO_TASK_H
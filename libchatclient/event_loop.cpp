@@ -0,0 +1,181 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "event_loop.h"
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace ChatClient {
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+
+}  // namespace
+
+EventLoop::EventLoop() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;  // Marks the wake-up fd
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    }
+}
+
+EventLoop::~EventLoop() {
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+bool EventLoop::add(int fd, uint32_t events, IoHandler handler) {
+    if (fd < 0 || epoll_fd_ < 0) return false;
+    if (static_cast<size_t>(fd) >= watches_.size()) watches_.resize(static_cast<size_t>(fd) + 1);
+    if (watches_[fd]) return false;
+
+    std::unique_ptr<Watch> watch(new Watch{fd, std::move(handler)});
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = watch.get();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+    watches_[fd] = std::move(watch);
+    watched_++;
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events) {
+    if (fd < 0 || static_cast<size_t>(fd) >= watches_.size() || !watches_[fd]) return false;
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.ptr = watches_[fd].get();
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd) {
+    if (fd < 0 || static_cast<size_t>(fd) >= watches_.size() || !watches_[fd]) return;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+
+    // The handler may be the one running right now, and events for it may
+    // still be queued in this batch: keep it alive, but mark it dead
+    watches_[fd]->fd = -1;
+    retired_.push_back(std::move(watches_[fd]));
+    watched_--;
+}
+
+int EventLoop::add_poller(Poller poller) {
+    int id = next_poller_id_++;
+    pollers_.push_back(PollerEntry{id, std::move(poller)});
+    poll_interval_ms_ = 0;
+    return id;
+}
+
+void EventLoop::remove_poller(int id) {
+    // Cleared in place so a running poller can remove itself; compacted later
+    for (PollerEntry& entry : pollers_) {
+        if (entry.id == id) {
+            entry.id = 0;
+            return;
+        }
+    }
+}
+
+void EventLoop::post(std::function<void()> task) {
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        was_empty = tasks_.empty();
+        tasks_.push_back(std::move(task));
+    }
+    // One wake-up per batch of posts
+    if (was_empty) wake();
+}
+
+void EventLoop::stop() {
+    stopped_.store(true, std::memory_order_release);
+    wake();
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;  // EAGAIN only when a wake-up is already pending
+}
+
+int EventLoop::run_once(int timeout_ms) {
+    if (epoll_fd_ < 0) return 0;
+
+    int timeout = timeout_ms;
+    if (!pollers_.empty() && (timeout < 0 || poll_interval_ms_ < timeout)) {
+        timeout = poll_interval_ms_;
+    }
+
+    epoll_event events[kMaxEvents];
+    int n = epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+    if (n < 0 && errno != EINTR) return 0;
+
+    int handled = 0;
+    for (int i = 0; i < n; ++i) {
+        Watch* watch = static_cast<Watch*>(events[i].data.ptr);
+        if (!watch) {
+            uint64_t count;
+            while (read(wake_fd_, &count, sizeof(count)) > 0) {
+            }
+            continue;
+        }
+        if (watch->fd < 0) continue;  // Removed earlier in this batch
+        watch->handler(events[i].events);
+        handled++;
+    }
+    retired_.clear();
+
+    handled += run_tasks();
+    if (!pollers_.empty()) {
+        int did = run_pollers();
+        handled += did;
+        // Idle pollers back off 1, 2, 4... ms; any work resets to busy polling
+        poll_interval_ms_ = did ? 0 : std::min(std::max(1, poll_interval_ms_ * 2), kMaxPollIntervalMs);
+    }
+    return handled;
+}
+
+void EventLoop::run() {
+    while (!stopped_.load(std::memory_order_acquire)) {
+        run_once(-1);
+    }
+    stopped_.store(false, std::memory_order_release);
+}
+
+int EventLoop::run_tasks() {
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex_);
+        if (tasks_.empty()) return 0;
+        running_tasks_.swap(tasks_);
+    }
+    // Tasks posted by these tasks run next iteration
+    int ran = static_cast<int>(running_tasks_.size());
+    for (auto& task : running_tasks_) task();
+    running_tasks_.clear();
+    return ran;
+}
+
+int EventLoop::run_pollers() {
+    int did = 0;
+    // Index loop: a poller may add or remove pollers while it runs
+    for (size_t i = 0; i < pollers_.size(); ++i) {
+        if (pollers_[i].id == 0) continue;
+        Poller poller = pollers_[i].poller;
+        if (poller()) did++;
+    }
+    pollers_.erase(std::remove_if(pollers_.begin(), pollers_.end(),
+                                  [](const PollerEntry& entry) { return entry.id == 0; }),
+                   pollers_.end());
+    return did;
+}
+
+}  // namespace ChatClient
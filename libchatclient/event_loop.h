@@ -0,0 +1,102 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Single-threaded epoll event loop that drives client sessions
+ */
+
+#ifndef CHATCLIENT_EVENT_LOOP_H
+#define CHATCLIENT_EVENT_LOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ChatClient {
+
+/**
+ * Everything registered with a loop runs on the thread that calls run() or
+ * run_once(); sessions and their callbacks are not thread-safe and must
+ * only be touched from there. Other threads hand work over with post(),
+ * which is the one thread-safe entry point besides stop().
+ *
+ * File descriptors are watched with epoll. Sources that cannot be polled
+ * by the kernel (the shared-memory ring) register a poller instead: it is
+ * called every iteration, and while pollers find nothing to do the loop
+ * sleeps in epoll for a short interval that backs off up to
+ * kMaxPollIntervalMs.
+ */
+class EventLoop {
+public:
+    using IoHandler = std::function<void(uint32_t events)>;
+    using Poller = std::function<bool()>;  // Returns true if it did any work
+
+    static constexpr int kMaxPollIntervalMs = 8;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Watch `fd` for EPOLLIN/EPOLLOUT/...; the handler may remove itself
+    bool add(int fd, uint32_t events, IoHandler handler);
+    bool modify(int fd, uint32_t events);
+    void remove(int fd);
+
+    int add_poller(Poller poller);
+    void remove_poller(int id);
+
+    // Any thread: run `task` on the loop thread during its next iteration
+    void post(std::function<void()> task);
+
+    // One iteration: wait up to timeout_ms (-1 = forever) and dispatch.
+    // Returns the number of handlers, pollers and tasks that ran.
+    int run_once(int timeout_ms);
+
+    // Iterate until stop()
+    void run();
+
+    // Any thread
+    void stop();
+
+    size_t watched() const { return watched_; }
+
+private:
+    struct Watch {
+        int fd;
+        IoHandler handler;
+    };
+
+    struct PollerEntry {
+        int id;
+        Poller poller;
+    };
+
+    int run_tasks();
+    int run_pollers();
+    void wake();
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd: post() and stop() interrupt epoll_wait
+    std::atomic<bool> stopped_{false};
+
+    std::vector<std::unique_ptr<Watch>> watches_;  // Indexed by fd
+    std::vector<std::unique_ptr<Watch>> retired_;  // Removed during dispatch, freed after it
+    size_t watched_ = 0;
+
+    std::vector<PollerEntry> pollers_;
+    int next_poller_id_ = 1;
+    int poll_interval_ms_ = 0;
+
+    std::mutex tasks_mutex_;
+    std::vector<std::function<void()>> tasks_;
+    std::vector<std::function<void()>> running_tasks_;
+};
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_EVENT_LOOP_H
@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Transport-independent chat session interface
+ */
+
+#ifndef CHATCLIENT_SESSION_H
+#define CHATCLIENT_SESSION_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "event_loop.h"
+#include "../shared/protocol.h"
+
+namespace ChatClient {
+
+// All callbacks run on the loop thread; any of them may be left empty
+struct Callbacks {
+    std::function<void()> on_connected;
+    std::function<void(const Message&)> on_message;   // Including the echo of our own messages
+    std::function<void(const std::string&)> on_error;
+    std::function<void()> on_disconnected;            // The peer went away (not after close())
+    std::function<void(int attempt, int delay_ms)> on_reconnecting;  // Lost; retrying after delay_ms
+};
+
+/**
+ * One user in one room over some transport. A session belongs to the
+ * loop it was created on; callbacks may call send() or close() on it but
+ * must not destroy it.
+ */
+class Session {
+public:
+    virtual ~Session() = default;
+
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    // Queue a message from this user; false if the session is closed
+    virtual bool send(const std::string& text) = 0;
+
+    // Leave quietly (no on_disconnected)
+    virtual void close() = 0;
+
+    virtual bool is_open() const = 0;
+
+    // Messages the room sent that this session never saw
+    virtual uint64_t missed() const = 0;
+
+    const std::string& username() const { return username_; }
+
+    // True if `msg` came from this user. Messages carrying an id are told
+    // apart by it, so other users' never cost a string compare.
+    bool is_own(const Message& msg) const {
+        if (msg.uid && self_id_ && msg.uid != self_id_) return false;
+        return username_ == msg.user;
+    }
+
+protected:
+    Session(EventLoop& loop, Callbacks callbacks) : loop_(loop), callbacks_(std::move(callbacks)) {}
+
+    // Build the message this user sends
+    Message make_message(const std::string& text) const {
+        Message msg;
+        std::strncpy(msg.user, username_.c_str(), MAX_USERNAME_LEN - 1);
+        msg.uid = self_id_;
+        Message::format_timestamp(msg.timestamp, MAX_TIMESTAMP_LEN);
+        std::strncpy(msg.text, text.c_str(), MAX_MESSAGE_LEN - 1);
+        return msg;
+    }
+
+    EventLoop& loop_;
+    Callbacks callbacks_;
+    std::string username_;
+    uint32_t self_id_ = 0;  // The id our name goes by (see the transport), 0 until known
+};
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_SESSION_H
@@ -0,0 +1,65 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "shm_session.h"
+
+namespace ChatClient {
+
+// FNV-1a of the name, never 0 (0 means "no id")
+static uint32_t name_hash(const std::string& name) {
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : name) hash = (hash ^ c) * 16777619u;
+    return hash ? hash : 1;
+}
+
+ShmSession::ShmSession(EventLoop& loop, Callbacks callbacks)
+    : Session(loop, std::move(callbacks)) {}
+
+ShmSession::~ShmSession() {
+    close();
+}
+
+bool ShmSession::join(const std::string& shm_name, const std::string& username) {
+    if (is_open() || !ring_.open(shm_name)) return false;
+    username_ = username;
+    self_id_ = name_hash(username);
+    poller_id_ = loop_.add_poller([this]() { return poll(); });
+    announce_ = true;
+    return true;
+}
+
+bool ShmSession::send(const std::string& text) {
+    if (!is_open()) return false;
+    return ring_.write(make_message(text));
+}
+
+void ShmSession::close() {
+    if (poller_id_) {
+        loop_.remove_poller(poller_id_);
+        poller_id_ = 0;
+    }
+    announce_ = false;
+    ring_.close();
+}
+
+bool ShmSession::poll() {
+    // Reported from the loop, so no callback ever runs inside join()
+    if (announce_) {
+        announce_ = false;
+        if (callbacks_.on_connected) callbacks_.on_connected();
+        if (!is_open()) return true;
+    }
+
+    Message msg;
+    int n = 0;
+    while (n < kMaxBatch && ring_.try_read(msg)) {
+        n++;
+        if (callbacks_.on_message) callbacks_.on_message(msg);
+        if (!is_open()) break;  // Closed from the callback
+    }
+    return n > 0;
+}
+
+}  // namespace ChatClient
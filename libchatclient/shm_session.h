@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Shared-memory chat session (System B)
+ */
+
+#ifndef CHATCLIENT_SHM_SESSION_H
+#define CHATCLIENT_SHM_SESSION_H
+
+#include <string>
+#include "session.h"
+#include "../shared/shm_ring.h"
+
+namespace ChatClient {
+
+/**
+ * A reader cursor on a ShmRing room. The ring has no fd to wait on, so the
+ * session registers a poller that drains up to kMaxBatch messages per loop
+ * iteration without blocking; send() writes straight into the ring.
+ *
+ * No server hands out ids here: each writer stamps its messages with a
+ * hash of its name instead, which is enough for is_own() to pass over
+ * everyone else's with an integer compare.
+ */
+class ShmSession : public Session {
+public:
+    static constexpr int kMaxBatch = 64;
+
+    ShmSession(EventLoop& loop, Callbacks callbacks);
+    ~ShmSession() override;
+
+    // Open (or create) the room; on_connected follows on the next iteration
+    bool join(const std::string& shm_name, const std::string& username);
+
+    bool send(const std::string& text) override;
+    void close() override;
+    bool is_open() const override { return ring_.is_open(); }
+    uint64_t missed() const override { return ring_.overruns(); }
+
+private:
+    bool poll();
+
+    ShmRing ring_;
+    int poller_id_ = 0;
+    bool announce_ = false;  // on_connected still to be delivered
+};
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_SHM_SESSION_H
@@ -0,0 +1,371 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "socket_session.h"
+#include "../shared/common.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace ChatClient {
+
+namespace {
+
+constexpr size_t kInBufferBytes = 4 * (MAX_FRAME_LEN + 4);
+constexpr size_t kCompressedInBufferBytes = 2 * (MAX_COMPRESSED_LEN + 4);
+constexpr size_t kMaxPendingBytes = 1024 * 1024;  // send() refuses past this
+
+}  // namespace
+
+SocketSession::SocketSession(EventLoop& loop, Callbacks callbacks)
+    : Session(loop, std::move(callbacks)), rng_(std::random_device{}()) {}
+
+SocketSession::~SocketSession() {
+    close();
+}
+
+bool SocketSession::connect(const std::string& host, int port, const std::string& username,
+                            const std::string& room) {
+    if (is_open()) return false;
+
+    host_ = host;
+    port_ = port;
+    username_ = username;
+    room_ = room;
+    last_seq_ = 0;
+    missed_ = 0;
+    established_ = false;
+    attempt_ = 0;
+    return open_socket();
+}
+
+void SocketSession::set_reconnect(const ReconnectPolicy& policy) {
+    policy_ = policy;
+    policy_.initial_delay_ms = std::max(1, policy_.initial_delay_ms);
+    policy_.max_delay_ms = std::max(policy_.initial_delay_ms, policy_.max_delay_ms);
+    reconnect_ = true;
+}
+
+bool SocketSession::open_socket() {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) != 1) return false;
+
+    fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) return false;
+    int one = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 && errno != EINPROGRESS) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    // Writable once the connect completes (or fails)
+    if (!loop_.add(fd_, EPOLLIN | EPOLLOUT, [this](uint32_t events) { on_events(events); })) {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    state_ = State::CONNECTING;
+    want_write_ = true;
+    in_.resize(compress_ ? kCompressedInBufferBytes : kInBufferBytes);
+    in_start_ = in_end_ = 0;
+    inflater_.reset();  // A new connection starts a new deflate stream
+    names_.clear();     // ...and binds its ids afresh
+    self_id_ = 0;
+
+    // The server reads the user and room from the first frame, and after a
+    // drop the last seq we saw, so it only resends the gap
+    Message hello = make_message("[JOINED]");
+    std::strncpy(hello.room, room_.c_str(), MAX_ROOMNAME_LEN - 1);
+    hello.seq = last_seq_;
+    hello.conflate = conflate_;
+    hello.deflate = compress_;
+    hello.intern = intern_;
+    if (!filter_.empty()) {
+        hello.filter = true;
+        std::strncpy(hello.text, filter_.c_str(), MAX_MESSAGE_LEN - 1);
+    }
+    return queue(hello);
+}
+
+bool SocketSession::send(const std::string& text) {
+    if (state_ == State::CLOSED || state_ == State::WAITING) return false;
+    return queue(make_message(text));
+}
+
+bool SocketSession::set_filter(const std::string& spec) {
+    filter_ = spec;
+    if (state_ == State::CLOSED || state_ == State::WAITING) return true;  // Goes with the next hello
+    Message msg = make_message(spec);
+    msg.filter = true;
+    return queue(msg);
+}
+
+bool SocketSession::send_to(const std::string& user, const std::string& text) {
+    if (state_ == State::CLOSED || state_ == State::WAITING) return false;
+    Message msg = make_message(text);
+    std::strncpy(msg.to, user.c_str(), MAX_USERNAME_LEN - 1);
+    return queue(msg);
+}
+
+void SocketSession::close() {
+    drop_socket();
+    if (retry_fd_ >= 0) {
+        loop_.remove(retry_fd_);
+        ::close(retry_fd_);
+        retry_fd_ = -1;
+    }
+    state_ = State::CLOSED;
+}
+
+void SocketSession::drop_socket() {
+    if (fd_ >= 0) {
+        loop_.remove(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+    want_write_ = false;
+    out_.clear();
+    out_sent_ = 0;
+    in_start_ = in_end_ = 0;
+}
+
+void SocketSession::fail(const std::string& error) {
+    drop_socket();
+    bool retry = reconnect_ && established_ &&
+                 (policy_.max_attempts == 0 || attempt_ < policy_.max_attempts);
+    // Only the drop itself is an error; failed retries just back off further
+    bool report = !error.empty() && (!retry || attempt_ == 0);
+    state_ = retry ? State::WAITING : State::CLOSED;
+
+    if (report && callbacks_.on_error) callbacks_.on_error(error);
+    if (!retry) {
+        if (callbacks_.on_disconnected) callbacks_.on_disconnected();
+        return;
+    }
+    if (state_ == State::WAITING) schedule_reconnect();  // Unless closed from on_error
+}
+
+void SocketSession::schedule_reconnect() {
+    // 1, 2, 4... times the initial delay, capped, then jittered into [d/2, d]
+    attempt_++;
+    int shift = std::min(attempt_ - 1, 20);
+    int64_t delay = std::min<int64_t>(static_cast<int64_t>(policy_.initial_delay_ms) << shift, policy_.max_delay_ms);
+    delay = std::max<int64_t>(1, delay / 2 + static_cast<int64_t>(rng_() % static_cast<uint64_t>(delay / 2 + 1)));
+
+    retry_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(delay / 1000);
+    spec.it_value.tv_nsec = static_cast<long>(delay % 1000) * 1000000L;
+    bool armed = retry_fd_ >= 0 && timerfd_settime(retry_fd_, 0, &spec, nullptr) == 0 &&
+                 loop_.add(retry_fd_, EPOLLIN, [this](uint32_t) {
+                     loop_.remove(retry_fd_);
+                     ::close(retry_fd_);
+                     retry_fd_ = -1;
+                     if (!open_socket()) fail(std::string());
+                 });
+    if (!armed) {
+        if (retry_fd_ >= 0) ::close(retry_fd_);
+        retry_fd_ = -1;
+        state_ = State::CLOSED;
+        if (callbacks_.on_disconnected) callbacks_.on_disconnected();
+        return;
+    }
+    if (callbacks_.on_reconnecting) callbacks_.on_reconnecting(attempt_, static_cast<int>(delay));
+}
+
+void SocketSession::on_events(uint32_t events) {
+    if (state_ == State::CONNECTING) {
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        finish_connect();
+        if (state_ != State::OPEN) return;
+    }
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        if (!read_frames()) return;
+    }
+    if ((events & EPOLLOUT) && state_ == State::OPEN) flush();
+}
+
+void SocketSession::finish_connect() {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+        fail("Failed to connect to server");
+        return;
+    }
+    state_ = State::OPEN;
+    established_ = true;
+    attempt_ = 0;
+    if (!flush()) return;
+    if (callbacks_.on_connected) callbacks_.on_connected();
+}
+
+bool SocketSession::queue(const Message& msg) {
+    if (out_.size() - out_sent_ > kMaxPendingBytes) return false;
+
+    char frame[MAX_FRAME_LEN + 4];
+    size_t len = ChatUtils::encode_frame(msg, frame, sizeof(frame), msg.uid ? NameForm::IDS : NameForm::NAMES);
+    if (len == 0) return false;
+    out_.append(frame, len);
+
+    // Straight to the kernel unless we are still connecting or already backed up
+    if (state_ == State::OPEN && !want_write_) return flush();
+    return true;
+}
+
+bool SocketSession::flush() {
+    while (out_sent_ < out_.size()) {
+        ssize_t sent = ::send(fd_, out_.data() + out_sent_, out_.size() - out_sent_, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch_writable(true);
+                return true;
+            }
+            fail("Failed to send message");
+            return false;
+        }
+        out_sent_ += static_cast<size_t>(sent);
+    }
+    out_.clear();  // Keeps its capacity
+    out_sent_ = 0;
+    watch_writable(false);
+    return true;
+}
+
+void SocketSession::watch_writable(bool on) {
+    if (want_write_ == on) return;
+    want_write_ = on;
+    loop_.modify(fd_, on ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+}
+
+bool SocketSession::read_frames() {
+    for (;;) {
+        if (in_end_ == in_.size()) {
+            // Slide the partial frame to the front
+            std::memmove(in_.data(), in_.data() + in_start_, in_end_ - in_start_);
+            in_end_ -= in_start_;
+            in_start_ = 0;
+        }
+
+        ssize_t n = recv(fd_, in_.data() + in_end_, in_.size() - in_end_, 0);
+        if (n == 0) {
+            fail(std::string());
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            fail("Failed to receive message");
+            return false;
+        }
+        in_end_ += static_cast<size_t>(n);
+
+        while (in_end_ - in_start_ >= 4) {
+            uint32_t len_net;
+            std::memcpy(&len_net, in_.data() + in_start_, sizeof(len_net));
+            uint32_t prefix = ntohl(len_net);
+            bool compressed = prefix & FRAME_COMPRESSED;
+            size_t len = prefix & ~FRAME_COMPRESSED;
+            if (len > (compressed ? MAX_COMPRESSED_LEN : MAX_FRAME_LEN) || (compressed && !compress_)) {
+                fail("Oversized frame from server");
+                return false;
+            }
+            if (in_end_ - in_start_ < 4 + len) break;
+
+            const char* payload = in_.data() + in_start_ + 4;
+            in_start_ += 4 + len;
+            if (compressed) {
+                if (!on_batch(payload, len)) return false;
+            } else if (!on_frame(payload, len)) {
+                return false;
+            }
+        }
+        if (in_start_ == in_end_) in_start_ = in_end_ = 0;
+    }
+}
+
+bool SocketSession::on_batch(const char* data, size_t len) {
+    // One block of the connection's deflate stream: whole frames inside
+    if (!inflater_) {
+        inflater_.reset(new ChatUtils::InflateStream());
+        inflated_.resize(MAX_BATCH_LEN + 1);
+    }
+    long n = inflater_->inflate_block(data, len, inflated_.data(), inflated_.size());
+    if (n < 0) {
+        fail("Corrupt compressed batch from server");
+        return false;
+    }
+    size_t at = 0, end = static_cast<size_t>(n);
+    while (end - at >= 4) {
+        uint32_t len_net;
+        std::memcpy(&len_net, inflated_.data() + at, sizeof(len_net));
+        size_t frame_len = ntohl(len_net);
+        if (frame_len > MAX_FRAME_LEN || end - at - 4 < frame_len) break;
+        at += 4 + frame_len;
+        if (!on_frame(inflated_.data() + at - frame_len, frame_len)) return false;
+    }
+    if (at != end) {
+        fail("Malformed compressed batch from server");
+        return false;
+    }
+    return true;
+}
+
+bool SocketSession::resolve(uint32_t id, char* name, size_t cap) {
+    if (!id) return true;
+    if (name[0]) return names_.bind(id, name);
+    const char* bound = names_.find(id);
+    if (!bound) return false;
+    std::strncpy(name, bound, cap - 1);
+    return true;
+}
+
+bool SocketSession::on_frame(const char* payload, size_t len) {
+    Message msg;
+    if (len > 0 && payload[len - 1] == MESSAGE_SEPARATOR) len--;
+    Message::parse(payload, len, msg);
+
+    // Keep-alives are answered here and never reach the callbacks
+    if (msg.heartbeat) {
+        if (msg.heartbeat == HEARTBEAT_PING) {
+            Message pong = make_message("");
+            pong.heartbeat = HEARTBEAT_PONG;
+            queue(pong);
+        }
+        return true;
+    }
+
+    // Names the server has already bound arrive as ids
+    if (!resolve(msg.uid, msg.user, MAX_USERNAME_LEN) || !resolve(msg.rid, msg.room, MAX_ROOMNAME_LEN)) {
+        fail("Unknown name id from server");
+        return false;
+    }
+    if (msg.uid && !self_id_ && username_ == msg.user) self_id_ = msg.uid;
+
+    if (msg.seq) {
+        // With a filter set, skipped seqs are the server's doing
+        if (last_seq_ && msg.seq > last_seq_ + 1 && filter_.empty()) {
+            missed_ += msg.seq - last_seq_ - 1;
+            LOG_WARN("SocketSession", "Sequence gap: ", last_seq_, " -> ", msg.seq);
+        }
+        last_seq_ = msg.seq;
+    }
+    if (callbacks_.on_message) callbacks_.on_message(msg);
+    return state_ == State::OPEN;  // Closed from the callback
+}
+
+}  // namespace ChatClient
@@ -0,0 +1,135 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Non-blocking TCP chat session (System A)
+ */
+
+#ifndef CHATCLIENT_SOCKET_SESSION_H
+#define CHATCLIENT_SOCKET_SESSION_H
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "session.h"
+#include "../shared/compression.h"
+#include "../shared/intern_table.h"
+
+namespace ChatClient {
+
+// Exponential backoff between reconnect attempts, each delay jittered down
+// to as little as half so a room full of clients does not return in lockstep
+struct ReconnectPolicy {
+    int initial_delay_ms = 250;
+    int max_delay_ms = 10000;
+    int max_attempts = 0;  // In a row; 0 keeps trying until close()
+};
+
+/**
+ * connect() starts a non-blocking connect and queues the hello frame, so
+ * send() works immediately; frames go out as soon as the socket is
+ * writable. Incoming frames are cut out of one reusable buffer and parsed
+ * in place, so the steady state does not allocate. Each session costs one
+ * fd and a few KiB (some 100 KiB once the server has sent it a compressed
+ * batch; see set_compression()), so thousands share a loop comfortably.
+ */
+class SocketSession : public Session {
+public:
+    SocketSession(EventLoop& loop, Callbacks callbacks);
+    ~SocketSession() override;
+
+    // Start connecting; false if it failed before anything was queued
+    bool connect(const std::string& host, int port, const std::string& username,
+                 const std::string& room = std::string());
+
+    // Once connected, survive drops: on_reconnecting instead of
+    // on_disconnected, then a fresh connect after the backoff. The new hello
+    // carries the last seq seen, the server replays what it still holds
+    // after it, and on_connected fires again when the socket is back.
+    void set_reconnect(const ReconnectPolicy& policy);
+
+    bool send(const std::string& text) override;
+    // A direct message: the server hands it to `user` alone
+    bool send_to(const std::string& user, const std::string& text);
+    // Only receive room messages matching `spec` (comma-separated keywords,
+    // "^word" for a prefix; empty: everything). Kept across reconnects.
+    bool set_filter(const std::string& spec);
+    // Latest state over completeness: when this connection falls behind,
+    // the server replaces the backlog with one "[System]" summary. Sent
+    // with the hello, so set it before connect().
+    void set_conflate(bool on) { conflate_ = on; }
+    // Offer compression in the hello (on by default): backlogs and resume
+    // replays then arrive as deflated batches. Set before connect().
+    void set_compression(bool on) { compress_ = on; }
+    // Ask for names by id in the hello (on by default): the server sends
+    // each sender and room name once per connection and its id after that,
+    // and so do we with our own name. Messages reach the callbacks with
+    // the names filled back in. Set before connect().
+    void set_interning(bool on) { intern_ = on; }
+    void close() override;
+    bool is_open() const override { return state_ != State::CLOSED; }
+    uint64_t missed() const override { return missed_.load(std::memory_order_relaxed); }
+
+    bool is_connected() const { return state_ == State::OPEN; }
+    int fd() const { return fd_; }
+    uint64_t last_seq() const { return last_seq_; }
+
+private:
+    enum class State { CLOSED, WAITING, CONNECTING, OPEN };  // WAITING: reconnect backoff
+
+    bool open_socket();
+    void drop_socket();
+    void schedule_reconnect();
+    void on_events(uint32_t events);
+    void finish_connect();
+    bool queue(const Message& msg);
+    bool flush();
+    bool read_frames();
+    // One frame's payload / one compressed batch; false once the session closed
+    bool on_frame(const char* payload, size_t len);
+    bool on_batch(const char* data, size_t len);
+    // Bind `id` to `name`, or fill an empty `name` in from its id; false for an unknown id
+    bool resolve(uint32_t id, char* name, size_t cap);
+    void fail(const std::string& error);
+    void watch_writable(bool on);
+
+    int fd_ = -1;
+    State state_ = State::CLOSED;
+    bool want_write_ = false;
+
+    std::string out_;  // Framed bytes not yet accepted by the kernel
+    size_t out_sent_ = 0;
+
+    std::vector<char> in_;  // Received bytes; frames are parsed from in_start_
+    size_t in_start_ = 0;
+    size_t in_end_ = 0;
+
+    std::unique_ptr<ChatUtils::InflateStream> inflater_;  // This connection's stream, from its first batch
+    std::vector<char> inflated_;
+
+    ChatUtils::NameDictionary names_;  // Ids this connection has bound
+
+    uint64_t last_seq_ = 0;
+    std::atomic<uint64_t> missed_{0};
+
+    // Reconnect state
+    std::string host_;
+    int port_ = 0;
+    std::string room_;
+    std::string filter_;  // Sent with every hello once set
+    bool conflate_ = false;
+    bool compress_ = true;
+    bool intern_ = true;
+    bool reconnect_ = false;
+    ReconnectPolicy policy_;
+    bool established_ = false;  // Connected at least once since connect()
+    int attempt_ = 0;           // Failed attempts in a row
+    int retry_fd_ = -1;         // timerfd for the pending attempt
+    std::minstd_rand rng_;
+};
+
+}  // namespace ChatClient
+
+#endif  // CHATCLIENT_SOCKET_SESSION_H
@@ -0,0 +1,110 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "capture_writer.h"
+#include "memory_pool.h"
+#include "../shared/common.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kBufferBytes = 64 * 1024;
+
+}  // namespace
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+
+    start_ns_ = ChatUtils::Clock::monotonic_ns();
+    char header[ChatUtils::kCaptureHeaderLen];
+    std::memcpy(header, ChatUtils::kCaptureMagic, sizeof(ChatUtils::kCaptureMagic));
+    ChatUtils::capture_put(header + 8, ChatUtils::Clock::realtime_ns(), 8);
+    buffer_.reserve(kBufferBytes + sizeof(Node));
+    buffer_.assign(header, sizeof(header));
+
+    // Enough nodes for a burst without going to malloc
+    ObjectPool<Node>::instance().reserve(256);
+    running_ = true;
+    thread_ = std::thread(&CaptureWriter::run, this);
+    return true;
+}
+
+void CaptureWriter::close() {
+    if (running_.exchange(false) && thread_.joinable()) thread_.join();
+    if (fd_ < 0) return;
+    drain();
+    write_out();
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void CaptureWriter::record(ChatUtils::CaptureRecord::Kind kind, uint32_t connection, const char* payload, size_t len) {
+    if (queued_.fetch_add(1, std::memory_order_relaxed) >= kMaxQueued) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Node* node = ObjectPool<Node>::instance().create();
+    node->ns = ChatUtils::Clock::monotonic_ns() - start_ns_;
+    node->connection = connection;
+    node->kind = kind;
+    node->len = static_cast<uint16_t>(std::min(len, sizeof(node->payload)));
+    std::memcpy(node->payload, payload, node->len);
+    queue_.push(node);
+}
+
+void CaptureWriter::run() {
+    while (running_.load(std::memory_order_relaxed)) {
+        if (drain() == 0) {
+            // Idle: push out what we have so a crash loses little
+            write_out();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+}
+
+// Move queued nodes into the buffer, writing whenever it fills
+size_t CaptureWriter::drain() {
+    size_t n = 0;
+    while (Node* node = queue_.pop()) {
+        char header[ChatUtils::kCaptureRecordHeaderLen];
+        ChatUtils::capture_put(header, node->ns, 8);
+        ChatUtils::capture_put(header + 8, node->connection, 4);
+        ChatUtils::capture_put(header + 12, node->kind, 2);
+        ChatUtils::capture_put(header + 14, node->len, 2);
+        buffer_.append(header, sizeof(header));
+        buffer_.append(node->payload, node->len);
+        ObjectPool<Node>::instance().destroy(node);
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+        ++n;
+        if (buffer_.size() >= kBufferBytes) write_out();
+    }
+    return n;
+}
+
+void CaptureWriter::write_out() {
+    size_t off = 0;
+    while (off < buffer_.size()) {
+        ssize_t n = ::write(fd_, buffer_.data() + off, buffer_.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("Capture", "write failed: ", strerror(errno));
+            break;
+        }
+        off += static_cast<size_t>(n);
+    }
+    buffer_.clear();
+}
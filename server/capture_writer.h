@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Append-only recorder of inbound frames for later replay
+ */
+
+#ifndef CAPTURE_WRITER_H
+#define CAPTURE_WRITER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "mpsc_queue.h"
+#include "../shared/capture.h"
+#include "../shared/protocol.h"
+
+/**
+ * Handler threads call record(): the frame is copied into a pooled node
+ * and pushed onto a lock-free queue, nothing more. A writer thread batches
+ * the nodes into a 64 KiB buffer and writes it out, so the socket path
+ * never waits for the disk. If the writer falls too far behind, frames are
+ * dropped and counted rather than queued without bound.
+ */
+class CaptureWriter {
+public:
+    static constexpr size_t kMaxQueued = 4096;
+
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Create/truncate `path`, write the header and start the writer thread
+    bool open(const std::string& path);
+
+    // Flush everything queued and close the file
+    void close();
+
+    void record(ChatUtils::CaptureRecord::Kind kind, uint32_t connection, const char* payload, size_t len);
+
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Node : MpscNode {
+        uint64_t ns;
+        uint32_t connection;
+        uint16_t kind;
+        uint16_t len;
+        char payload[MAX_FRAME_LEN];
+    };
+
+    void run();
+    size_t drain();
+    void write_out();
+
+    int fd_ = -1;
+    uint64_t start_ns_ = 0;  // Monotonic; record times are relative to it
+    MpscQueue<Node> queue_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<uint64_t> recorded_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    std::string buffer_;  // Writer thread only
+};
+
+#endif  // CAPTURE_WRITER_H
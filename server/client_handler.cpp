@@ -4,18 +4,41 @@
  */
 
 #include "client_handler.h"
+#include "frame_forms.h"
+#include "metrics.h"
+#include "room.h"
+#include "server_context.h"
+#include "tracer.h"
 #include "../shared/common.h"
+#include <arpa/inet.h>
+#include <sys/socket.h>
 #include <unistd.h>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <chrono>
 
 using namespace ChatUtils;
 
-// Forward declaration (defined in server.cpp)
-extern void broadcast_message(const Message& msg, int exclude_client_id);
+// Messages processed per strand run before yielding the worker to other clients
+static const int STRAND_BATCH = 32;
 
-ClientHandler::ClientHandler(int socket_fd, int client_id)
-    : socket_fd_(socket_fd), client_id_(client_id), 
-      connected_(false), should_stop_(false) {}
+// Bounded copy into a fixed-size Message field, sized from the field itself
+template <size_t N>
+static void copy_field(char (&field)[N], const char* value) {
+    strncpy(field, value, N - 1);
+    field[N - 1] = '\0';
+}
+
+ClientHandler::ClientHandler(int socket_fd, int client_id, ServerContext& context)
+    : socket_fd_(socket_fd), client_id_(client_id), context_(context),
+      connected_(false), should_stop_(false), finished_(false),
+      last_read_ns_(ChatUtils::Clock::monotonic_ns()),
+      strand_scheduled_(false), strand_active_(0) {
+    const RateLimits& limits = context_.limits;
+    rate_.configure(limits.client_rate, RateLimits::burst_or_rate(limits.client_burst, limits.client_rate));
+    ip_rate_ = context_.ip_buckets.bucket_for(socket_fd_, limits);
+}
 
 ClientHandler::~ClientHandler() {
     stop();
@@ -25,6 +48,7 @@ ClientHandler::~ClientHandler() {
 }
 
 void ClientHandler::start() {
+    context_.idle.watch(this, idle_entry_);
     handler_thread_ = std::thread(&ClientHandler::run, this);
 }
 
@@ -33,48 +57,558 @@ void ClientHandler::stop() {
     if (handler_thread_.joinable()) {
         handler_thread_.join();
     }
+#ifdef CHAT_COROUTINES
+    // A parked coroutine wakes up to a failed read and finishes on its loop
+    if (loop_ && socket_fd_ >= 0) shutdown(socket_fd_, SHUT_RD);
+#endif
 }
 
 bool ClientHandler::send_message(const Message& msg) {
+    char frame[MAX_FRAME_LEN + 4];
+    size_t len = ChatUtils::encode_frame(msg, frame, sizeof(frame));
+    return len && enqueue(Outbox::lane_for(msg), frame, len, nullptr);
+}
+
+bool ClientHandler::try_ping() {
+    Message ping;
+    copy_field(ping.user, "[System]");
+    ping.heartbeat = HEARTBEAT_PING;
+    return send_message(ping);
+}
+
+void ClientHandler::reap() {
+    // Wakes the blocked read with an error
+    shutdown(socket_fd_, SHUT_RDWR);
+}
+
+bool ClientHandler::send_frame(const FrameRef& frame) {
+    return enqueue(Outbox::ROOM, frame->data(), frame->size(), &frame);
+}
+
+bool ClientHandler::send_frame(const char* frame, size_t len) {
+    return enqueue(Outbox::ROOM, frame, len, nullptr);
+}
+
+bool ClientHandler::send_frame(FrameForms& forms) {
+    if (!intern_) return send_frame(forms.get(NameForm::NAMES));
+    if (!connected_) return false;
+
+    // Names go in full until this connection has had them once. Only the
+    // room lane sends ids alone: it is FIFO, so the binding arrives first.
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (outbox_closed_) return false;
+    const Message& msg = forms.message();
+    bool fresh = bound_.insert(msg.uid);
+    fresh = bound_.insert(msg.rid) || fresh;
+    const FrameRef& frame = forms.get(fresh ? NameForm::BIND : NameForm::IDS);
+    return frame && write_or_queue(Outbox::ROOM, frame->data(), frame->size(), &frame);
+}
+
+// A pooled copy of bytes that have to wait
+static FrameRef pooled_copy(const char* data, size_t len) {
+    FrameRef copy(FrameBuffer::acquire(len));
+    if (copy) {
+        std::memcpy(copy->data(), data, len);
+        copy->set_size(len);
+    }
+    return copy;
+}
+
+bool ClientHandler::enqueue(Outbox::Lane lane, const char* frame, size_t len, const FrameRef* shared) {
     if (!connected_) return false;
 
     std::lock_guard<std::mutex> lock(send_mutex_);
-    return ChatUtils::send_message(socket_fd_, msg);
+    if (outbox_closed_) return false;
+    return write_or_queue(lane, frame, len, shared);
+}
+
+bool ClientHandler::write_or_queue(Outbox::Lane lane, const char* frame, size_t len, const FrameRef* shared) {
+    if (!write_armed_ && !batching_) {
+        // Nothing queued ahead: straight to the socket
+        ssize_t n = ChatUtils::send_some(socket_fd_, frame, len);
+        if (n < 0) {
+            Metrics::global().add(Counter::SEND_FAILURES);
+            close_outbox();
+            return false;
+        }
+        size_t written = static_cast<size_t>(n);
+        if (written == len) {
+            sent(len, 1);
+            return true;
+        }
+
+        // Partly written: the rest goes first once the socket drains
+        sending_ = shared ? *shared : pooled_copy(frame, len);
+        sending_offset_ = written;
+        sending_frames_ = 1;
+        write_armed_ = true;
+        Metrics::global().add(Counter::SEND_QUEUED);
+        context_.sends.arm(socket_fd_, client_id_, weak_from_this());
+        return true;
+    }
+
+    if (conflate_ && lane == Outbox::ROOM && outbox_.frames(Outbox::ROOM) &&
+        outbox_.bytes() + len > context_.conflate_after) {
+        conflate();
+    }
+    if (outbox_.bytes() + len > context_.outbox_limit) {
+        // The reader has fallen too far behind; it can resume after reconnecting
+        Metrics::global().add(Counter::SLOW_CONSUMERS);
+        LOG_WARN("ClientHandler", "Client ", client_id_, " (", username_, ") has ", outbox_.bytes(),
+                 " bytes queued, disconnecting");
+        Metrics::global().add(Counter::SEND_FAILURES);
+        close_outbox();
+        reap();
+        return false;
+    }
+
+    FrameRef held = shared ? *shared : pooled_copy(frame, len);
+    if (!held) return false;
+    Metrics::global().add(Counter::SEND_QUEUED);
+    outbox_.push(lane, std::move(held));
+    outbox_bytes_.store(outbox_.bytes(), std::memory_order_relaxed);
+    return true;
+}
+
+void ClientHandler::begin_batch() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    batching_ = true;
+}
+
+void ClientHandler::end_batch() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    batching_ = false;
+    if (outbox_closed_ || write_armed_ || outbox_.empty()) return;
+    write_armed_ = true;  // flush() owns the socket until the outbox is empty
+    flush();
+}
+
+void ClientHandler::conflate() {
+    // The newest frame dropped says where the room's stream had got to
+    FrameRef newest;
+    size_t dropped = outbox_.drop(Outbox::ROOM, &newest);
+    uint64_t skipped = dropped;
+    if (summary_) skipped += summary_covers_ - 1;  // An earlier summary went too
+    Metrics::global().add(Counter::CONFLATED, dropped - (summary_ ? 1 : 0));
+    summary_ = nullptr;
+    bound_.clear();  // Dropped frames may have carried bindings; send names afresh
+    Message last;
+    Message::parse(newest->data() + 4, newest->size() - 4, last);
+
+    Message summary;
+    copy_field(summary.user, "[System]");
+    copy_field(summary.room, room_->name().c_str());
+    summary.seq = last.seq;
+    Message::format_timestamp(summary.timestamp, MAX_TIMESTAMP_LEN);
+    std::snprintf(summary.text, MAX_MESSAGE_LEN, "%llu messages skipped, last seq %llu",
+                  static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(last.seq));
+    FrameRef frame(FrameBuffer::acquire(MAX_FRAME_LEN + 4));
+    if (frame) {
+        frame->set_size(ChatUtils::encode_frame(summary, frame->data(), frame->capacity()));
+        summary_ = frame.get();
+        summary_covers_ = skipped;
+        outbox_.push(Outbox::ROOM, std::move(frame));
+    }
+    outbox_bytes_.store(outbox_.bytes(), std::memory_order_relaxed);
+}
+
+void ClientHandler::on_writable() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (outbox_closed_) return;
+    flush();
+}
+
+void ClientHandler::flush() {
+    for (;;) {
+        if (!sending_) {
+            // A backlog worth compressing goes as one batch
+            bool batch = deflate_ && !outbox_.empty() && outbox_.bytes() >= context_.compress_min;
+            sending_ = batch ? pack_batch() : outbox_.pop();
+            sending_offset_ = 0;
+            if (!batch) sending_frames_ = 1;
+            if (sending_ && sending_.get() == summary_) summary_ = nullptr;  // On its way now
+            outbox_bytes_.store(outbox_.bytes(), std::memory_order_relaxed);
+            if (!sending_) {
+                if (batch) {
+                    close_outbox();  // Frames were taken but could not be packed
+                    reap();
+                    return;
+                }
+                write_armed_ = false;
+                return;
+            }
+        }
+        size_t len = sending_->size();
+        ssize_t n = ChatUtils::send_some(socket_fd_, sending_->data() + sending_offset_, len - sending_offset_);
+        if (n < 0) {
+            close_outbox();
+            return;
+        }
+        sending_offset_ += static_cast<size_t>(n);
+        if (sending_offset_ < len) {
+            context_.sends.arm(socket_fd_, client_id_, weak_from_this());
+            return;
+        }
+        sent(len, sending_frames_);
+        sending_.reset();
+    }
+}
+
+FrameRef ClientHandler::pack_batch() {
+    if (!deflater_) deflater_.reset(new ChatUtils::DeflateStream(context_.compress_level));
+    FrameRef batch(FrameBuffer::acquire(4 + MAX_COMPRESSED_LEN));
+    if (!batch) return batch;
+
+    // Whole frames in outbox order, up to MAX_BATCH_LEN inflated
+    ChatUtils::DeflateStream& stream = *deflater_;
+    stream.begin(batch->data() + 4, MAX_COMPRESSED_LEN);
+    size_t raw = 0;
+    sending_frames_ = 0;
+    while (raw + MAX_FRAME_LEN + 4 <= MAX_BATCH_LEN) {
+        FrameRef frame = outbox_.pop();
+        if (!frame) break;
+        if (frame.get() == summary_) summary_ = nullptr;
+        if (!stream.write(frame->data(), frame->size())) return FrameRef();
+        raw += frame->size();
+        sending_frames_++;
+    }
+    size_t packed = stream.end();
+    if (!packed) return FrameRef();
+
+    uint32_t prefix = htonl(static_cast<uint32_t>(packed) | FRAME_COMPRESSED);
+    std::memcpy(batch->data(), &prefix, sizeof(prefix));
+    batch->set_size(4 + packed);
+    Metrics& metrics = Metrics::global();
+    metrics.add(Counter::COMPRESSED_BATCHES);
+    if (raw > 4 + packed) metrics.add(Counter::COMPRESSION_SAVED, raw - 4 - packed);
+    return batch;
+}
+
+void ClientHandler::sent(size_t len, size_t frames) {
+    Metrics& metrics = Metrics::global();
+    metrics.add(Counter::FRAMES_OUT, frames);
+    metrics.add(Counter::BYTES_OUT, len);
+}
+
+void ClientHandler::close_outbox() {
+    if (outbox_closed_) return;
+    size_t dropped = outbox_.frames() + (sending_ ? 1 : 0);
+    if (dropped) Metrics::global().add(Counter::SEND_FAILURES, dropped);
+    outbox_closed_ = true;
+    outbox_.clear();
+    summary_ = nullptr;
+    sending_.reset();
+    outbox_bytes_.store(0, std::memory_order_relaxed);
 }
 
 void ClientHandler::run() {
     // First, receive username
     if (!receive_username()) {
-        LOG_WARN("ClientHandler", "Failed to receive username from client " + std::to_string(client_id_));
+        LOG_WARN("ClientHandler", "Failed to receive username from client ", client_id_);
+        finish();
         return;
     }
 
-    connected_ = true;
-    LOG_INFO("ClientHandler", "Client " + std::to_string(client_id_) + " connected as \"" + username_ + "\"");
+    if (Tracer::global().sample_every()) {
+        Tracer::global().set_thread_name("client " + std::to_string(client_id_));
+    }
+
+    on_joined();
 
     // Then enter message loop
     message_loop();
 
-    connected_ = false;
-    LOG_INFO("ClientHandler", "Client " + std::to_string(client_id_) + " (" + username_ + ") disconnected");
+    // Let queued messages reach the room before we leave it
+    wait_for_strand();
+
+    on_left();
+    finish();
 }
 
 bool ClientHandler::receive_username() {
-    Message msg;
-    if (!ChatUtils::recv_message(socket_fd_, msg)) {
+    size_t len = 0;
+    if (!ChatUtils::recv_frame(socket_fd_, recv_buffer_, len)) {
         return false;
     }
+    return accept_hello(len);
+}
+
+bool ClientHandler::accept_hello(size_t len) {
+    Message msg;
+    Message::parse(recv_buffer_, len, msg);
+    last_read_ns_.store(ChatUtils::Clock::monotonic_ns(), std::memory_order_relaxed);
     username_ = msg.user;
+    room_ = context_.rooms.get_or_create(msg.room[0] ? msg.room : DEFAULT_ROOM);
+    resume_after_ = msg.seq;
+    conflate_ = msg.conflate;
+    deflate_ = msg.deflate && context_.compress;
+    intern_ = msg.intern && context_.intern;
+    if (context_.intern) {
+        user_id_ = context_.names.intern(username_);
+        room_id_ = context_.names.intern(room_->name());
+    }
+    if (msg.filter && !username_.empty()) room_->set_filter(client_id_, msg.text);
+    if (context_.capture && !username_.empty()) {
+        char json[MAX_FRAME_LEN];
+        size_t json_len = msg.encode(json, sizeof(json));
+        context_.capture->record(ChatUtils::CaptureRecord::HELLO, static_cast<uint32_t>(client_id_), json, json_len);
+    }
     return !username_.empty();
 }
 
+void ClientHandler::on_joined() {
+    connected_ = true;
+    context_.users.add(username_, shared_from_this());
+    room_->join(shared_from_this(), resume_after_);
+    Metrics::global().add(Counter::CONNECTS);
+    LOG_INFO("ClientHandler", "Client ", client_id_, " connected as \"", username_,
+             "\" in room \"", room_->name(), "\"");
+}
+
+void ClientHandler::on_left() {
+    connected_ = false;
+    context_.users.remove(username_, this);
+    room_->leave(client_id_);
+    if (context_.capture) {
+        context_.capture->record(ChatUtils::CaptureRecord::BYE, static_cast<uint32_t>(client_id_), nullptr, 0);
+    }
+    Metrics::global().add(Counter::DISCONNECTS);
+    LOG_INFO("ClientHandler", "Client ", client_id_, " (", username_, ") disconnected");
+}
+
 void ClientHandler::message_loop() {
+    // Steady state allocates nothing: frames land in recv_buffer_ and are
+    // parsed in place
     Message msg;
-    while (!should_stop_ && ChatUtils::recv_message(socket_fd_, msg)) {
-        // Update timestamp
-        strncpy(msg.timestamp, Message::get_current_timestamp().c_str(), MAX_TIMESTAMP_LEN - 1);
-        
-        // Broadcast to all clients except sender
-        broadcast_message(msg, client_id_);
+    size_t len = 0;
+    uint64_t prefix_ns = 0;
+    while (!should_stop_ && ChatUtils::recv_frame(socket_fd_, recv_buffer_, len, &prefix_ns)) {
+        // Read now, however long the rate limit holds it: not idle
+        last_read_ns_.store(prefix_ns, std::memory_order_relaxed);
+        throttle();
+        decode_frame(len, prefix_ns, msg);
+        if (handle_heartbeat(msg)) continue;
+        ingest(msg);
+    }
+}
+
+uint64_t ClientHandler::admission_wait() {
+    // Each bucket is charged once per frame, however long it waits
+    uint64_t now = ChatUtils::Clock::monotonic_ns();
+    uint64_t wait = 0;
+    if (!client_admitted_) {
+        wait = rate_.take(now);
+        client_admitted_ = wait == 0;
+    }
+    if (!wait && ip_rate_) wait = ip_rate_->take(now);
+
+    if (!wait) {
+        client_admitted_ = throttled_ = false;
+    } else if (!throttled_) {
+        throttled_ = true;
+        Metrics::global().add(Counter::THROTTLED);
+    }
+    return wait;
+}
+
+void ClientHandler::throttle() {
+    while (uint64_t wait = admission_wait()) {
+        if (should_stop_) return;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+}
+
+void ClientHandler::decode_frame(size_t len, uint64_t prefix_ns, Message& msg) {
+    Metrics& metrics = Metrics::global();
+    Tracer& tracer = Tracer::global();
+    uint64_t read_ns = ChatUtils::Clock::monotonic_ns();
+    Message::parse(recv_buffer_, len, msg);
+    msg.ingress_ns = ChatUtils::Clock::monotonic_ns();
+    msg.trace_id = tracer.sample();
+    if (msg.trace_id) {
+        tracer.record(msg.trace_id, "read", prefix_ns, read_ns, client_id_);
+        tracer.record(msg.trace_id, "decode", read_ns, msg.ingress_ns);
+    }
+    metrics.add(Counter::FRAMES_IN);
+    metrics.add(Counter::BYTES_IN, len + 4);
+    if (context_.capture) {
+        context_.capture->record(ChatUtils::CaptureRecord::FRAME, static_cast<uint32_t>(client_id_), recv_buffer_, len);
+    }
+    copy_field(msg.room, room_->name().c_str());
+    msg.rid = room_id_;
+    msg.seq = 0;
+}
+
+bool ClientHandler::handle_heartbeat(const Message& msg) {
+    // Reading it already refreshed last_read_ns_; a ping is answered in kind
+    if (!msg.heartbeat) return false;
+    if (msg.heartbeat == HEARTBEAT_PING) {
+        Message pong;
+        copy_field(pong.user, "[System]");
+        pong.heartbeat = HEARTBEAT_PONG;
+        send_message(pong);
+    }
+    return true;
+}
+
+void ClientHandler::finish() {
+    context_.idle.unwatch(idle_entry_);
+    {
+        // Whatever is still queued has nobody left to read it
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        close_outbox();
+    }
+    context_.sends.forget(socket_fd_, client_id_);
+    finished_ = true;
+}
+
+void ClientHandler::ingest(const Message& msg) {
+    // Inbox full: stop reading until the strand catches up (TCP backpressure)
+    while (!try_ingest(msg)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+bool ClientHandler::try_ingest(const Message& msg) {
+    if (!context_.pool) {
+        Message copy = msg;
+        process_message(copy);
+        return true;
+    }
+
+    if (!inbox_.push(msg)) return false;
+    if (!strand_scheduled_.exchange(true)) {
+        context_.pool->submit(static_cast<PoolTask*>(this));
+    }
+    return true;
+}
+
+void ClientHandler::process_message(Message& msg) {
+    // Timestamp, validation and any registered hooks, then the room's sequencer
+    ArenaScope scratch;
+    if (msg.trace_id) {
+        Tracer::global().record(msg.trace_id, "queue", msg.ingress_ns, ChatUtils::Clock::monotonic_ns());
     }
+    if (msg.filter) {
+        // A subscription change, not chat: nothing to validate or publish
+        room_->set_filter(client_id_, msg.text);
+        return;
+    }
+    bool accepted;
+    {
+        TraceSpan span(msg.trace_id, "stages");
+        accepted = context_.pipeline.process(msg, *this);
+    }
+    if (accepted) {
+        if (msg.to[0]) {
+            deliver_direct(msg);
+        } else {
+            room_->publish(msg, client_id_);
+        }
+    } else {
+        Metrics::global().add(Counter::DROPPED);
+    }
+}
+
+void ClientHandler::deliver_direct(const Message& msg) {
+    // Straight to the recipient's socket: no room, no sequencer, no fan-out
+    TraceSpan span(msg.trace_id, "direct");
+    std::shared_ptr<ClientHandler> target = context_.users.find(msg.to);
+    if (target && target->send_message(msg)) {
+        Metrics::global().add(Counter::DIRECT);
+        if (msg.ingress_ns) {
+            Metrics::global().record(Histogram::DIRECT_LATENCY, ChatUtils::Clock::monotonic_ns() - msg.ingress_ns);
+        }
+        return;
+    }
+
+    Metrics::global().add(Counter::DIRECT_MISSES);
+    Message notice;
+    copy_field(notice.user, "[System]");
+    copy_field(notice.to, username_.c_str());
+    copy_field(notice.room, msg.room);
+    Message::format_timestamp(notice.timestamp, MAX_TIMESTAMP_LEN);
+    std::snprintf(notice.text, MAX_MESSAGE_LEN, "%s is not online", msg.to);
+    send_message(notice);
+}
+
+void ClientHandler::execute() {
+    strand_active_.fetch_add(1);
+
+    Message msg;
+    for (int i = 0; i < STRAND_BATCH && inbox_.pop(msg); ++i) {
+        process_message(msg);
+    }
+
+    if (!inbox_.empty()) {
+        // More waiting: stay scheduled, but behind the strands already queued
+        context_.pool->yield(static_cast<PoolTask*>(this));
+    } else {
+        strand_scheduled_.store(false);
+        // A push may have raced with the store above and seen us still scheduled
+        if (!inbox_.empty() && !strand_scheduled_.exchange(true)) {
+            context_.pool->submit(static_cast<PoolTask*>(this));
+        }
+    }
+
+    // Last touch of this object: wait_for_strand() may free it after this
+    strand_active_.fetch_sub(1);
+}
+
+void ClientHandler::wait_for_strand() {
+    while (!strand_idle()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool ClientHandler::strand_idle() const {
+    if (!context_.pool) return true;
+    return !strand_scheduled_.load() && strand_active_.load() == 0 && inbox_.empty();
+}
+
+#ifdef CHAT_COROUTINES
+void ClientHandler::start(ChatClient::EventLoop& loop) {
+    loop_ = &loop;
+    context_.idle.watch(this, idle_entry_);
+    std::shared_ptr<ClientHandler> self = shared_from_this();
+    loop.post([self, &loop]() { ChatClient::spawn(self->serve(loop)); });
+}
+
+ChatClient::Task<void> ClientHandler::serve(ChatClient::EventLoop& loop) {
+    // run() with every wait a suspension: the same steps, no thread of our own
+    std::shared_ptr<ClientHandler> self = shared_from_this();
+    ChatClient::Connection conn(loop);
+    size_t len = 0;
+    // Each co_await is its own statement: GCC 12 miscompiles co_await
+    // inside && / || chains
+    bool hello = conn.attach(socket_fd_);
+    if (hello) hello = co_await conn.read_frame(recv_buffer_, len);
+    if (!hello || !accept_hello(len)) {
+        LOG_WARN("ClientHandler", "Failed to receive username from client ", client_id_);
+        finish();
+        co_return;
+    }
+
+    on_joined();
+
+    Message msg;
+    while (!should_stop_) {
+        if (!co_await conn.read_frame(recv_buffer_, len)) break;
+        uint64_t read_ns = ChatUtils::Clock::monotonic_ns();
+        last_read_ns_.store(read_ns, std::memory_order_relaxed);
+        // Over the rate: park without reading, the socket's window fills up
+        while (uint64_t wait = admission_wait()) {
+            co_await ChatClient::sleep_for(loop, static_cast<int>(wait / 1000000 + 1));
+        }
+        decode_frame(len, read_ns, msg);
+        if (handle_heartbeat(msg)) continue;
+        // Inbox full: stop reading (TCP backpressure) but let other sessions run
+        while (!try_ingest(msg)) co_await ChatClient::yield(loop);
+    }
+
+    while (!strand_idle()) co_await ChatClient::sleep_for(loop, 1);
+
+    on_left();
+    finish();
 }
+#endif
@@ -12,33 +12,103 @@
 #include <memory>
 #include <thread>
 #include <mutex>
-#include <queue>
 #include <atomic>
+#include "idle_monitor.h"
+#include "memory_pool.h"
+#include "outbox.h"
+#include "rate_limiter.h"
+#include "task_pool.h"
+#include "../shared/compression.h"
+#include "../shared/intern_table.h"
 #include "../shared/protocol.h"
+#include "../shared/spsc_queue.h"
+#ifdef CHAT_COROUTINES
+#include "../libchatclient/coro_io.h"
+#endif
 
-// Forward declaration for broadcast
-void broadcast_message(const Message& msg, int exclude_client_id = -1);
+class FrameForms;
+class Room;
+struct ServerContext;
 
-class ClientHandler {
+/**
+ * One thread per connection does the blocking reads. Everything after the
+ * read runs as this client's strand on the server's TaskPool: the ingest
+ * thread pushes into a small SPSC inbox and schedules the strand, which
+ * runs the pipeline stages and publishes to the room. At most one strand
+ * run per client is in flight, so a client's messages keep their order
+ * while different clients spread across cores.
+ *
+ * Any thread may send (room fan-out, direct messages, the idle monitor's
+ * pings); sends never block and are serialised by send_mutex_. What the
+ * socket cannot take waits in the connection's Outbox until the SendPoller
+ * reports it writable, and a reader that lets too much pile up is cut off.
+ * A client over its message rate is simply not read from, so the kernel's
+ * receive window pushes back instead.
+ *
+ * Handlers are shared: the server, the room and the user directory hold
+ * references, and sends go through weak ones from the SendPoller. With
+ * CHAT_COROUTINES the reads can instead run as a coroutine on a
+ * ChatClient::EventLoop (start(loop)): the same steps as run(), but a
+ * connection waiting for data is a parked frame rather than a thread.
+ */
+class ClientHandler : public std::enable_shared_from_this<ClientHandler>, private PoolTask {
 public:
-    ClientHandler(int socket_fd, int client_id);
+    ClientHandler(int socket_fd, int client_id, ServerContext& context);
     ~ClientHandler();
 
     // Start the handler thread
     void start();
 
+#ifdef CHAT_COROUTINES
+    // Serve the connection as a coroutine on `loop` instead
+    void start(ChatClient::EventLoop& loop);
+#endif
+
     // Stop the handler (graceful shutdown)
     void stop();
 
     // Get client information
     int get_id() const { return client_id_; }
     const std::string& get_username() const { return username_; }
+    uint32_t get_user_id() const { return user_id_; }  // Interned at hello; 0 if the table is full
+    uint32_t get_room_id() const { return room_id_; }
     int get_socket() const { return socket_fd_; }
     bool is_connected() const { return connected_; }
 
-    // Send a message to this client
+    // The session is over (run() or serve() returned); safe to drop
+    bool is_finished() const { return finished_; }
+
+    // Messages read but not yet processed by the strand
+    size_t backlog() const { return inbox_.size(); }
+
+    // Send a message to this client (lane chosen by Outbox::lane_for)
     bool send_message(const Message& msg);
 
+    // Send an already-encoded room frame (shared by every recipient of a fan-out)
+    bool send_frame(const FrameRef& frame);
+    bool send_frame(const char* frame, size_t len);
+
+    // Send a fan-out's message in the NameForm this connection needs
+    bool send_frame(FrameForms& forms);
+
+    // Bytes waiting in the outbox for a slow socket
+    size_t outbox_bytes() const { return outbox_bytes_.load(std::memory_order_relaxed); }
+
+    // Queue everything sent between these two, then write it as one burst
+    // (compressed if the client offered it and it is large enough)
+    void begin_batch();
+    void end_batch();
+
+    // The SendPoller's callback: the socket has room again
+    void on_writable();
+
+    // For the IdleMonitor: when the last frame arrived, a ping (queued on
+    // the control lane, false if the connection is gone), and closing a
+    // dead peer
+    uint64_t last_read_ns() const { return last_read_ns_.load(std::memory_order_relaxed); }
+    bool try_ping();
+    void reap();
+
 private:
     // Thread function
     void run();
@@ -46,16 +116,124 @@ private:
     // Read username from client
     bool receive_username();
 
+    // Take user and room from the hello frame in recv_buffer_
+    bool accept_hello(size_t len);
+
+    // Room membership, metrics and logs at either end of the session
+    void on_joined();
+    void on_left();
+
     // Message loop
     void message_loop();
 
+    // 0 once the frame just read may go on; otherwise ns until a rate limit
+    // allows it. Nothing else is read meanwhile.
+    uint64_t admission_wait();
+    void throttle();
+
+    // Parse the frame in recv_buffer_ and stamp it for the pipeline
+    void decode_frame(size_t len, uint64_t prefix_ns, Message& msg);
+
+    // Answer or drop a keep-alive; true if `msg` was one
+    bool handle_heartbeat(const Message& msg);
+
+    // The session is over: off the idle monitor and the send poller, then finished_
+    void finish();
+
+    // Write `frame` now, or queue what does not fit on `lane`. `shared`, if
+    // given, holds the same bytes and is queued instead of a copy.
+    bool enqueue(Outbox::Lane lane, const char* frame, size_t len, const FrameRef* shared);
+    bool write_or_queue(Outbox::Lane lane, const char* frame, size_t len, const FrameRef* shared);  // send_mutex_ held
+
+    // Replace the queued room frames with a summary (send_mutex_ held)
+    void conflate();
+
+    // Write queued frames until the socket is full (send_mutex_ held)
+    void flush();
+
+    // Deflate queued frames into one compressed batch frame (send_mutex_ held)
+    FrameRef pack_batch();
+
+    // Account a frame fully written (`frames` of them inside a batch)
+    void sent(size_t len, size_t frames);
+
+    // The socket failed, overflowed or closed: drop the queue, accept no more
+    void close_outbox();
+
+    // Queue a received message for the strand (inline when there is no pool)
+    void ingest(const Message& msg);
+
+    // Same, but false instead of waiting when the inbox is full
+    bool try_ingest(const Message& msg);
+
+#ifdef CHAT_COROUTINES
+    ChatClient::Task<void> serve(ChatClient::EventLoop& loop);
+#endif
+
+    // Pipeline stages + publish for one message
+    void process_message(Message& msg);
+
+    // Send a direct message to its one recipient, or a notice back to us
+    void deliver_direct(const Message& msg);
+
+    // Strand body, runs on a TaskPool worker
+    void execute() override;
+
+    // Block until the strand has drained the inbox and gone idle
+    void wait_for_strand();
+    bool strand_idle() const;
+
     int socket_fd_;
     int client_id_;
     std::string username_;
+    uint32_t user_id_ = 0;
+    uint32_t room_id_ = 0;
+    ServerContext& context_;
+    std::shared_ptr<Room> room_;  // Joined from the first frame's "room" (default lobby)
+    uint64_t resume_after_ = 0;   // The first frame's "seq": last one seen before a reconnect
+    // The first frame's "conflate": past conflate_after, the room frames
+    // still queued collapse into one summary (conflate())
+    bool conflate_ = false;
+    // The first frame's "deflate", if the server compresses: a backlog of
+    // compress_min or more leaves as deflated batches, one stream per
+    // connection (deflater_)
+    bool deflate_ = false;
+    // The first frame's "intern", if the server sends ids: each sender and
+    // room name goes in full once, bound to its id, then the id alone
+    bool intern_ = false;
+    std::unique_ptr<ChatUtils::DeflateStream> deflater_;  // Created by the first batch; send_mutex_
     std::atomic<bool> connected_;
     std::atomic<bool> should_stop_;
+    std::atomic<bool> finished_;
+    std::atomic<uint64_t> last_read_ns_;  // Clock::monotonic_ns() of the last frame read
+    IdleMonitor::Entry idle_entry_;       // Guarded by the monitor
     std::thread handler_thread_;
-    std::mutex send_mutex_;  // Protect socket writes
+    std::mutex send_mutex_;  // Protect socket writes and everything below up to outbox_bytes_
+    Outbox outbox_;  // Control lane first, then room and direct by deficit round-robin
+    FrameRef sending_;          // Frame partly written; finished before anything else
+    size_t sending_offset_ = 0;
+    size_t sending_frames_ = 1;  // Frames inside sending_ (a batch holds several)
+    bool batching_ = false;      // Between begin_batch() and end_batch()
+    bool write_armed_ = false;  // Waiting on the SendPoller; true while anything is queued
+    bool outbox_closed_ = false;
+    const FrameBuffer* summary_ = nullptr;  // Conflation summary still queued, if any
+    uint64_t summary_covers_ = 0;           // ...and how many messages it stands for
+    ChatUtils::IdSet bound_;  // Ids sent with their names on the room lane (intern_); conflate() clears it
+    std::atomic<size_t> outbox_bytes_{0};
+    char recv_buffer_[MAX_FRAME_LEN];  // Handler thread only
+
+    TokenBucket rate_;                      // --client-rate; reader only
+    std::shared_ptr<TokenBucket> ip_rate_;  // --ip-rate, shared by the address's connections
+    bool client_admitted_ = false;          // The frame being held passed rate_ already
+    bool throttled_ = false;                // ...and was counted as throttled
+
+    SpscQueue<Message, 16> inbox_;       // Ingest thread -> strand
+    std::atomic<bool> strand_scheduled_;
+    std::atomic<int> strand_active_;
+
+#ifdef CHAT_COROUTINES
+    ChatClient::EventLoop* loop_ = nullptr;  // Set when served as a coroutine
+#endif
 };
 
 #endif  // CLIENT_HANDLER_H
@@ -0,0 +1,121 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "filter_matcher.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+static unsigned char fold(unsigned char c) {
+    return static_cast<unsigned char>(std::tolower(c));
+}
+
+std::vector<std::string> FilterMatcher::parse_spec(const char* spec) {
+    std::vector<std::string> patterns;
+    const char* p = spec;
+    while (*p) {
+        const char* comma = std::strchr(p, ',');
+        const char* end = comma ? comma : p + std::strlen(p);
+        const char* begin = p;
+        while (begin < end && std::isspace(static_cast<unsigned char>(*begin))) ++begin;
+        const char* stop = end;
+        while (stop > begin && std::isspace(static_cast<unsigned char>(*(stop - 1)))) --stop;
+        if (stop > begin && !(stop - begin == 1 && *begin == '^')) patterns.emplace_back(begin, stop);
+        p = comma ? comma + 1 : end;
+    }
+    return patterns;
+}
+
+FilterMatcher::FilterMatcher(std::vector<Subscription> subscriptions) {
+    std::sort(subscriptions.begin(), subscriptions.end(),
+              [](const Subscription& a, const Subscription& b) { return a.client_id < b.client_id; });
+
+    // One column per distinct (case-folded) byte used by some pattern
+    std::memset(classes_, 0, sizeof(classes_));
+    for (const Subscription& sub : subscriptions) {
+        for (const std::string& pattern : sub.patterns) {
+            for (size_t i = pattern[0] == '^' ? 1 : 0; i < pattern.size(); ++i) {
+                unsigned char c = fold(static_cast<unsigned char>(pattern[i]));
+                if (!classes_[c]) classes_[c] = static_cast<uint8_t>(alphabet_++);
+            }
+        }
+    }
+    for (int c = 0; c < 256; ++c) classes_[c] = classes_[fold(static_cast<unsigned char>(c))];
+
+    // Trie; 0 doubles as "no edge" since nothing points back at the root yet
+    next_.assign(alphabet_, 0);
+    std::vector<std::vector<Output>> own(1);
+    for (const Subscription& sub : subscriptions) {
+        uint32_t slot = static_cast<uint32_t>(clients_.size());
+        clients_.push_back(sub.client_id);
+        for (const std::string& pattern : sub.patterns) {
+            bool anchored = pattern[0] == '^';
+            uint32_t state = 0;
+            for (size_t i = anchored ? 1 : 0; i < pattern.size(); ++i) {
+                size_t edge = state * alphabet_ + classes_[static_cast<unsigned char>(pattern[i])];
+                if (!next_[edge]) {
+                    next_[edge] = static_cast<uint32_t>(own.size());
+                    own.emplace_back();
+                    next_.resize(next_.size() + alphabet_, 0);
+                }
+                state = next_[edge];
+            }
+            uint32_t anchored_len = anchored ? static_cast<uint32_t>(pattern.size() - 1) : 0;
+            if (state) own[state].push_back(Output{slot, anchored_len});
+        }
+    }
+
+    // Breadth-first: failure links, then missing edges filled in from them
+    // so the scan never backtracks
+    const size_t states = own.size();
+    std::vector<uint32_t> fail(states, 0);
+    dict_.assign(states, 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(states);
+    for (size_t c = 0; c < alphabet_; ++c) {
+        if (next_[c]) queue.push_back(next_[c]);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t s = queue[head];
+        for (size_t c = 0; c < alphabet_; ++c) {
+            uint32_t& edge = next_[s * alphabet_ + c];
+            uint32_t via_fail = next_[fail[s] * alphabet_ + c];
+            if (edge) {
+                fail[edge] = via_fail;
+                dict_[edge] = own[via_fail].empty() ? dict_[via_fail] : via_fail;
+                queue.push_back(edge);
+            } else {
+                edge = via_fail;
+            }
+        }
+    }
+
+    out_begin_.reserve(states + 1);
+    for (size_t s = 0; s < states; ++s) {
+        out_begin_.push_back(static_cast<uint32_t>(outputs_.size()));
+        outputs_.insert(outputs_.end(), own[s].begin(), own[s].end());
+    }
+    out_begin_.push_back(static_cast<uint32_t>(outputs_.size()));
+}
+
+int FilterMatcher::slot_of(int client_id) const {
+    auto it = std::lower_bound(clients_.begin(), clients_.end(), client_id);
+    return it != clients_.end() && *it == client_id ? static_cast<int>(it - clients_.begin()) : -1;
+}
+
+void FilterMatcher::match(const char* text, size_t len, uint64_t* matched) const {
+    uint32_t state = 0;
+    for (size_t i = 0; i < len; ++i) {
+        state = next_[state * alphabet_ + classes_[static_cast<unsigned char>(text[i])]];
+        uint32_t hit = out_begin_[state] != out_begin_[state + 1] ? state : dict_[state];
+        for (; hit; hit = dict_[hit]) {
+            for (uint32_t o = out_begin_[hit]; o < out_begin_[hit + 1]; ++o) {
+                const Output& out = outputs_[o];
+                if (out.anchored_len && out.anchored_len != i + 1) continue;
+                matched[out.slot / 64] |= uint64_t(1) << (out.slot % 64);
+            }
+        }
+    }
+}
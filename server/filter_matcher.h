@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Subscription filters of one room compiled into a single Aho-Corasick automaton
+ */
+
+#ifndef FILTER_MATCHER_H
+#define FILTER_MATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Every keyword of every subscriber in one automaton, so a message's text
+ * is scanned once, byte by byte, whatever the number of filters, and the
+ * scan marks each subscriber with at least one hit. Transitions are a
+ * dense table over byte classes (only the bytes that occur in some
+ * pattern get their own column), so each byte costs one table load plus
+ * the outputs it completes. Matching is ASCII case-insensitive; a pattern
+ * starting with '^' only matches at the start of the text.
+ *
+ * Immutable once built: the owner builds a new one when filters change
+ * and swaps it in, so match() may run while the next one is being built.
+ */
+class FilterMatcher {
+public:
+    struct Subscription {
+        int client_id;
+        std::vector<std::string> patterns;
+    };
+
+    // Split a filter spec ("alert, ^deploy") into patterns; empty ones dropped
+    static std::vector<std::string> parse_spec(const char* spec);
+
+    explicit FilterMatcher(std::vector<Subscription> subscriptions);
+
+    size_t subscribers() const { return clients_.size(); }
+    size_t states() const { return out_begin_.size() - 1; }
+
+    // Words in the bitmap match() fills, one bit per subscriber slot
+    size_t words() const { return (clients_.size() + 63) / 64; }
+
+    // The bitmap slot of `client_id`, or -1 if it has no filter here
+    int slot_of(int client_id) const;
+
+    // Set the bit of every subscriber with a pattern in text[0, len);
+    // `matched` holds words() words, zeroed by the caller
+    void match(const char* text, size_t len, uint64_t* matched) const;
+
+private:
+    struct Output {
+        uint32_t slot;
+        uint32_t anchored_len;  // Length of a '^' pattern (it must end there); 0 otherwise
+    };
+
+    std::vector<int> clients_;  // Slot -> client id, ascending
+    uint8_t classes_[256];      // Byte -> column of next_; 0 for bytes in no pattern
+    size_t alphabet_ = 1;
+    std::vector<uint32_t> next_;       // State * alphabet_ + class -> state (full DFA)
+    std::vector<uint32_t> dict_;       // Nearest proper suffix state with outputs; 0 for none
+    std::vector<uint32_t> out_begin_;  // State -> first of its own outputs_; states + 1 entries
+    std::vector<Output> outputs_;
+};
+
+#endif  // FILTER_MATCHER_H
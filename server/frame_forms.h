@@ -0,0 +1,45 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * One room message, encoded once per kind of recipient
+ */
+
+#ifndef FRAME_FORMS_H
+#define FRAME_FORMS_H
+
+#include "memory_pool.h"
+#include "../shared/common.h"
+#include "../shared/protocol.h"
+
+/**
+ * A fan-out sends one message to connections that want it in different
+ * NameForms: names for clients that never asked for ids (and for the
+ * replay buffer), names and ids where a connection has yet to learn an
+ * id, ids alone everywhere else. Each form is encoded the first time a
+ * recipient needs it, into a pooled frame every recipient of that form
+ * shares. One thread (the room's sequencer) uses it at a time.
+ */
+class FrameForms {
+public:
+    explicit FrameForms(const Message& msg) : msg_(msg) {}
+
+    const Message& message() const { return msg_; }
+
+    // The frame in `form`; empty if it could not be encoded
+    const FrameRef& get(NameForm form) {
+        FrameRef& frame = frames_[static_cast<int>(form)];
+        if (!frame) {
+            frame = FrameRef(FrameBuffer::acquire(MAX_FRAME_LEN + 4));
+            if (frame) frame->set_size(ChatUtils::encode_frame(msg_, frame->data(), frame->capacity(), form));
+            if (frame && frame->size() == 0) frame.reset();
+        }
+        return frame;
+    }
+
+private:
+    const Message& msg_;
+    FrameRef frames_[3];  // By NameForm
+};
+
+#endif  // FRAME_FORMS_H
@@ -0,0 +1,101 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "idle_monitor.h"
+#include "client_handler.h"
+#include "metrics.h"
+#include "../shared/common.h"
+#include <chrono>
+
+IdleMonitor::IdleMonitor() {
+    configure(kDefaultPingIntervalMs, kDefaultIdleTimeoutMs);
+}
+
+IdleMonitor::~IdleMonitor() {
+    stop();
+}
+
+void IdleMonitor::configure(int ping_interval_ms, int idle_timeout_ms, int tick_ms) {
+    ping_interval_ns_ = ping_interval_ms > 0 ? static_cast<uint64_t>(ping_interval_ms) * 1000000 : 0;
+    idle_timeout_ns_ = idle_timeout_ms > 0 ? static_cast<uint64_t>(idle_timeout_ms) * 1000000 : 0;
+    tick_ns_ = static_cast<uint64_t>(tick_ms > 0 ? tick_ms : kDefaultTickMs) * 1000000;
+    base_ns_ = ChatUtils::Clock::monotonic_ns();
+}
+
+void IdleMonitor::start() {
+    if (!enabled() || running_.exchange(true)) return;
+    thread_ = std::thread(&IdleMonitor::run, this);
+}
+
+void IdleMonitor::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+void IdleMonitor::run() {
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(tick_ns_));
+        poll(ChatUtils::Clock::monotonic_ns());
+    }
+}
+
+void IdleMonitor::watch(ClientHandler* client, Entry& entry) {
+    if (!enabled()) return;
+    uint64_t first = ping_interval_ns_ ? ping_interval_ns_ : idle_timeout_ns_;
+    if (idle_timeout_ns_ && idle_timeout_ns_ < first) first = idle_timeout_ns_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entry.client = client;
+    entry.pinged_after = 0;
+    wheel_.schedule(&entry, tick_after(client->last_read_ns() + first));
+}
+
+void IdleMonitor::unwatch(Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.cancel(&entry);
+}
+
+size_t IdleMonitor::watched() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_.size();
+}
+
+size_t IdleMonitor::poll(uint64_t now_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wheel_.advance(tick_at(now_ns), [&](TimerWheel::Timer* timer) {
+        on_expired(*static_cast<Entry*>(timer), now_ns);
+    });
+}
+
+void IdleMonitor::on_expired(Entry& entry, uint64_t now_ns) {
+    ClientHandler& client = *entry.client;
+    uint64_t last = client.last_read_ns();
+    uint64_t idle = now_ns > last ? now_ns - last : 0;
+
+    if (idle_timeout_ns_ && idle >= idle_timeout_ns_) {
+        // Not re-armed: the handler's read fails and it leaves as usual
+        Metrics::global().add(Counter::IDLE_REAPED);
+        LOG_INFO("IdleMonitor", "Client ", client.get_id(), " (", client.get_username(), ") silent for ",
+                 idle / 1000000, " ms, closing");
+        client.reap();
+        return;
+    }
+
+    bool ping_due = ping_interval_ns_ && entry.pinged_after != last && client.is_connected();
+    if (ping_due && idle >= ping_interval_ns_) {
+        if (client.try_ping()) {
+            entry.pinged_after = last;
+            ping_due = false;
+            Metrics::global().add(Counter::PINGS);
+        }
+    }
+
+    // Next look: the earlier of the ping and idle deadlines still ahead
+    uint64_t next = idle_timeout_ns_ ? last + idle_timeout_ns_ : UINT64_MAX;
+    if (ping_due && last + ping_interval_ns_ < next) next = last + ping_interval_ns_;
+    if (next == UINT64_MAX) next = now_ns + ping_interval_ns_;  // No timeout: just keep pinging
+    if (next <= now_ns) next = now_ns + 10 * tick_ns_;          // Ping could not go out; retry soon
+    wheel_.schedule(&entry, tick_after(next));
+}
@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Keep-alive pings and idle reaping for every connection, on one timer wheel
+ */
+
+#ifndef IDLE_MONITOR_H
+#define IDLE_MONITOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "timer_wheel.h"
+
+class ClientHandler;
+
+/**
+ * One thread ticks a TimerWheel holding one timer per connection. Reads
+ * never touch the wheel: a handler only stores the time of its last frame,
+ * and the timer, when it fires, looks at that and either re-arms itself
+ * for the new deadline, pings a connection quiet for `ping_interval`, or
+ * shuts down one silent for `idle_timeout` (its blocked read then returns
+ * and the handler leaves as on any disconnect). Each connection costs one
+ * timer firing per interval at most, and a tick is O(1) however many are
+ * watched.
+ */
+class IdleMonitor {
+public:
+    // Per-connection state, embedded in the ClientHandler
+    struct Entry : TimerWheel::Timer {
+        ClientHandler* client = nullptr;
+        uint64_t pinged_after = 0;  // Last-read time we already pinged for
+    };
+
+    static constexpr int kDefaultPingIntervalMs = 30000;
+    static constexpr int kDefaultIdleTimeoutMs = 90000;
+    static constexpr int kDefaultTickMs = 100;
+
+    IdleMonitor();
+    ~IdleMonitor();
+
+    // Before start(); a zero interval means no pings, a zero timeout no reaping
+    void configure(int ping_interval_ms, int idle_timeout_ms, int tick_ms = kDefaultTickMs);
+    bool enabled() const { return ping_interval_ns_ || idle_timeout_ns_; }
+
+    void start();
+    void stop();
+
+    // Arm a connection's timer (from its first read on); no-op when disabled
+    void watch(ClientHandler* client, Entry& entry);
+    // Disarm it; once this returns the monitor no longer touches `client`
+    void unwatch(Entry& entry);
+
+    size_t watched() const;
+
+    // Fire everything due by `now_ns`; the thread calls this every tick
+    size_t poll(uint64_t now_ns);
+
+private:
+    void run();
+    void on_expired(Entry& entry, uint64_t now_ns);
+
+    // Ticks count from base_ns_; deadlines round up so nothing fires early
+    uint64_t tick_at(uint64_t ns) const { return ns > base_ns_ ? (ns - base_ns_) / tick_ns_ : 0; }
+    uint64_t tick_after(uint64_t ns) const { return ns > base_ns_ ? (ns - base_ns_ + tick_ns_ - 1) / tick_ns_ : 0; }
+
+    uint64_t ping_interval_ns_ = 0;
+    uint64_t idle_timeout_ns_ = 0;
+    uint64_t tick_ns_ = 0;
+    uint64_t base_ns_ = 0;
+
+    mutable std::mutex mutex_;  // Guards wheel_ and every Entry in it
+    TimerWheel wheel_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+#endif  // IDLE_MONITOR_H
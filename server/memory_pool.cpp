@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "memory_pool.h"
+#include <cstdlib>
+
+// ===== Arena =====
+
+Arena::~Arena() {
+    Block* block = first_;
+    while (block) {
+        Block* next = block->next;
+        ::operator delete(block);
+        block = next;
+    }
+}
+
+Arena& Arena::local() {
+    static thread_local Arena arena;
+    return arena;
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    for (;;) {
+        if (current_) {
+            size_t offset = (used_ + align - 1) & ~(align - 1);
+            if (offset + size <= current_->size) {
+                used_ = offset + size;
+                return current_->data() + offset;
+            }
+            // Move on to a block kept from an earlier message, if any
+            if (current_->next && size <= current_->next->size) {
+                current_ = current_->next;
+                used_ = 0;
+                continue;
+            }
+        }
+
+        size_t block_size = size + align > kBlockSize ? size + align : kBlockSize;
+        Block* block = static_cast<Block*>(::operator new(sizeof(Block) + block_size));
+        block->size = block_size;
+        if (current_) {
+            block->next = current_->next;
+            current_->next = block;
+        } else {
+            block->next = first_;
+            first_ = block;
+        }
+        current_ = block;
+        used_ = 0;
+    }
+}
+
+void Arena::rewind(const Mark& m) {
+    current_ = static_cast<Block*>(m.block);
+    used_ = m.used;
+    if (!current_ && first_) {
+        current_ = first_;
+        used_ = 0;
+    }
+}
+
+// ===== FixedPool =====
+
+namespace {
+
+constexpr int kMaxPools = 64;
+
+std::atomic<int> g_next_pool_id(0);
+std::atomic<FixedPool*> g_pools[kMaxPools];
+
+}  // namespace
+
+// Per-thread caches for every pool; returned to the pools when the thread exits
+struct PoolThreadCaches {
+    FixedPool::ThreadCache caches[kMaxPools];
+
+    ~PoolThreadCaches() {
+        for (int i = 0; i < kMaxPools; ++i) {
+            FixedPool* pool = g_pools[i].load(std::memory_order_acquire);
+            if (pool && caches[i].count) {
+                pool->spill(caches[i], 0);
+            }
+        }
+    }
+};
+
+static thread_local PoolThreadCaches tls_caches;
+
+FixedPool::FixedPool(size_t block_size, size_t thread_cache)
+    : block_size_(block_size < sizeof(FreeBlock) ? sizeof(FreeBlock) : block_size),
+      thread_cache_(thread_cache ? thread_cache : 1),
+      id_(g_next_pool_id.fetch_add(1)) {
+    if (id_ < kMaxPools) {
+        g_pools[id_].store(this, std::memory_order_release);
+    } else {
+        id_ = -1;  // Out of cache slots: every call goes to the shared list
+    }
+}
+
+FixedPool::~FixedPool() {
+    if (id_ >= 0) {
+        g_pools[id_].store(nullptr, std::memory_order_release);
+    }
+    while (shared_head_) {
+        FreeBlock* next = shared_head_->next;
+        ::operator delete(shared_head_);
+        shared_head_ = next;
+    }
+}
+
+FixedPool::ThreadCache& FixedPool::cache() {
+    return tls_caches.caches[id_];
+}
+
+void* FixedPool::allocate() {
+    if (id_ < 0) {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        if (FreeBlock* block = shared_head_) {
+            shared_head_ = block->next;
+            return block;
+        }
+    } else {
+        ThreadCache& tc = cache();
+        if (!tc.head) refill(tc);
+        if (FreeBlock* block = tc.head) {
+            tc.head = block->next;
+            tc.count--;
+            return block;
+        }
+    }
+
+    system_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(block_size_);
+}
+
+void FixedPool::deallocate(void* ptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    if (id_ < 0) {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        block->next = shared_head_;
+        shared_head_ = block;
+        return;
+    }
+
+    ThreadCache& tc = cache();
+    block->next = tc.head;
+    tc.head = block;
+    if (++tc.count > thread_cache_) {
+        spill(tc, thread_cache_ / 2);
+    }
+}
+
+void FixedPool::reserve(size_t count) {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    for (size_t i = 0; i < count; ++i) {
+        FreeBlock* block = static_cast<FreeBlock*>(::operator new(block_size_));
+        block->next = shared_head_;
+        shared_head_ = block;
+    }
+    system_allocations_.fetch_add(count, std::memory_order_relaxed);
+}
+
+void FixedPool::refill(ThreadCache& tc) {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    while (shared_head_ && tc.count < thread_cache_ / 2 + 1) {
+        FreeBlock* block = shared_head_;
+        shared_head_ = block->next;
+        block->next = tc.head;
+        tc.head = block;
+        tc.count++;
+    }
+}
+
+void FixedPool::spill(ThreadCache& tc, size_t keep) {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    while (tc.count > keep) {
+        FreeBlock* block = tc.head;
+        tc.head = block->next;
+        tc.count--;
+        block->next = shared_head_;
+        shared_head_ = block;
+    }
+}
+
+// ===== Frame buffers =====
+
+namespace {
+
+// Frame size classes (header included); the largest covers batch frames
+constexpr size_t kFrameClasses[] = {512, 2048 + 64, 8192, 32768, 131072};
+constexpr int kFrameClassCount = sizeof(kFrameClasses) / sizeof(kFrameClasses[0]);
+
+FixedPool& frame_pool(int size_class) {
+    static FixedPool* pools = [] {
+        auto* p = static_cast<FixedPool*>(::operator new(sizeof(FixedPool) * kFrameClassCount));
+        for (int i = 0; i < kFrameClassCount; ++i) {
+            new (&p[i]) FixedPool(kFrameClasses[i]);
+        }
+        return p;  // Intentionally never destroyed: frames may be released during exit
+    }();
+    return pools[size_class];
+}
+
+}  // namespace
+
+FrameBuffer* FrameBuffer::acquire(size_t size) {
+    for (int c = 0; c < kFrameClassCount; ++c) {
+        if (size + sizeof(FrameBuffer) <= kFrameClasses[c]) {
+            void* block = frame_pool(c).allocate();
+            return new (block) FrameBuffer(kFrameClasses[c] - sizeof(FrameBuffer), c);
+        }
+    }
+    return nullptr;
+}
+
+void FrameBuffer::reserve(size_t size, size_t count) {
+    for (int c = 0; c < kFrameClassCount; ++c) {
+        if (size + sizeof(FrameBuffer) <= kFrameClasses[c]) {
+            frame_pool(c).reserve(count);
+            return;
+        }
+    }
+}
+
+void FrameBuffer::release() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        int size_class = size_class_;
+        this->~FrameBuffer();
+        frame_pool(size_class).deallocate(this);
+    }
+}
@@ -0,0 +1,225 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Pooled allocation for the message hot path: per-thread arenas for
+ * per-message temporaries and recycled fixed-size blocks for frames and
+ * queue nodes. Once warm, handling a message does not call malloc/free.
+ */
+
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// ===== Per-thread arena =====
+
+/**
+ * Bump allocator owned by one thread. Blocks are kept across resets, so
+ * after the first few messages an ArenaScope costs two pointer moves.
+ */
+class Arena {
+public:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    Arena() = default;
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // The calling thread's arena
+    static Arena& local();
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    struct Mark {
+        void* block;
+        size_t used;
+    };
+
+    Mark mark() const { return Mark{current_, used_}; }
+    void rewind(const Mark& m);
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        // Data follows
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    Block* first_ = nullptr;
+    Block* current_ = nullptr;
+    size_t used_ = 0;
+};
+
+// Rewinds the thread's arena when a message is done
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena = Arena::local()) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena_;
+    Arena::Mark mark_;
+};
+
+// ===== Fixed-size block pool =====
+
+/**
+ * Free list for one block size. Each thread keeps a small cache and trades
+ * half of it with a shared list when it runs dry or overflows, so blocks
+ * freed on one thread (the sequencer) are reused by others (handlers).
+ * Pools must outlive every thread that uses them; in practice they are
+ * process-wide singletons.
+ */
+class FixedPool {
+public:
+    explicit FixedPool(size_t block_size, size_t thread_cache = 64);
+    ~FixedPool();
+
+    FixedPool(const FixedPool&) = delete;
+    FixedPool& operator=(const FixedPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* block);
+
+    // Put `count` fresh blocks on the shared list (startup prewarm)
+    void reserve(size_t count);
+
+    size_t block_size() const { return block_size_; }
+
+    // Blocks obtained from the system allocator so far (flat once warm)
+    uint64_t system_allocations() const { return system_allocations_.load(std::memory_order_relaxed); }
+
+private:
+    friend struct PoolThreadCaches;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct ThreadCache {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    ThreadCache& cache();
+    void refill(ThreadCache& cache);
+    void spill(ThreadCache& cache, size_t keep);
+
+    size_t block_size_;
+    size_t thread_cache_;
+    int id_;
+
+    std::mutex shared_mutex_;
+    FreeBlock* shared_head_ = nullptr;
+    std::atomic<uint64_t> system_allocations_{0};
+};
+
+// ===== Frame buffers =====
+
+/**
+ * A reference-counted wire frame carved from a size-class pool. One encode
+ * is shared by every recipient of a fan-out; the last release recycles it.
+ */
+class FrameBuffer {
+public:
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return size_; }
+    void set_size(size_t size) { size_ = size; }
+
+    void retain() { refs_.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+
+    // Smallest pooled buffer that holds `size` bytes (nullptr if too large)
+    static FrameBuffer* acquire(size_t size);
+
+    // Prewarm the size class that serves `size`-byte frames
+    static void reserve(size_t size, size_t count);
+
+private:
+    FrameBuffer(size_t capacity, int size_class) : capacity_(capacity), size_class_(size_class) {}
+
+    size_t capacity_;
+    size_t size_ = 0;
+    int size_class_;
+    std::atomic<int> refs_{1};
+};
+
+// Owning handle to a FrameBuffer
+class FrameRef {
+public:
+    FrameRef() = default;
+    explicit FrameRef(FrameBuffer* buffer) : buffer_(buffer) {}
+    ~FrameRef() { reset(); }
+
+    FrameRef(const FrameRef& other) : buffer_(other.buffer_) {
+        if (buffer_) buffer_->retain();
+    }
+    FrameRef(FrameRef&& other) noexcept : buffer_(other.buffer_) { other.buffer_ = nullptr; }
+
+    FrameRef& operator=(FrameRef other) noexcept {
+        std::swap(buffer_, other.buffer_);
+        return *this;
+    }
+
+    void reset() {
+        if (buffer_) buffer_->release();
+        buffer_ = nullptr;
+    }
+
+    explicit operator bool() const { return buffer_ != nullptr; }
+    FrameBuffer* operator->() const { return buffer_; }
+    FrameBuffer* get() const { return buffer_; }
+
+private:
+    FrameBuffer* buffer_ = nullptr;
+};
+
+// ===== Typed object pool =====
+
+// Pooled new/delete for one hot type (e.g. sequencer queue nodes)
+template <typename T>
+class ObjectPool {
+public:
+    static ObjectPool& instance() {
+        static ObjectPool pool;
+        return pool;
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        return new (blocks_.allocate()) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* object) {
+        object->~T();
+        blocks_.deallocate(object);
+    }
+
+    void reserve(size_t count) { blocks_.reserve(count); }
+
+private:
+    ObjectPool() : blocks_(sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T)) {}
+
+    FixedPool blocks_;
+};
+
+#endif  // MEMORY_POOL_H
@@ -0,0 +1,34 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "message_pipeline.h"
+#include "client_handler.h"
+
+MessagePipeline::MessagePipeline() {
+    // Drop empty messages and stop clients from speaking as someone else
+    add_stage("validate", [](Message& msg, const ClientHandler& sender) {
+        if (msg.text[0] == '\0') return false;
+        strncpy(msg.user, sender.get_username().c_str(), MAX_USERNAME_LEN - 1);
+        msg.uid = sender.get_user_id();
+        return true;
+    });
+
+    // Server time is authoritative (millisecond precision, cached per second)
+    add_stage("timestamp", [](Message& msg, const ClientHandler&) {
+        Message::format_timestamp(msg.timestamp, MAX_TIMESTAMP_LEN, ChatUtils::Clock::Precision::MILLIS);
+        return true;
+    });
+}
+
+void MessagePipeline::add_stage(const std::string& name, MessageStage stage) {
+    stages_.emplace_back(name, std::move(stage));
+}
+
+bool MessagePipeline::process(Message& msg, const ClientHandler& sender) const {
+    for (const auto& stage : stages_) {
+        if (!stage.second(msg, sender)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Per-message processing stages run between ingest and the room sequencer
+ */
+
+#ifndef MESSAGE_PIPELINE_H
+#define MESSAGE_PIPELINE_H
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../shared/protocol.h"
+
+class ClientHandler;
+
+// A processing stage (validation, timestamping, indexing, moderation...);
+// return false to drop the message
+using MessageStage = std::function<bool(Message& msg, const ClientHandler& sender)>;
+
+/**
+ * Stages run in registration order on a TaskPool worker (or inline on the
+ * handler thread when the server runs without a pool). Register stages
+ * before the server starts accepting; the list is not locked.
+ *
+ * Each message runs inside an ArenaScope: stages that need scratch memory
+ * take it from Arena::local() and it is reclaimed when the message is done.
+ */
+class MessagePipeline {
+public:
+    // Installs the built-in "validate" and "timestamp" stages
+    MessagePipeline();
+
+    void add_stage(const std::string& name, MessageStage stage);
+
+    // Run every stage; false if one of them dropped the message
+    bool process(Message& msg, const ClientHandler& sender) const;
+
+    size_t stage_count() const { return stages_.size(); }
+
+private:
+    std::vector<std::pair<std::string, MessageStage>> stages_;
+};
+
+#endif  // MESSAGE_PIPELINE_H
@@ -0,0 +1,261 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "metrics.h"
+#include "client_handler.h"
+#include "room.h"
+#include "server_context.h"
+#include "../shared/logger.h"
+#include <cstdio>
+
+using ChatUtils::HdrHistogram;
+
+// ===== Shards =====
+
+Metrics::Shard::~Shard() {
+    for (auto& h : histograms) delete h.load();
+}
+
+HdrHistogram& Metrics::Shard::histogram(Histogram h) {
+    std::atomic<HdrHistogram*>& slot = histograms[static_cast<int>(h)];
+    HdrHistogram* histogram = slot.load(std::memory_order_acquire);
+    if (!histogram) {
+        histogram = new HdrHistogram();
+        slot.store(histogram, std::memory_order_release);
+    }
+    return *histogram;
+}
+
+// Hands the thread's shard back to the registry when the thread exits
+struct Metrics::ShardHolder {
+    Metrics* owner = nullptr;
+    Shard* shard = nullptr;
+    ~ShardHolder() {
+        if (shard) owner->retire(shard);
+    }
+};
+
+Metrics& Metrics::global() {
+    static Metrics* metrics = new Metrics();  // Never destroyed: threads may outlive statics
+    return *metrics;
+}
+
+Metrics::Shard& Metrics::local() {
+    static thread_local ShardHolder holder;
+    if (!holder.shard) {
+        holder.owner = this;
+        holder.shard = new Shard();
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        shards_.push_back(holder.shard);
+    }
+    return *holder.shard;
+}
+
+void Metrics::retire(Shard* shard) {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    for (int c = 0; c < static_cast<int>(Counter::COUNT); ++c) {
+        retired_.counters[c].fetch_add(shard->counters[c].load(), std::memory_order_relaxed);
+    }
+    for (int h = 0; h < static_cast<int>(Histogram::COUNT); ++h) {
+        if (HdrHistogram* histogram = shard->histograms[h].load()) {
+            retired_.histogram(static_cast<Histogram>(h)).merge(*histogram);
+        }
+    }
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i] == shard) {
+            shards_[i] = shards_.back();
+            shards_.pop_back();
+            break;
+        }
+    }
+    delete shard;
+}
+
+uint64_t Metrics::total(Counter counter) const {
+    int c = static_cast<int>(counter);
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    uint64_t sum = retired_.counters[c].load(std::memory_order_relaxed);
+    for (const Shard* shard : shards_) sum += shard->counters[c].load(std::memory_order_relaxed);
+    return sum;
+}
+
+HdrHistogram Metrics::merged(Histogram histogram) const {
+    int h = static_cast<int>(histogram);
+    HdrHistogram result;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    if (HdrHistogram* retired = retired_.histograms[h].load()) result.merge(*retired);
+    for (const Shard* shard : shards_) {
+        if (HdrHistogram* part = shard->histograms[h].load(std::memory_order_acquire)) result.merge(*part);
+    }
+    return result;
+}
+
+// ===== Prometheus text =====
+
+namespace {
+
+void header(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void sample(std::string& out, const char* name, const std::string& labels, double value) {
+    char number[64];
+    std::snprintf(number, sizeof(number), "%.17g", value);
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += number;
+    out += '\n';
+}
+
+void counter(std::string& out, const char* name, const char* help, uint64_t value) {
+    header(out, name, "counter", help);
+    sample(out, name, "", static_cast<double>(value));
+}
+
+// Label values may contain anything a client sent
+std::string label_value(const std::string& raw) {
+    std::string escaped;
+    for (char c : raw) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void latency_histogram(std::string& out, const char* name, const char* help, const HdrHistogram& h) {
+    // 1-2-5 bucket bounds from 1us to 10s, reported in seconds
+    header(out, name, "histogram", help);
+    std::string bucket = std::string(name) + "_bucket";
+    for (double decade = 1e-6; decade < 10; decade *= 10) {
+        for (double step : {1.0, 2.0, 5.0}) {
+            double le = decade * step;
+            char label[48];
+            std::snprintf(label, sizeof(label), "le=\"%g\"", le);
+            sample(out, bucket.c_str(), label, static_cast<double>(h.count_at_or_below(static_cast<uint64_t>(le * 1e9))));
+        }
+    }
+    sample(out, bucket.c_str(), "le=\"+Inf\"", static_cast<double>(h.count()));
+    sample(out, (std::string(name) + "_sum").c_str(), "", static_cast<double>(h.sum()) / 1e9);
+    sample(out, (std::string(name) + "_count").c_str(), "", static_cast<double>(h.count()));
+
+    // Fine-grained percentiles from the full-resolution buckets
+    std::string quantiles = std::string(name) + "_quantile";
+    header(out, quantiles.c_str(), "gauge", "Latency percentiles in seconds (HDR, ~3% precision)");
+    for (double q : {50.0, 90.0, 99.0, 99.9, 99.99}) {
+        char label[48];
+        std::snprintf(label, sizeof(label), "quantile=\"%g\"", q / 100);
+        sample(out, quantiles.c_str(), label, static_cast<double>(h.value_at_percentile(q)) / 1e9);
+    }
+    sample(out, quantiles.c_str(), "quantile=\"1\"", static_cast<double>(h.max()) / 1e9);
+}
+
+}  // namespace
+
+std::string render_metrics(const ServerContext& context) {
+    Metrics& m = Metrics::global();
+    std::string out;
+    out.reserve(8192);
+
+    counter(out, "chat_frames_in_total", "Frames read from clients", m.total(Counter::FRAMES_IN));
+    counter(out, "chat_frames_out_total", "Frames written to clients", m.total(Counter::FRAMES_OUT));
+    counter(out, "chat_bytes_in_total", "Bytes read from clients, length prefix included", m.total(Counter::BYTES_IN));
+    counter(out, "chat_bytes_out_total", "Bytes written to clients, length prefix included", m.total(Counter::BYTES_OUT));
+    counter(out, "chat_messages_dropped_total", "Messages rejected by a pipeline stage", m.total(Counter::DROPPED));
+    counter(out, "chat_send_failures_total", "Frames that could not be written to a client", m.total(Counter::SEND_FAILURES));
+    counter(out, "chat_connects_total", "Clients that completed the handshake", m.total(Counter::CONNECTS));
+    counter(out, "chat_disconnects_total", "Clients that went away", m.total(Counter::DISCONNECTS));
+    counter(out, "chat_replayed_frames_total", "Frames resent to clients resuming after a drop",
+            m.total(Counter::REPLAYED));
+    counter(out, "chat_throttled_messages_total", "Messages held back by a per-client or per-IP rate limit",
+            m.total(Counter::THROTTLED));
+    counter(out, "chat_accepts_delayed_total", "Connections left in the backlog by the accept-rate limit",
+            m.total(Counter::ACCEPTS_DELAYED));
+    counter(out, "chat_connections_rejected_total", "Connections closed on accept at the connection limit",
+            m.total(Counter::REJECTED));
+    counter(out, "chat_direct_messages_total", "Direct messages delivered", m.total(Counter::DIRECT));
+    counter(out, "chat_direct_misses_total", "Direct messages to a user who is not connected",
+            m.total(Counter::DIRECT_MISSES));
+    counter(out, "chat_filtered_frames_total", "Room frames withheld from members whose filter did not match",
+            m.total(Counter::FILTERED));
+    counter(out, "chat_filter_builds_total", "Subscription filter automata compiled", m.total(Counter::FILTER_BUILDS));
+    counter(out, "chat_pings_total", "Keep-alive pings sent to quiet connections", m.total(Counter::PINGS));
+    counter(out, "chat_idle_reaped_total", "Connections closed after the idle timeout", m.total(Counter::IDLE_REAPED));
+    counter(out, "chat_send_queued_total", "Frames that waited in a connection's outbox for a full socket",
+            m.total(Counter::SEND_QUEUED));
+    counter(out, "chat_slow_consumers_total", "Connections dropped for letting their outbox overflow",
+            m.total(Counter::SLOW_CONSUMERS));
+    counter(out, "chat_conflated_frames_total", "Room frames replaced by a summary for conflating clients",
+            m.total(Counter::CONFLATED));
+    counter(out, "chat_compressed_batches_total", "Deflated batch frames sent", m.total(Counter::COMPRESSED_BATCHES));
+    counter(out, "chat_compression_saved_bytes_total", "Bytes compressed batches saved on the wire",
+            m.total(Counter::COMPRESSION_SAVED));
+    counter(out, "chat_log_dropped_total", "Log records dropped because a ring was full",
+            ChatUtils::Logger::instance().dropped());
+
+    // Gauges straight from the live server state
+    std::string rooms_out, members_out, depth_out, seq_out, backlog_out, outbox_out;
+    size_t connected = 0;
+    context.rooms.for_each([&](const Room& room) {
+        std::string room_label = "room=\"" + label_value(room.name()) + "\"";
+        size_t members = 0;
+        room.for_each_member([&](const ClientHandler& client) {
+            if (!client.is_connected()) return;
+            members++;
+            std::string client_label = room_label + ",client=\"" + std::to_string(client.get_id()) + "\",user=\"" +
+                                       label_value(client.get_username()) + "\"";
+            sample(backlog_out, "chat_client_backlog", client_label, static_cast<double>(client.backlog()));
+            sample(outbox_out, "chat_client_outbox_bytes", client_label, static_cast<double>(client.outbox_bytes()));
+        });
+        connected += members;
+        sample(members_out, "chat_room_members", room_label, static_cast<double>(members));
+        sample(depth_out, "chat_room_queue_depth", room_label, static_cast<double>(room.queue_depth()));
+        sample(seq_out, "chat_room_last_seq", room_label, static_cast<double>(room.last_sequence()));
+    });
+
+    header(out, "chat_clients_connected", "gauge", "Connected clients");
+    sample(out, "chat_clients_connected", "", static_cast<double>(connected));
+    header(out, "chat_room_members", "gauge", "Connected clients per room");
+    out += members_out;
+    header(out, "chat_room_queue_depth", "gauge", "Messages waiting in the room's sequencer");
+    out += depth_out;
+    header(out, "chat_room_last_seq", "gauge", "Last sequence number delivered in the room");
+    out += seq_out;
+    header(out, "chat_client_backlog", "gauge", "Messages read from a client but not yet processed");
+    out += backlog_out;
+    header(out, "chat_client_outbox_bytes", "gauge", "Bytes waiting for a client's socket to drain");
+    out += outbox_out;
+    header(out, "chat_interned_names", "gauge", "User and room names bound to ids");
+    sample(out, "chat_interned_names", "", static_cast<double>(context.names.size()));
+
+    if (context.pool) {
+        header(out, "chat_pool_workers", "gauge", "Message-processing worker threads");
+        sample(out, "chat_pool_workers", "", static_cast<double>(context.pool->size()));
+        counter(out, "chat_pool_tasks_total", "Strand runs executed by the pool", context.pool->executed());
+        counter(out, "chat_pool_steals_total", "Tasks taken from another worker's deque", context.pool->steals());
+    }
+
+    latency_histogram(out, "chat_fanout_latency_seconds", "Time from reading a frame to sending it to the last recipient",
+                      m.merged(Histogram::FANOUT_LATENCY));
+    latency_histogram(out, "chat_direct_latency_seconds", "Time from reading a direct message to sending it to its recipient",
+                      m.merged(Histogram::DIRECT_LATENCY));
+    return out;
+}
@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Server metrics: per-thread counters and latency histograms, merged on scrape
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../shared/hdr_histogram.h"
+
+struct ServerContext;
+
+enum class Counter {
+    FRAMES_IN,
+    FRAMES_OUT,
+    BYTES_IN,
+    BYTES_OUT,
+    DROPPED,          // Rejected by a pipeline stage
+    SEND_FAILURES,    // Writes to a client that failed
+    CONNECTS,
+    DISCONNECTS,
+    REPLAYED,         // Frames resent to clients resuming after a drop
+    THROTTLED,        // Messages held back by a per-client or per-IP rate limit
+    ACCEPTS_DELAYED,  // Connections left in the backlog by the accept-rate limit
+    REJECTED,         // Connections closed on accept at --max-clients
+    DIRECT,           // Direct messages delivered
+    DIRECT_MISSES,    // Direct messages to a user who is not connected
+    FILTERED,         // Room frames not sent to a member because its filter did not match
+    FILTER_BUILDS,    // Filter automata compiled
+    PINGS,            // Keep-alive pings sent to quiet connections
+    IDLE_REAPED,      // Connections closed for silence past the idle timeout
+    SEND_QUEUED,      // Frames that waited in an outbox for a full socket
+    SLOW_CONSUMERS,   // Connections dropped for letting their outbox overflow
+    CONFLATED,        // Room frames replaced by a summary for a conflating client
+    COMPRESSED_BATCHES,  // Deflated batch frames sent
+    COMPRESSION_SAVED,   // Bytes those batches saved on the wire
+    COUNT
+};
+
+enum class Histogram {
+    FANOUT_LATENCY,  // Ingest (frame read) to the last recipient's send, ns
+    DIRECT_LATENCY,  // Ingest to the send of a direct message to its recipient, ns
+    COUNT
+};
+
+/**
+ * Process-wide metrics. Every thread that records gets its own shard on
+ * first use, so an update is a relaxed add on a cache line nobody else
+ * writes. Scrapes walk the shards and sum them; shards of exited threads
+ * are folded into a retired total.
+ */
+class Metrics {
+public:
+    static Metrics& global();
+
+    void add(Counter counter, uint64_t n = 1) {
+        std::atomic<uint64_t>& c = local().counters[static_cast<int>(counter)];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    void record(Histogram histogram, uint64_t value) { local().histogram(histogram).record(value); }
+
+    // Scrape side
+    uint64_t total(Counter counter) const;
+    ChatUtils::HdrHistogram merged(Histogram histogram) const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters[static_cast<int>(Counter::COUNT)] = {};
+        // Allocated by the owning thread on its first record
+        std::atomic<ChatUtils::HdrHistogram*> histograms[static_cast<int>(Histogram::COUNT)] = {};
+
+        ~Shard();
+        ChatUtils::HdrHistogram& histogram(Histogram h);
+    };
+
+    struct ShardHolder;
+
+    Metrics() = default;
+    Shard& local();
+    void retire(Shard* shard);
+
+    mutable std::mutex shards_mutex_;
+    std::vector<Shard*> shards_;
+    Shard retired_;  // Totals of threads that have exited
+};
+
+/**
+ * Prometheus text exposition of the global metrics plus gauges read from
+ * the server state (connected clients, per-client backlog, per-room
+ * sequencer depth, task pool activity).
+ */
+std::string render_metrics(const ServerContext& context);
+
+#endif  // METRICS_H
@@ -0,0 +1,155 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "metrics_server.h"
+#include "../shared/clock.h"
+#include "../shared/common.h"
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::add_route(const std::string& path, const std::string& content_type, Handler handler) {
+    routes_[path] = Route{content_type, std::move(handler)};
+}
+
+bool MetricsServer::listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Local scrapers only
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("metrics listen");
+        close(fd);
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    tcp_port_ = ntohs(addr.sin_port);
+    listeners_.push_back(fd);
+    return true;
+}
+
+bool MetricsServer::listen_unix(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("metrics listen");
+        close(fd);
+        return false;
+    }
+    unix_path_ = path;
+    listeners_.push_back(fd);
+    return true;
+}
+
+void MetricsServer::start() {
+    if (listeners_.empty() || running_.exchange(true)) return;
+    thread_ = std::thread(&MetricsServer::run, this);
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    for (int fd : listeners_) close(fd);
+    listeners_.clear();
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+        unix_path_.clear();
+    }
+}
+
+void MetricsServer::run() {
+    std::vector<pollfd> fds;
+    for (int fd : listeners_) fds.push_back(pollfd{fd, POLLIN, 0});
+
+    while (running_) {
+        // Short timeout so stop() does not have to wake us
+        if (poll(fds.data(), fds.size(), 200) <= 0) continue;
+        for (auto& p : fds) {
+            if (!(p.revents & POLLIN)) continue;
+            int client = accept(p.fd, nullptr, nullptr);
+            if (client >= 0) {
+                serve(client);
+                close(client);
+            }
+        }
+    }
+}
+
+void MetricsServer::serve(int fd) {
+    // A slow or idle client must not hold the endpoint
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[2048];
+    size_t len = 0;
+    while (len < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0) break;
+        len += static_cast<size_t>(n);
+        request[len] = '\0';
+        if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) break;
+    }
+    request[len] = '\0';
+
+    // "GET /path?query HTTP/1.1"
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; charset=utf-8";
+    std::string body;
+    if (std::strncmp(request, "GET ", 4) != 0) {
+        status = "405 Method Not Allowed";
+        body = "GET only\n";
+    } else {
+        const char* path = request + 4;
+        size_t path_len = std::strcspn(path, " ?\r\n");
+        auto route = routes_.find(std::string(path, path_len));
+        if (route == routes_.end()) {
+            status = "404 Not Found";
+            body = "not found\n";
+        } else {
+            content_type = route->second.content_type;
+            body = route->second.handler();
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                           "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n" + body;
+
+    // Written against a deadline too: a scraper that stops reading loses its
+    // response instead of stalling the scrapes queued behind it
+    const uint64_t deadline = ChatUtils::Clock::monotonic_ns() + 1000000000ULL;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ChatUtils::send_some(fd, response.data() + sent, response.size() - sent);
+        if (n < 0) return;
+        sent += static_cast<size_t>(n);
+        if (sent == response.size()) break;
+
+        uint64_t now = ChatUtils::Clock::monotonic_ns();
+        if (now >= deadline) return;
+        pollfd writable{fd, POLLOUT, 0};
+        if (poll(&writable, 1, static_cast<int>((deadline - now) / 1000000) + 1) == 0) return;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Minimal local HTTP endpoint for scraping metrics (TCP or Unix socket)
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Serves GET requests on one background thread, one request per
+ * connection. Intended for a local scraper (Prometheus, curl), not for
+ * public traffic: requests are small and handled one at a time.
+ *
+ *   curl http://127.0.0.1:9100/metrics
+ *   curl --unix-socket /tmp/chat_metrics.sock http://localhost/metrics
+ */
+class MetricsServer {
+public:
+    // Returns the response body; runs on the endpoint thread
+    using Handler = std::function<std::string()>;
+
+    MetricsServer() = default;
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void add_route(const std::string& path, const std::string& content_type, Handler handler);
+
+    // Listen on 127.0.0.1:port (0 picks a free port, see tcp_port())
+    bool listen_tcp(int port);
+
+    // Listen on a Unix domain socket, replacing a stale one at `path`
+    bool listen_unix(const std::string& path);
+
+    void start();
+    void stop();
+
+    int tcp_port() const { return tcp_port_; }
+
+private:
+    struct Route {
+        std::string content_type;
+        Handler handler;
+    };
+
+    void run();
+    void serve(int fd);
+
+    std::map<std::string, Route> routes_;
+    std::vector<int> listeners_;
+    std::string unix_path_;
+    int tcp_port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
+
+#endif  // METRICS_SERVER_H
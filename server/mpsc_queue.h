@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Intrusive lock-free multi-producer / single-consumer queue
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+
+// Link embedded in anything that travels through an MpscQueue
+struct MpscNode {
+    std::atomic<MpscNode*> next{nullptr};
+};
+
+/**
+ * Vyukov's intrusive MPSC queue over types derived from MpscNode; the queue
+ * never allocates. push() is wait-free from any thread, pop() may only be
+ * called from one consumer thread at a time.
+ */
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T* item) { link(item); }
+
+    // Returns nullptr when empty, or when a producer is mid-push (retry later)
+    T* pop() {
+        MpscNode* tail = tail_;
+        MpscNode* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &stub_) {
+            if (!next) return nullptr;
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+
+        // A producer is between its exchange and its link
+        if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+        link(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return static_cast<T*>(tail);
+        }
+        return nullptr;
+    }
+
+    // Consumer-side check; a concurrent push may make it stale immediately
+    bool empty() const {
+        return tail_ == &stub_ && head_.load() == &stub_;
+    }
+
+private:
+    void link(MpscNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode* prev = head_.exchange(node);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    std::atomic<MpscNode*> head_;
+    MpscNode* tail_;
+    MpscNode stub_;
+};
+
+#endif  // MPSC_QUEUE_H
@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Per-connection outbound queue with priority lanes
+ */
+
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "memory_pool.h"
+#include "../shared/protocol.h"
+
+/**
+ * Frames waiting for one connection's socket. Control frames (keep-alives
+ * and system notices) have a lane of their own that always goes first, so
+ * a pong or a notice never waits behind a backlog of chat. Bulk frames
+ * queue per source and take turns by deficit round-robin: each turn adds
+ * a quantum of bytes to the source's allowance, and it sends whole frames
+ * while the allowance covers them. A burst from one source cannot starve
+ * the other, whatever their frame sizes.
+ *
+ * A connection is in one room, so the bulk sources are its room's stream
+ * and the direct messages addressed to it.
+ *
+ * Lanes are rings that only grow (to the deepest backlog seen), so a warm
+ * outbox never allocates. Not thread-safe: the ClientHandler serialises
+ * every call under its send mutex.
+ */
+class Outbox {
+public:
+    enum Lane { CONTROL, ROOM, DIRECT, kLanes };
+
+    // Allowance per turn: at least one frame of any size
+    static constexpr size_t kQuantum = MAX_FRAME_LEN + 4;
+
+    static Lane lane_for(const Message& msg) {
+        if (msg.heartbeat || std::strcmp(msg.user, "[System]") == 0) return CONTROL;
+        return msg.to[0] ? DIRECT : ROOM;
+    }
+
+    void push(Lane lane, FrameRef frame) {
+        bytes_ += frame->size();
+        frames_++;
+        lanes_[lane].push(std::move(frame));
+    }
+
+    // Next frame to write, out of its lane; empty when nothing waits
+    FrameRef pop() {
+        if (!lanes_[CONTROL].empty()) return take(CONTROL);
+
+        // Every pass gives a source a fresh quantum, so two rounds always find a frame
+        for (int i = 0; i <= 2 * (kLanes - 1) && frames_; ++i) {
+            Ring& lane = lanes_[turn_];
+            if (lane.empty()) {
+                deficit_[turn_] = 0;  // An idle source banks nothing
+                next_turn();
+                continue;
+            }
+            if (!turn_started_) {
+                deficit_[turn_] += kQuantum;
+                turn_started_ = true;
+            }
+            size_t size = lane.front()->size();
+            if (size <= deficit_[turn_]) {
+                deficit_[turn_] -= size;
+                return take(turn_);
+            }
+            next_turn();
+        }
+        return FrameRef();
+    }
+
+    // Drop every frame queued on `lane`, handing back the newest; returns how many
+    size_t drop(Lane lane, FrameRef* newest) {
+        size_t dropped = 0;
+        while (!lanes_[lane].empty()) {
+            *newest = take(lane);
+            dropped++;
+        }
+        return dropped;
+    }
+
+    void clear() {
+        for (Ring& lane : lanes_) lane.clear();
+        for (size_t& deficit : deficit_) deficit = 0;
+        bytes_ = frames_ = 0;
+    }
+
+    bool empty() const { return frames_ == 0; }
+    size_t frames() const { return frames_; }
+    size_t bytes() const { return bytes_; }
+    size_t frames(Lane lane) const { return lanes_[lane].size(); }
+
+private:
+    class Ring {
+    public:
+        bool empty() const { return count_ == 0; }
+        size_t size() const { return count_; }
+        const FrameRef& front() const { return slots_[head_]; }
+
+        void push(FrameRef frame) {
+            if (count_ == slots_.size()) grow();
+            slots_[(head_ + count_) & (slots_.size() - 1)] = std::move(frame);
+            count_++;
+        }
+
+        FrameRef pop() {
+            FrameRef frame = std::move(slots_[head_]);
+            head_ = (head_ + 1) & (slots_.size() - 1);
+            count_--;
+            return frame;
+        }
+
+        void clear() {
+            while (count_) pop();
+        }
+
+    private:
+        void grow() {
+            std::vector<FrameRef> bigger(slots_.empty() ? 8 : slots_.size() * 2);
+            for (size_t i = 0; i < count_; ++i) bigger[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+            slots_.swap(bigger);
+            head_ = 0;
+        }
+
+        std::vector<FrameRef> slots_;  // Power-of-two size
+        size_t head_ = 0;
+        size_t count_ = 0;
+    };
+
+    FrameRef take(int lane) {
+        FrameRef frame = lanes_[lane].pop();
+        bytes_ -= frame->size();
+        frames_--;
+        return frame;
+    }
+
+    void next_turn() {
+        turn_ = turn_ + 1 == kLanes ? CONTROL + 1 : turn_ + 1;
+        turn_started_ = false;
+    }
+
+    Ring lanes_[kLanes];
+    size_t deficit_[kLanes] = {};
+    int turn_ = CONTROL + 1;  // Bulk source whose turn it is
+    bool turn_started_ = false;
+    size_t bytes_ = 0;
+    size_t frames_ = 0;
+};
+
+#endif  // OUTBOX_H
@@ -0,0 +1,42 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "rate_limiter.h"
+#include <iterator>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+std::shared_ptr<TokenBucket> IpBuckets::bucket_for(int socket_fd, const RateLimits& limits) {
+    if (limits.ip_rate <= 0) return nullptr;
+
+    sockaddr_storage addr{};
+    socklen_t len = sizeof(addr);
+    if (getpeername(socket_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0 || addr.ss_family != AF_INET) {
+        return nullptr;
+    }
+    uint32_t ip = reinterpret_cast<sockaddr_in*>(&addr)->sin_addr.s_addr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::weak_ptr<TokenBucket>& slot = buckets_[ip];
+    std::shared_ptr<TokenBucket> bucket = slot.lock();
+    if (!bucket) {
+        bucket = std::make_shared<TokenBucket>(limits.ip_rate, RateLimits::burst_or_rate(limits.ip_burst, limits.ip_rate));
+        slot = bucket;
+
+        // Forget addresses with no connections left once they pile up
+        if (buckets_.size() >= prune_at_) {
+            for (auto it = buckets_.begin(); it != buckets_.end();) {
+                it = it->second.expired() ? buckets_.erase(it) : std::next(it);
+            }
+            prune_at_ = buckets_.size() * 2 > kMinPruneAt ? buckets_.size() * 2 : kMinPruneAt;
+        }
+    }
+    return bucket;
+}
+
+size_t IpBuckets::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buckets_.size();
+}
@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Token buckets for per-connection, per-IP and accept-rate limits
+ */
+
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * A token bucket of `rate` tokens per second holding up to `burst`, kept
+ * in its GCRA form: the whole state is one "theoretical arrival time", so
+ * take() is a load and a CAS and any number of threads may share a bucket
+ * without a lock. A rate of 0 means unlimited.
+ */
+class TokenBucket {
+public:
+    TokenBucket() = default;
+    TokenBucket(double rate, double burst) { configure(rate, burst); }
+
+    // Not thread-safe; call before the bucket is shared
+    void configure(double rate, double burst) {
+        interval_ns_ = rate > 0 ? static_cast<uint64_t>(1e9 / rate) : 0;
+        if (rate > 0 && interval_ns_ == 0) interval_ns_ = 1;
+        tolerance_ns_ = interval_ns_ * static_cast<uint64_t>(burst >= 1 ? burst : 1);
+        tat_.store(0, std::memory_order_relaxed);
+    }
+
+    bool limited() const { return interval_ns_ != 0; }
+
+    // Take one token: 0 if there was one, otherwise the ns until there will
+    // be (and nothing is taken)
+    uint64_t take(uint64_t now_ns) {
+        if (!interval_ns_) return 0;
+        uint64_t tat = tat_.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t next = (tat > now_ns ? tat : now_ns) + interval_ns_;
+            if (next - now_ns > tolerance_ns_) return next - now_ns - tolerance_ns_;
+            if (tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed)) return 0;
+        }
+    }
+
+private:
+    uint64_t interval_ns_ = 0;   // 1 / rate
+    uint64_t tolerance_ns_ = 0;  // burst * interval
+    std::atomic<uint64_t> tat_{0};
+};
+
+// Limits set from the command line; every rate is per second, 0 = off
+struct RateLimits {
+    double client_rate = 0;   // Messages per connection
+    double client_burst = 0;  // 0: one second's worth
+    double ip_rate = 0;       // Messages per source address, all its connections together
+    double ip_burst = 0;
+    double accept_rate = 0;   // New connections accepted
+    size_t max_clients = 0;   // Open connections; more are closed on accept
+
+    static double burst_or_rate(double burst, double rate) { return burst > 0 ? burst : rate; }
+};
+
+/**
+ * One shared TokenBucket per source IPv4 address. The map is locked only
+ * when a connection resolves its bucket; the hot-path take() is lock-free.
+ * Buckets live as long as some connection from the address holds one.
+ */
+class IpBuckets {
+public:
+    // The bucket for the peer of `socket_fd`, or null when the per-IP limit
+    // is off or the peer is not an IPv4 address
+    std::shared_ptr<TokenBucket> bucket_for(int socket_fd, const RateLimits& limits);
+
+    size_t size() const;
+
+private:
+    static constexpr size_t kMinPruneAt = 64;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, std::weak_ptr<TokenBucket>> buckets_;
+    size_t prune_at_ = kMinPruneAt;
+};
+
+#endif  // RATE_LIMITER_H
@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "reactor_pool.h"
+#include "tracer.h"
+#include <string>
+
+ReactorPool::ReactorPool(size_t threads) : next_(0), running_(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        loops_.push_back(std::make_unique<ChatClient::EventLoop>());
+    }
+}
+
+ReactorPool::~ReactorPool() {
+    stop();
+}
+
+void ReactorPool::start() {
+    if (running_.exchange(true)) return;
+    for (size_t i = 0; i < loops_.size(); ++i) {
+        threads_.emplace_back([this, i]() {
+            if (Tracer::global().sample_every()) {
+                Tracer::global().set_thread_name("reactor " + std::to_string(i));
+            }
+            loops_[i]->run();
+        });
+    }
+}
+
+void ReactorPool::stop() {
+    if (!running_.exchange(false)) return;
+    for (auto& loop : loops_) loop->stop();
+    for (auto& t : threads_) {
+        if (t.joinable()) t.join();
+    }
+    threads_.clear();
+}
+
+ChatClient::EventLoop& ReactorPool::next() {
+    return *loops_[next_.fetch_add(1, std::memory_order_relaxed) % loops_.size()];
+}
@@ -0,0 +1,46 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * A few event-loop threads that serve connections as coroutines
+ */
+
+#ifndef REACTOR_POOL_H
+#define REACTOR_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../libchatclient/event_loop.h"
+
+/**
+ * One ChatClient::EventLoop per thread; accepted connections are dealt
+ * out round-robin and stay on their loop for life. Used by
+ * `chat_server --reactors N` in place of a thread per connection.
+ */
+class ReactorPool {
+public:
+    // threads == 0 means one per hardware thread
+    explicit ReactorPool(size_t threads = 0);
+    ~ReactorPool();
+
+    ReactorPool(const ReactorPool&) = delete;
+    ReactorPool& operator=(const ReactorPool&) = delete;
+
+    void start();
+    void stop();
+
+    // Loop for the next connection; safe from any thread
+    ChatClient::EventLoop& next();
+
+    size_t size() const { return loops_.size(); }
+
+private:
+    std::vector<std::unique_ptr<ChatClient::EventLoop>> loops_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_;
+    std::atomic<bool> running_;
+};
+
+#endif  // REACTOR_POOL_H
@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Recent encoded frames of one room, by sequence number, for resuming clients
+ */
+
+#ifndef REPLAY_BUFFER_H
+#define REPLAY_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * The bytes that went on the wire for the last `frames` messages, so a
+ * replay resends them without re-encoding. Frames are packed into one byte
+ * ring allocated up front (`bytes`, on average 256 per frame by default)
+ * and found through a slot table indexed by seq % frames, so appending
+ * never allocates. A frame is gone once either its slot or its bytes have
+ * been reused. Not thread-safe: the owning Room guards it with its
+ * membership lock.
+ */
+class ReplayBuffer {
+public:
+    static constexpr size_t kBytesPerFrame = 256;
+
+    explicit ReplayBuffer(size_t frames, size_t bytes = 0)
+        : slots_(frames), data_(bytes ? bytes : frames * kBytesPerFrame) {}
+
+    size_t capacity() const { return slots_.size(); }
+
+    void append(uint64_t seq, const char* frame, size_t len) {
+        if (slots_.empty() || seq == 0 || len > data_.size()) return;
+
+        // Frames never straddle the end of the ring; skip the tail instead
+        size_t offset = static_cast<size_t>(written_ % data_.size());
+        if (offset + len > data_.size()) {
+            written_ += data_.size() - offset;
+            offset = 0;
+        }
+        std::memcpy(data_.data() + offset, frame, len);
+
+        Slot& slot = slots_[seq % slots_.size()];
+        slot.seq = seq;
+        slot.pos = written_;
+        slot.len = len;
+        written_ += len;
+        if (seq > newest_) newest_ = seq;
+    }
+
+    uint64_t newest() const { return newest_; }
+
+    // Call fn(frame, len) for every held frame after `seq`, oldest first,
+    // until fn returns false; returns how many it accepted. Frames already
+    // overwritten are skipped and the client sees the gap in seq.
+    template <typename Fn>
+    size_t replay_after(uint64_t seq, Fn&& fn) const {
+        size_t accepted = 0;
+        if (slots_.empty() || seq >= newest_) return 0;
+        uint64_t from = newest_ - seq > slots_.size() ? newest_ - slots_.size() + 1 : seq + 1;
+        for (uint64_t s = from; s <= newest_; ++s) {
+            const Slot& slot = slots_[s % slots_.size()];
+            if (slot.seq != s || written_ - slot.pos > data_.size()) continue;
+            if (!fn(data_.data() + slot.pos % data_.size(), slot.len)) break;
+            accepted++;
+        }
+        return accepted;
+    }
+
+private:
+    struct Slot {
+        uint64_t seq = 0;
+        uint64_t pos = 0;  // Offset in the unwrapped byte stream
+        size_t len = 0;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<char> data_;
+    uint64_t written_ = 0;  // Bytes ever written, tail skips included
+    uint64_t newest_ = 0;
+};
+
+#endif  // REPLAY_BUFFER_H
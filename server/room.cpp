@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "room.h"
+#include "client_handler.h"
+#include "frame_forms.h"
+#include "memory_pool.h"
+#include "metrics.h"
+#include "tracer.h"
+#include "../shared/common.h"
+#include <algorithm>
+
+Room::Room(const std::string& name, size_t replay_depth)
+    : name_(name),
+      recent_(replay_depth),
+      sequencer_([this](const Message& msg, int sender_id) { fan_out(msg, sender_id); }, "room " + name) {
+    sequencer_.start();
+}
+
+Room::~Room() {
+    sequencer_.stop();
+}
+
+void Room::join(const std::shared_ptr<ClientHandler>& client, uint64_t resume_after) {
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    if (resume_after) {
+        // fan_out() appends and sends under this lock too, so the replay and
+        // the live stream meet exactly at recent_.newest(). One batch, so a
+        // long gap can go out compressed.
+        client->begin_batch();
+        bool filtered = matcher_ && matcher_->slot_of(client->get_id()) >= 0;
+        size_t skipped = 0;
+        Message held;
+        size_t replayed = recent_.replay_after(resume_after, [&](const char* frame, size_t len) {
+            if (filtered) {
+                // The filter holds for history as it does live
+                Message::parse(frame + 4, len - 4, held);
+                match(held.text);
+                if (filtered_out(*client)) {
+                    skipped++;
+                    return true;
+                }
+            }
+            return client->send_frame(frame, len);
+        });
+        client->end_batch();
+        replayed -= skipped;
+        Metrics::global().add(Counter::REPLAYED, replayed);
+        if (skipped) Metrics::global().add(Counter::FILTERED, skipped);
+        LOG_INFO("Room", "Client ", client->get_id(), " resumed in \"", name_, "\" after seq ", resume_after,
+                 ", replayed ", replayed, " frames");
+    }
+    members_.push_back(client);
+}
+
+void Room::leave(int client_id) {
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        members_.erase(std::remove_if(members_.begin(), members_.end(),
+                                      [client_id](const std::shared_ptr<ClientHandler>& c) {
+                                          return c->get_id() == client_id;
+                                      }),
+                       members_.end());
+    }
+    set_filter(client_id, "");
+}
+
+void Room::set_filter(int client_id, const char* spec) {
+    std::vector<FilterMatcher::Subscription> subscriptions;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(filters_mutex_);
+        std::vector<std::string> patterns = FilterMatcher::parse_spec(spec);
+        if (patterns.empty()) {
+            if (!filters_.erase(client_id)) return;
+        } else {
+            filters_[client_id] = std::move(patterns);
+        }
+        version = ++filters_version_;
+        subscriptions.reserve(filters_.size());
+        for (const auto& entry : filters_) subscriptions.push_back({entry.first, entry.second});
+    }
+
+    std::shared_ptr<const FilterMatcher> matcher;
+    if (!subscriptions.empty()) matcher = std::make_shared<const FilterMatcher>(std::move(subscriptions));
+    {
+        // Unless a newer build got here first
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        if (version > matcher_version_) {
+            matcher_version_ = version;
+            matcher_.swap(matcher);
+            if (matcher_ && matched_.size() < matcher_->words()) matched_.resize(matcher_->words());
+        }
+    }
+    Metrics::global().add(Counter::FILTER_BUILDS);
+    // The replaced matcher is freed here, outside the lock
+}
+
+void Room::publish(const Message& msg, int sender_id) {
+    sequencer_.submit(msg, sender_id);
+}
+
+size_t Room::member_count() const {
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    return members_.size();
+}
+
+void Room::for_each_member(const std::function<void(const ClientHandler&)>& fn) const {
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    for (const auto& client : members_) fn(*client);
+}
+
+void Room::fan_out(const Message& msg, int /*sender_id*/) {
+    TraceSpan span(msg.trace_id, "fan_out");
+
+    // Encode once per form into pooled frames and send the same bytes to
+    // every member wanting that form; the replay buffer keeps plain names
+    FrameForms forms(msg);
+    const FrameRef& frame = forms.get(NameForm::NAMES);
+    if (!frame) return;
+
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        recent_.append(msg.seq, frame->data(), frame->size());
+
+        // One pass over the text marks every filtered member it matches
+        if (matcher_) {
+            TraceSpan span_match(msg.trace_id, "filter");
+            match(msg.text);
+        }
+        uint64_t filtered = 0;
+        for (auto& client : members_) {
+            if (!client->is_connected()) continue;
+            if (matcher_ && filtered_out(*client)) {
+                filtered++;
+                continue;
+            }
+            TraceSpan write(msg.trace_id, "write", client->get_id());
+            client->send_frame(forms);
+        }
+        if (filtered) Metrics::global().add(Counter::FILTERED, filtered);
+    }
+    if (msg.ingress_ns) {
+        Metrics::global().record(Histogram::FANOUT_LATENCY, ChatUtils::Clock::monotonic_ns() - msg.ingress_ns);
+    }
+}
+
+void Room::match(const char* text) {
+    std::fill(matched_.begin(), matched_.begin() + matcher_->words(), 0);
+    matcher_->match(text, strnlen(text, MAX_MESSAGE_LEN), matched_.data());
+}
+
+bool Room::filtered_out(const ClientHandler& client) const {
+    int slot = matcher_->slot_of(client.get_id());
+    return slot >= 0 && !(matched_[slot / 64] >> (slot % 64) & 1);
+}
+
+std::shared_ptr<Room> RoomRegistry::get_or_create(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& room = rooms_[name];
+    if (!room) {
+        room = std::make_shared<Room>(name, replay_depth_);
+    }
+    return room;
+}
+
+void RoomRegistry::for_each(const std::function<void(const Room&)>& fn) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : rooms_) fn(*entry.second);
+}
+
+void RoomRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rooms_.clear();
+}
@@ -0,0 +1,103 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Chat rooms: membership plus a sequencer that totally orders each room's traffic
+ */
+
+#ifndef ROOM_H
+#define ROOM_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "filter_matcher.h"
+#include "replay_buffer.h"
+#include "sequencer.h"
+#include "../shared/protocol.h"
+
+class ClientHandler;
+
+class Room {
+public:
+    static constexpr size_t kDefaultReplayDepth = 1024;
+
+    // `replay_depth` recent frames are kept for clients resuming after a drop
+    explicit Room(const std::string& name, size_t replay_depth = kDefaultReplayDepth);
+    ~Room();
+
+    const std::string& name() const { return name_; }
+
+    // Add a member. A non-zero `resume_after` is the last seq the client saw
+    // before it dropped: the frames after it that are still held are sent
+    // first, ahead of any new traffic, so the client sees no gap. A client
+    // with a filter gets only the held frames its filter matches.
+    void join(const std::shared_ptr<ClientHandler>& client, uint64_t resume_after = 0);
+    void leave(int client_id);
+
+    // Queue a message for in-order delivery to every member (sender included,
+    // so it can see where its own message landed in the sequence)
+    void publish(const Message& msg, int sender_id);
+
+    // Only send `client_id` messages matching `spec` (see protocol.h); an
+    // empty spec removes its filter. Recompiles the room's matcher on the
+    // calling thread and swaps it in; fan-out never waits for a build.
+    void set_filter(int client_id, const char* spec);
+
+    uint64_t last_sequence() const { return sequencer_.last_sequence(); }
+    size_t queue_depth() const { return sequencer_.depth(); }
+    size_t member_count() const;
+
+    // Visit members under the membership lock (metrics scrapes)
+    void for_each_member(const std::function<void(const ClientHandler&)>& fn) const;
+
+private:
+    // Runs on the sequencer thread
+    void fan_out(const Message& msg, int sender_id);
+
+    // Mark in matched_ every filtered member `text` matches (matcher_ set,
+    // members_mutex_ held)
+    void match(const char* text);
+
+    // True if a filtered member should not get the message last matched
+    bool filtered_out(const ClientHandler& client) const;
+
+    std::string name_;
+    mutable std::mutex members_mutex_;
+    std::vector<std::shared_ptr<ClientHandler>> members_;
+    ReplayBuffer recent_;  // Guarded by members_mutex_
+
+    // Filters as set, and the version compiled into matcher_. Builds run
+    // outside both locks; the newest one to finish is the one installed.
+    std::mutex filters_mutex_;
+    std::map<int, std::vector<std::string>> filters_;  // Guarded by filters_mutex_
+    uint64_t filters_version_ = 0;                     // Guarded by filters_mutex_
+    std::shared_ptr<const FilterMatcher> matcher_;     // Guarded by members_mutex_
+    uint64_t matcher_version_ = 0;                     // Guarded by members_mutex_
+    std::vector<uint64_t> matched_;  // match()'s scratch bitmap, sized with matcher_
+
+    Sequencer sequencer_;
+};
+
+class RoomRegistry {
+public:
+    // Find a room by name, creating it on first use
+    std::shared_ptr<Room> get_or_create(const std::string& name);
+
+    // Replay depth for rooms created from now on (--replay)
+    void set_replay_depth(size_t frames) { replay_depth_ = frames; }
+
+    void clear();
+
+    void for_each(const std::function<void(const Room&)>& fn) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Room>> rooms_;
+    size_t replay_depth_ = Room::kDefaultReplayDepth;
+};
+
+#endif  // ROOM_H
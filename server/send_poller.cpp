@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "send_poller.h"
+#include "client_handler.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+
+static const uint64_t WAKE_TOKEN = UINT64_MAX;
+
+SendPoller::SendPoller() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_TOKEN;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+SendPoller::~SendPoller() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (thread_.joinable()) thread_.join();
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+void SendPoller::arm(int fd, int client_id, std::weak_ptr<ClientHandler> client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+        running_ = true;
+        thread_ = std::thread(&SendPoller::run, this);
+    }
+    waiting_[client_id] = std::move(client);
+
+    epoll_event ev{};
+    ev.events = EPOLLOUT | EPOLLONESHOT;
+    ev.data.u64 = static_cast<uint32_t>(client_id);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0 && errno == ENOENT) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void SendPoller::forget(int fd, int client_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiting_.erase(client_id);
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+size_t SendPoller::armed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiting_.size();
+}
+
+void SendPoller::run() {
+    epoll_event events[64];
+    while (running_) {
+        int n = epoll_wait(epoll_fd_, events, 64, -1);
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == WAKE_TOKEN) continue;
+
+            // Claim the registration; a stale event for a forgotten client finds none
+            std::shared_ptr<ClientHandler> client;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = waiting_.find(static_cast<int>(events[i].data.u64));
+                if (it == waiting_.end()) continue;
+                client = it->second.lock();
+                waiting_.erase(it);
+            }
+            if (client) client->on_writable();
+        }
+    }
+}
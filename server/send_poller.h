@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Resumes writes to connections whose socket was full
+ */
+
+#ifndef SEND_POLLER_H
+#define SEND_POLLER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+class ClientHandler;
+
+/**
+ * Sends never wait for a slow reader: what its socket cannot take stays in
+ * its Outbox, and the connection registers here. One thread waits on
+ * epoll for those sockets to drain and calls the handler's on_writable(),
+ * which writes on from its lanes. Registrations are one-shot and hold the
+ * handler weakly, so a connection that goes away is simply skipped.
+ *
+ * The thread starts on the first registration: a server whose clients
+ * keep up never runs it.
+ */
+class SendPoller {
+public:
+    SendPoller();
+    ~SendPoller();
+
+    SendPoller(const SendPoller&) = delete;
+    SendPoller& operator=(const SendPoller&) = delete;
+
+    // Call client->on_writable() once `fd` has room again
+    void arm(int fd, int client_id, std::weak_ptr<ClientHandler> client);
+
+    // Drop a connection's registration (before its fd is closed)
+    void forget(int fd, int client_id);
+
+    // Connections waiting for their socket
+    size_t armed() const;
+
+private:
+    void run();
+
+    int epoll_fd_;
+    int wake_fd_;  // Wakes run() for shutdown
+    std::atomic<bool> running_{false};
+    std::thread thread_;  // Started by the first arm()
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, std::weak_ptr<ClientHandler>> waiting_;  // By client id
+};
+
+#endif  // SEND_POLLER_H
@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "sequencer.h"
+#include "memory_pool.h"
+#include "tracer.h"
+#include <chrono>
+
+Sequencer::Sequencer(Deliver deliver, const std::string& name)
+    : deliver_(std::move(deliver)), name_(name),
+      last_seq_(0), submitted_(0), running_(false), sleeping_(false) {}
+
+Sequencer::~Sequencer() {
+    stop();
+}
+
+void Sequencer::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&Sequencer::run, this);
+}
+
+void Sequencer::stop() {
+    if (running_.exchange(false)) {
+        {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            park_cv_.notify_one();
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Drop anything still queued
+    while (Node* node = queue_.pop()) {
+        ObjectPool<Node>::instance().destroy(node);
+    }
+}
+
+void Sequencer::reserve_nodes(size_t count) {
+    ObjectPool<Node>::instance().reserve(count);
+}
+
+void Sequencer::submit(const Message& msg, int sender_id) {
+    Node* node = ObjectPool<Node>::instance().create();
+    node->msg = msg;
+    node->sender_id = sender_id;
+    if (msg.trace_id) node->enqueued_ns = ChatUtils::Clock::monotonic_ns();
+    submitted_.fetch_add(1, std::memory_order_relaxed);
+    queue_.push(node);
+
+    if (sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+void Sequencer::run() {
+    uint64_t seq = last_seq_.load(std::memory_order_relaxed);
+    int idle_spins = 0;
+    Tracer& tracer = Tracer::global();
+    if (tracer.sample_every()) tracer.set_thread_name(name_);
+
+    while (running_.load(std::memory_order_acquire)) {
+        Node* node = queue_.pop();
+        if (node) {
+            idle_spins = 0;
+            node->msg.seq = ++seq;
+            if (node->msg.trace_id) {
+                tracer.record(node->msg.trace_id, "sequence", node->enqueued_ns, ChatUtils::Clock::monotonic_ns(),
+                              static_cast<int64_t>(seq));
+            }
+            deliver_(node->msg, node->sender_id);
+            last_seq_.store(seq, std::memory_order_release);
+            ObjectPool<Node>::instance().destroy(node);
+            continue;
+        }
+
+        if (++idle_spins < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Park; producers only take the mutex when they see sleeping_ set
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        sleeping_.store(true);
+        if (queue_.empty() && running_) {
+            park_cv_.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        sleeping_.store(false);
+        idle_spins = 0;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Per-room sequencer: lock-free MPSC ingest queue feeding a single fan-out thread
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "mpsc_queue.h"
+#include "../shared/protocol.h"
+
+/**
+ * Handler threads submit() concurrently; one consumer thread pops in queue
+ * order, stamps a monotonic sequence number and calls the delivery callback.
+ * Because only that thread delivers, every recipient sees the same order and
+ * the numbers on the wire let them detect gaps.
+ */
+class Sequencer {
+public:
+    // Called on the sequencer thread for every message, in sequence order
+    using Deliver = std::function<void(const Message& msg, int sender_id)>;
+
+    // `name` labels the sequencer thread in trace dumps
+    explicit Sequencer(Deliver deliver, const std::string& name = "sequencer");
+    ~Sequencer();
+
+    Sequencer(const Sequencer&) = delete;
+    Sequencer& operator=(const Sequencer&) = delete;
+
+    void start();
+    void stop();
+
+    // Enqueue a message; safe from any number of threads
+    void submit(const Message& msg, int sender_id);
+
+    // Prewarm the queue-node pool shared by all sequencers
+    static void reserve_nodes(size_t count);
+
+    // Last sequence number handed to the delivery callback
+    uint64_t last_sequence() const { return last_seq_.load(std::memory_order_acquire); }
+
+    // Messages submitted but not yet delivered (approximate while running)
+    size_t depth() const {
+        uint64_t submitted = submitted_.load(std::memory_order_relaxed);
+        uint64_t delivered = last_sequence();
+        return submitted > delivered ? static_cast<size_t>(submitted - delivered) : 0;
+    }
+
+private:
+    struct Node : MpscNode {
+        Message msg;
+        int sender_id = -1;
+        uint64_t enqueued_ns = 0;  // Only set for traced messages
+    };
+
+    void run();
+
+    MpscQueue<Node> queue_;
+
+    Deliver deliver_;
+    std::string name_;
+    std::atomic<uint64_t> last_seq_;
+    std::atomic<uint64_t> submitted_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    // Parking for the consumer when the queue is empty
+    std::atomic<bool> sleeping_;
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+};
+
+#endif  // SEQUENCER_H
@@ -3,23 +3,38 @@
  * Copyright (c) 2025 OS Chat Project
  *
  * Socket Chat Server - System A
- * Multi-threaded TCP server that broadcasts messages to all connected clients
+ * Multi-threaded TCP server that fans messages out to every member of a room
+ * in a single, sequenced order
  */
 
 #include <iostream>
+#include <string>
 #include <vector>
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <csignal>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include "client_handler.h"
+#include "memory_pool.h"
+#include "metrics.h"
+#include "metrics_server.h"
+#ifdef CHAT_COROUTINES
+#include "reactor_pool.h"
+#endif
+#include "sequencer.h"
+#include "server_context.h"
+#include "tracer.h"
 #include "../shared/protocol.h"
 #include "../shared/common.h"
 
@@ -28,33 +43,43 @@ using namespace ChatUtils;
 // Global state (protected by mutex)
 static std::vector<std::shared_ptr<ClientHandler>> clients;
 static std::mutex clients_mutex;
+static ServerContext context;
 static int server_socket = -1;
 static std::atomic<bool> running(true);
+#ifdef CHAT_COROUTINES
+static std::unique_ptr<ReactorPool> reactors;  // Coroutine mode when set
+#endif
 
 void signal_handler(int sig) {
-    if (sig == SIGINT) {
-        LOG_INFO("Server", "Received SIGINT, shutting down...");
+    if (sig == SIGINT || sig == SIGTERM) {
+        LOG_INFO("Server", "Received ", sig == SIGINT ? "SIGINT" : "SIGTERM", ", shutting down...");
         running = false;
     }
 }
 
-void broadcast_message(const Message& msg, int exclude_client_id) {
-    std::lock_guard<std::mutex> lock(clients_mutex);
-    
-    for (auto& client : clients) {
-        if (client && client->is_connected() && 
-            (exclude_client_id < 0 || client->get_id() != exclude_client_id)) {
-            client->send_message(msg);
-        }
-    }
-}
-
 void accept_loop() {
     int client_id = 0;
     sockaddr_in client_addr;
     socklen_t addr_len = sizeof(client_addr);
+    const RateLimits& limits = context.limits;
+    TokenBucket accept_bucket(limits.accept_rate, std::max(1.0, limits.accept_rate));
+    bool delayed = false;
 
     while (running) {
+        // Wait with a timeout so a signal is noticed (accept() itself restarts)
+        pollfd pfd{server_socket, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) continue;
+
+        // Over the accept rate: leave the connection in the listen backlog
+        if (uint64_t wait = accept_bucket.take(ChatUtils::Clock::monotonic_ns())) {
+            if (!delayed) Metrics::global().add(Counter::ACCEPTS_DELAYED);
+            delayed = true;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<uint64_t>(wait, 100000000)));
+            continue;
+        }
+        delayed = false;
+
+        addr_len = sizeof(client_addr);
         int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &addr_len);
         
         if (client_socket < 0) {
@@ -64,13 +89,36 @@ void accept_loop() {
             continue;
         }
 
+        // Forget finished sessions, then enforce the connection cap
+        size_t open_clients;
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                         [](const std::shared_ptr<ClientHandler>& c) { return c->is_finished(); }),
+                          clients.end());
+            open_clients = clients.size();
+        }
+        if (limits.max_clients && open_clients >= limits.max_clients) {
+            Metrics::global().add(Counter::REJECTED);
+            LOG_WARN("Server", "Connection limit (", limits.max_clients, ") reached; closing new connection");
+            close(client_socket);
+            continue;
+        }
+
         char client_ip[INET_ADDRSTRLEN];
         inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-        LOG_INFO("Server", "New connection from " + std::string(client_ip) + ":" + 
-                           std::to_string(ntohs(client_addr.sin_port)));
+        LOG_INFO("Server", "New connection from ", client_ip, ":", ntohs(client_addr.sin_port));
 
-        auto handler = std::make_shared<ClientHandler>(client_socket, client_id++);
+        auto handler = std::make_shared<ClientHandler>(client_socket, client_id++, context);
+#ifdef CHAT_COROUTINES
+        if (reactors) {
+            handler->start(reactors->next());
+        } else {
+            handler->start();
+        }
+#else
         handler->start();
+#endif
 
         {
             std::lock_guard<std::mutex> lock(clients_mutex);
@@ -81,16 +129,120 @@ void accept_loop() {
 
 int main(int argc, char* argv[]) {
     int port = DEFAULT_PORT;
+    int workers = -1;  // Default: one per core
+    int metrics_port = -1;  // Off unless asked for
+    std::string metrics_socket;
+    std::string capture_path;
+    double ping_interval_s = IdleMonitor::kDefaultPingIntervalMs / 1000.0;
+    double idle_timeout_s = IdleMonitor::kDefaultIdleTimeoutMs / 1000.0;
 
     // Parse command-line arguments
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             port = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            LogLevel level;
+            if (!Logger::parse_level(argv[++i], level)) {
+                std::cerr << "Unknown log level: " << argv[i] << std::endl;
+                return 1;
+            }
+            Logger::instance().set_level(level);
+        } else if (strcmp(argv[i], "--log-rate") == 0 && i + 1 < argc) {
+            Logger::instance().set_rate_limit(static_cast<uint32_t>(std::atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metrics_port = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc) {
+            metrics_socket = argv[++i];
+        } else if (strcmp(argv[i], "--trace-sample") == 0 && i + 1 < argc) {
+            Tracer::global().set_sample_every(static_cast<uint32_t>(std::atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture_path = argv[++i];
+        } else if (strcmp(argv[i], "--client-rate") == 0 && i + 1 < argc) {
+            context.limits.client_rate = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--client-burst") == 0 && i + 1 < argc) {
+            context.limits.client_burst = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ip-rate") == 0 && i + 1 < argc) {
+            context.limits.ip_rate = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ip-burst") == 0 && i + 1 < argc) {
+            context.limits.ip_burst = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--accept-rate") == 0 && i + 1 < argc) {
+            context.limits.accept_rate = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-clients") == 0 && i + 1 < argc) {
+            context.limits.max_clients = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            context.rooms.set_replay_depth(static_cast<size_t>(std::max(0, std::atoi(argv[++i]))));
+        } else if (strcmp(argv[i], "--ping-interval") == 0 && i + 1 < argc) {
+            ping_interval_s = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            idle_timeout_s = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--outbox-limit") == 0 && i + 1 < argc) {
+            context.outbox_limit = static_cast<size_t>(std::atoll(argv[++i])) * 1024;
+        } else if (strcmp(argv[i], "--conflate-after") == 0 && i + 1 < argc) {
+            context.conflate_after = static_cast<size_t>(std::atoll(argv[++i])) * 1024;
+        } else if (strcmp(argv[i], "--no-compress") == 0) {
+            context.compress = false;
+        } else if (strcmp(argv[i], "--compress-min") == 0 && i + 1 < argc) {
+            context.compress_min = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (strcmp(argv[i], "--compress-level") == 0 && i + 1 < argc) {
+            context.compress_level = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-intern") == 0) {
+            context.intern = false;
+        } else if (strcmp(argv[i], "--reactors") == 0 && i + 1 < argc) {
+#ifdef CHAT_COROUTINES
+            reactors = std::make_unique<ReactorPool>(static_cast<size_t>(std::atoi(argv[++i])));
+#else
+            std::cerr << "--reactors needs a build with -DCHAT_COROUTINES=ON" << std::endl;
+            return 1;
+#endif
         }
     }
 
-    // Setup signal handler
+    // Prewarm the hot-path pools so steady-state traffic never reaches malloc
+    Sequencer::reserve_nodes(1024);
+    FrameBuffer::reserve(MAX_FRAME_LEN + 4, 1024);
+
+    // Message-processing pool (--workers 0 runs stages on the handler threads)
+    if (workers != 0) {
+        context.pool = std::make_unique<TaskPool>(workers < 0 ? 0 : workers);
+        context.pool->start();
+    }
+
+    // Record every inbound frame for chat_replay
+    if (!capture_path.empty()) {
+        context.capture = std::make_unique<CaptureWriter>();
+        if (!context.capture->open(capture_path)) {
+            perror("capture");
+            return 1;
+        }
+        LOG_INFO("Server", "Capturing inbound traffic to ", capture_path);
+    }
+
+    // Prometheus text on 127.0.0.1:<port>/metrics and/or a Unix socket
+    MetricsServer metrics_server;
+    metrics_server.add_route("/metrics", "text/plain; version=0.0.4", [] { return render_metrics(context); });
+    metrics_server.add_route("/trace", "application/json", [] { return Tracer::global().to_chrome_json(); });
+    metrics_server.add_route("/trace/clear", "text/plain", [] {
+        Tracer::global().clear();
+        return std::string("cleared\n");
+    });
+    if (metrics_port >= 0 && metrics_server.listen_tcp(metrics_port)) {
+        LOG_INFO("Server", "Metrics on http://127.0.0.1:", metrics_server.tcp_port(), "/metrics");
+    }
+    if (!metrics_socket.empty() && metrics_server.listen_unix(metrics_socket)) {
+        LOG_INFO("Server", "Metrics on unix:", metrics_socket, " /metrics");
+    }
+    metrics_server.start();
+
+#ifdef CHAT_COROUTINES
+    if (reactors) reactors->start();
+#endif
+
+    // Setup signal handlers: kill and supervisors send SIGTERM, and a capture
+    // is only complete once the shutdown below has closed it
     std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
 
     // Create server socket
     server_socket = socket(AF_INET, SOCK_STREAM, 0);
@@ -119,14 +271,35 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Start listening
-    if (listen(server_socket, 5) < 0) {
+    // Start listening; a short backlog drops SYNs when clients connect in bursts
+    if (listen(server_socket, SOMAXCONN) < 0) {
         perror("listen");
         close(server_socket);
         return 1;
     }
 
-    LOG_INFO("Server", "Chat server started on 0.0.0.0:" + std::to_string(port));
+    LOG_INFO("Server", "Chat server started on 0.0.0.0:", port);
+    if (context.pool) {
+        LOG_INFO("Server", "Processing pool: ", context.pool->size(), " workers");
+    } else {
+        LOG_INFO("Server", "Processing pool: inline");
+    }
+#ifdef CHAT_COROUTINES
+    if (reactors) {
+        LOG_INFO("Server", "Connections: coroutines on ", reactors->size(), " reactor threads");
+    }
+#endif
+    const RateLimits& limits = context.limits;
+    if (limits.client_rate > 0 || limits.ip_rate > 0 || limits.accept_rate > 0 || limits.max_clients) {
+        LOG_INFO("Server", "Limits: ", limits.client_rate, " msg/s per client, ", limits.ip_rate, " msg/s per IP, ",
+                 limits.accept_rate, " accepts/s, ", limits.max_clients, " clients (0 = unlimited)");
+    }
+    context.idle.configure(static_cast<int>(ping_interval_s * 1000), static_cast<int>(idle_timeout_s * 1000));
+    context.idle.start();
+    if (context.idle.enabled()) {
+        LOG_INFO("Server", "Keep-alive: ping after ", ping_interval_s, " s quiet, close after ", idle_timeout_s,
+                 " s (0 = off)");
+    }
     LOG_INFO("Server", "Waiting for connections... (Press Ctrl+C to stop)");
 
     // Accept client connections
@@ -134,6 +307,7 @@ int main(int argc, char* argv[]) {
 
     // Cleanup
     LOG_INFO("Server", "Shutting down server...");
+    context.idle.stop();
     {
         std::lock_guard<std::mutex> lock(clients_mutex);
         for (auto& client : clients) {
@@ -141,8 +315,28 @@ int main(int argc, char* argv[]) {
                 client->stop();
             }
         }
+#ifdef CHAT_COROUTINES
+        // Coroutines finish on their loops; give them a moment to leave their rooms
+        for (int waited = 0; reactors && waited < 1000; ++waited) {
+            bool any = false;
+            for (auto& client : clients) any = any || (client && client->is_connected());
+            if (!any) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (reactors) reactors->stop();
+#endif
         clients.clear();
     }
+    metrics_server.stop();
+    if (context.pool) {
+        context.pool->stop();
+    }
+    if (context.capture) {
+        context.capture->close();
+        LOG_INFO("Server", "Captured ", context.capture->recorded(), " records (", context.capture->dropped(),
+                 " dropped)");
+    }
+    context.rooms.clear();
 
     close(server_socket);
     LOG_INFO("Server", "Server stopped");
@@ -0,0 +1,45 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * State shared by every connection of one server instance
+ */
+
+#ifndef SERVER_CONTEXT_H
+#define SERVER_CONTEXT_H
+
+#include <memory>
+#include "capture_writer.h"
+#include "idle_monitor.h"
+#include "message_pipeline.h"
+#include "rate_limiter.h"
+#include "room.h"
+#include "send_poller.h"
+#include "task_pool.h"
+#include "user_directory.h"
+#include "../shared/intern_table.h"
+
+struct ServerContext {
+    static constexpr size_t kDefaultOutboxLimit = 4 << 20;
+    static constexpr size_t kDefaultConflateAfter = 64 << 10;
+    static constexpr size_t kDefaultCompressMin = 1024;
+
+    RoomRegistry rooms;
+    UserDirectory users;     // Who is connected, by name (direct messages)
+    MessagePipeline pipeline;
+    std::unique_ptr<TaskPool> pool;  // Runs pipeline stages; inline on the handler thread when null
+    std::unique_ptr<CaptureWriter> capture;  // Records inbound frames when set (--capture)
+    RateLimits limits;       // Set before accepting; read by every connection
+    IpBuckets ip_buckets;    // Per-IP message buckets (limits.ip_rate)
+    size_t outbox_limit = kDefaultOutboxLimit;  // Bytes queued for a slow reader before dropping it
+    size_t conflate_after = kDefaultConflateAfter;  // Bytes queued before a conflating reader gets a summary
+    bool compress = true;    // Deflate batches for clients that offer it (--no-compress)
+    size_t compress_min = kDefaultCompressMin;  // Smallest backlog worth a batch; less goes out raw
+    int compress_level = 1;  // zlib level, 1 (fast) to 9
+    bool intern = true;      // Send names as ids to clients that ask (--no-intern)
+    ChatUtils::InternTable names;  // User and room name ids, bound at hello
+    SendPoller sends;        // Resumes writes to connections whose socket was full
+    IdleMonitor idle;        // Pings and reaps quiet connections once started
+};
+
+#endif  // SERVER_CONTEXT_H
@@ -0,0 +1,276 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "task_pool.h"
+#include "tracer.h"
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+
+namespace {
+
+// Which pool (if any) the current thread is a worker of
+thread_local const TaskPool* tls_pool = nullptr;
+thread_local size_t tls_index = 0;
+
+struct FunctionTask : PoolTask {
+    explicit FunctionTask(std::function<void()> f) : fn(std::move(f)) {}
+    void execute() override {
+        fn();
+        delete this;
+    }
+    std::function<void()> fn;
+};
+
+}  // namespace
+
+// ===== Chase-Lev deque =====
+
+bool TaskPool::StealDeque::push(PoolTask* task) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= kCapacity) return false;
+
+    slots_[bottom & (kCapacity - 1)].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+PoolTask* TaskPool::StealDeque::pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    PoolTask* task = slots_[bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last item: race thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+PoolTask* TaskPool::StealDeque::steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+
+    PoolTask* task = slots_[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+        return nullptr;  // Lost to the owner or another thief
+    }
+    return task;
+}
+
+bool TaskPool::StealDeque::empty() const {
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+}
+
+// ===== Pool =====
+
+TaskPool::TaskPool(size_t workers)
+    : next_inbox_(0), running_(false), sleepers_(0) {
+    if (workers == 0) {
+        workers = std::thread::hardware_concurrency();
+        if (workers == 0) workers = 1;
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+TaskPool::~TaskPool() {
+    stop();
+}
+
+void TaskPool::start() {
+    if (running_.exchange(true)) return;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&TaskPool::worker_loop, this, i);
+    }
+}
+
+void TaskPool::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_all();
+    }
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+
+    // Run whatever is left so no strand is stranded in a queue
+    bool ran = true;
+    while (ran) {
+        ran = false;
+        for (auto& w : workers_) {
+            while (PoolTask* task = w->deque.steal()) {
+                task->execute();
+                ran = true;
+            }
+            while (PoolTask* task = w->inbox.pop()) {
+                w->inbox_size.fetch_sub(1);
+                task->execute();
+                ran = true;
+            }
+        }
+    }
+}
+
+void TaskPool::submit(PoolTask* task) {
+    if (tls_pool == this && workers_[tls_index]->deque.push(task)) {
+        wake_one();
+        return;
+    }
+
+    Worker& w = *workers_[next_inbox_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+    w.inbox_size.fetch_add(1);
+    w.inbox.push(task);
+    wake_one();
+}
+
+void TaskPool::yield(PoolTask* task) {
+    size_t index = tls_pool == this ? tls_index : next_inbox_.fetch_add(1, std::memory_order_relaxed);
+    Worker& w = *workers_[index % workers_.size()];
+    w.inbox_size.fetch_add(1);
+    w.inbox.push(task);
+    wake_one();
+}
+
+void TaskPool::submit(std::function<void()> fn) {
+    submit(new FunctionTask(std::move(fn)));
+}
+
+uint64_t TaskPool::executed() const {
+    uint64_t total = 0;
+    for (auto& w : workers_) total += w->executed.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t TaskPool::steals() const {
+    uint64_t total = 0;
+    for (auto& w : workers_) total += w->steals.load(std::memory_order_relaxed);
+    return total;
+}
+
+void TaskPool::wake_one() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load() > 0) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+bool TaskPool::has_pending() const {
+    for (auto& w : workers_) {
+        if (w->inbox_size.load() > 0 || !w->deque.empty()) return true;
+    }
+    return false;
+}
+
+PoolTask* TaskPool::take_from_inbox(Worker& inbox_owner, Worker& self) {
+    if (inbox_owner.inbox_size.load(std::memory_order_relaxed) == 0) return nullptr;
+    if (inbox_owner.inbox_busy.exchange(true, std::memory_order_acquire)) return nullptr;
+
+    PoolTask* task = inbox_owner.inbox.pop();
+    if (task) {
+        inbox_owner.inbox_size.fetch_sub(1);
+        // Move a batch into our deque so idle workers can steal it from there
+        for (int i = 0; i < 32; ++i) {
+            PoolTask* more = inbox_owner.inbox.pop();
+            if (!more) break;
+            inbox_owner.inbox_size.fetch_sub(1);
+            if (!self.deque.push(more)) {
+                inbox_owner.inbox_size.fetch_add(1);
+                inbox_owner.inbox.push(more);
+                break;
+            }
+        }
+    }
+
+    inbox_owner.inbox_busy.store(false, std::memory_order_release);
+    return task;
+}
+
+PoolTask* TaskPool::find_task(size_t index) {
+    Worker& self = *workers_[index];
+    const size_t n = workers_.size();
+
+    if (PoolTask* task = self.deque.pop()) return task;
+    for (size_t i = 0; i < n; ++i) {
+        if (PoolTask* task = take_from_inbox(*workers_[(index + i) % n], self)) return task;
+    }
+    for (size_t i = 1; i < n; ++i) {
+        if (PoolTask* task = workers_[(index + i) % n]->deque.steal()) {
+            self.steals.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void TaskPool::worker_loop(size_t index) {
+    tls_pool = this;
+    tls_index = index;
+
+    // One worker per core: pin when there are no more workers than cores
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores && workers_.size() <= cores) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    if (Tracer::global().sample_every()) {
+        Tracer::global().set_thread_name("worker " + std::to_string(index));
+    }
+
+    Worker& self = *workers_[index];
+    int idle_spins = 0;
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (PoolTask* task = find_task(index)) {
+            task->execute();
+            self.executed.fetch_add(1, std::memory_order_relaxed);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Park; submitters only take the mutex when they see a sleeper
+        sleepers_.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            if (running_ && !has_pending()) {
+                park_cv_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+        sleepers_.fetch_sub(1);
+        idle_spins = 0;
+    }
+
+    tls_pool = nullptr;
+}
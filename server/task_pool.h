@@ -0,0 +1,109 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Work-stealing task pool for server-side message processing
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mpsc_queue.h"
+
+/**
+ * A unit of work. Embed it in the object that owns the work (a client's
+ * processing strand, a room's fan-out) so scheduling never allocates.
+ * A task must not be submitted again until its execute() has started.
+ */
+class PoolTask : public MpscNode {
+public:
+    virtual ~PoolTask() = default;
+    virtual void execute() = 0;
+};
+
+/**
+ * One worker per core, each with a Chase-Lev deque. Workers pop their own
+ * deque LIFO and steal FIFO from others when they run dry.
+ *
+ * Threads outside the pool (the ClientHandler ingest threads) cannot touch
+ * a deque's owner end, so their submissions go round-robin into per-worker
+ * MPSC inboxes. Inboxes are drained by whichever worker wins the inbox's
+ * consumer flag, so a busy worker's inbox is still picked up by idle ones.
+ */
+class TaskPool {
+public:
+    // workers == 0 means one per hardware thread
+    explicit TaskPool(size_t workers = 0);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void start();
+    void stop();
+
+    // Schedule a task; safe from any thread
+    void submit(PoolTask* task);
+
+    // Schedule a task behind everything already queued, for one that has
+    // had its turn and wants another: from a worker it goes into that
+    // worker's inbox (FIFO) rather than onto its deque, which is popped LIFO
+    void yield(PoolTask* task);
+
+    // Convenience for one-off work (allocates a wrapper task)
+    void submit(std::function<void()> fn);
+
+    size_t size() const { return workers_.size(); }
+    uint64_t executed() const;
+    uint64_t steals() const;
+
+private:
+    // Chase-Lev work-stealing deque with a fixed power-of-two capacity
+    class StealDeque {
+    public:
+        static constexpr int64_t kCapacity = 4096;
+
+        bool push(PoolTask* task);  // Owner only
+        PoolTask* pop();            // Owner only
+        PoolTask* steal();          // Any thread
+        bool empty() const;
+
+    private:
+        alignas(64) std::atomic<int64_t> top_{0};
+        alignas(64) std::atomic<int64_t> bottom_{0};
+        std::atomic<PoolTask*> slots_[kCapacity];
+    };
+
+    struct Worker {
+        StealDeque deque;
+        MpscQueue<PoolTask> inbox;
+        std::atomic<int> inbox_size{0};
+        std::atomic<bool> inbox_busy{false};  // Held by the worker currently draining the inbox
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> steals{0};
+        std::thread thread;
+    };
+
+    void worker_loop(size_t index);
+    PoolTask* take_from_inbox(Worker& inbox_owner, Worker& self);
+    PoolTask* find_task(size_t index);
+    bool has_pending() const;
+    void wake_one();
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_inbox_;
+    std::atomic<bool> running_;
+    std::atomic<int> sleepers_;
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+};
+
+#endif  // TASK_POOL_H
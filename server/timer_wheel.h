@@ -0,0 +1,153 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Hierarchical timer wheel: O(1) schedule, cancel and per-tick cost
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Four levels of 64 slots, each slot an intrusive doubly linked list. A
+ * timer due within 64 ticks sits in level 0 at its exact tick; one due
+ * later sits in the coarser level whose range covers it and is moved down
+ * (cascaded) when the level below wraps around to it. Scheduling and
+ * cancelling are a few pointer writes, and a tick touches one slot plus,
+ * every 64 ticks, one slot of the next level, whatever the number of
+ * timers. Deadlines past 64^4 ticks are clamped to that horizon.
+ *
+ * Timers are embedded in their owners, so the wheel never allocates. Not
+ * thread-safe: the owner serialises every call.
+ */
+class TimerWheel {
+public:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits;
+    static constexpr uint64_t kHorizon = uint64_t(1) << (kSlotBits * kLevels);
+
+    struct Timer {
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+        uint64_t expires = 0;  // Tick it fires on
+
+        bool armed() const { return next != nullptr; }
+    };
+
+    explicit TimerWheel(uint64_t now_tick = 0) : current_(now_tick) {
+        for (auto& level : slots_) {
+            for (Timer& head : level) head.prev = head.next = &head;
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // The next tick advance() will fire
+    uint64_t now() const { return current_; }
+    size_t size() const { return size_; }
+
+    // Arm (or re-arm) `timer` for `tick`; a tick already past fires on the next advance()
+    void schedule(Timer* timer, uint64_t tick) {
+        cancel(timer);
+        timer->expires = tick < current_ ? current_ : tick;
+        link(timer);
+        size_++;
+    }
+
+    void cancel(Timer* timer) {
+        if (!timer->armed()) return;
+        unlink(timer);
+        size_--;
+    }
+
+    // Run every tick up to and including `tick`, calling fn(Timer*) for
+    // each timer that comes due (already disarmed, so fn may schedule it
+    // again). Returns how many fired.
+    template <typename Fn>
+    size_t advance(uint64_t tick, Fn&& fn) {
+        size_t fired = 0;
+        while (current_ <= tick) {
+            if (size_ == 0) {
+                current_ = tick + 1;  // Nothing to cascade or fire on the way
+                break;
+            }
+            // Entering a new lap of a level: pull its next slot down a level
+            for (int level = 1; level < kLevels; ++level) {
+                if (current_ & ((uint64_t(1) << (kSlotBits * level)) - 1)) break;
+                cascade(level, slot_index(current_, level));
+            }
+
+            // Detach the due slot first so callbacks can re-arm freely
+            Timer due;
+            due.prev = due.next = &due;
+            splice(slots_[0][slot_index(current_, 0)], due);
+            current_++;
+            while (due.next != &due) {
+                Timer* timer = due.next;
+                unlink(timer);
+                size_--;
+                fired++;
+                fn(timer);
+            }
+        }
+        return fired;
+    }
+
+private:
+    static size_t slot_index(uint64_t tick, int level) {
+        return static_cast<size_t>((tick >> (kSlotBits * level)) & (kSlots - 1));
+    }
+
+    void link(Timer* timer) {
+        uint64_t delta = timer->expires - current_;
+        if (delta >= kHorizon) {
+            timer->expires = current_ + kHorizon - 1;
+            delta = kHorizon - 1;
+        }
+        int level = 0;
+        while (delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) level++;
+        Timer& head = slots_[level][slot_index(timer->expires, level)];
+        timer->prev = head.prev;
+        timer->next = &head;
+        head.prev->next = timer;
+        head.prev = timer;
+    }
+
+    static void unlink(Timer* timer) {
+        timer->prev->next = timer->next;
+        timer->next->prev = timer->prev;
+        timer->prev = timer->next = nullptr;
+    }
+
+    // Move every timer of `from` onto the (empty) list `to`
+    static void splice(Timer& from, Timer& to) {
+        if (from.next == &from) return;
+        to.next = from.next;
+        to.prev = from.prev;
+        to.next->prev = &to;
+        to.prev->next = &to;
+        from.prev = from.next = &from;
+    }
+
+    void cascade(int level, size_t index) {
+        Timer moving;
+        moving.prev = moving.next = &moving;
+        splice(slots_[level][index], moving);
+        while (moving.next != &moving) {
+            Timer* timer = moving.next;
+            unlink(timer);
+            link(timer);  // Now closer, so into a finer level
+        }
+    }
+
+    Timer slots_[kLevels][kSlots];  // List heads
+    uint64_t current_;
+    size_t size_ = 0;
+};
+
+#endif  // TIMER_WHEEL_H
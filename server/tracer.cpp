@@ -0,0 +1,175 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "tracer.h"
+#include <algorithm>
+#include <cstdio>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Buffers of exited threads kept for dumps before the oldest are let go
+constexpr size_t kRetiredBuffers = 64;
+
+void append_json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        out += c;
+    }
+    out += '"';
+}
+
+}  // namespace
+
+struct Tracer::BufferHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~BufferHolder() {
+        if (buffer) buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+Tracer& Tracer::global() {
+    static Tracer* tracer = new Tracer();  // Never destroyed: threads may outlive statics
+    return *tracer;
+}
+
+Tracer::ThreadBuffer& Tracer::local() {
+    static thread_local BufferHolder holder;
+    if (!holder.buffer) {
+        holder.buffer = std::make_shared<ThreadBuffer>();
+        holder.buffer->tid = static_cast<int>(syscall(SYS_gettid));
+
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        size_t retired = 0;
+        for (auto& b : buffers_) retired += b->retired.load(std::memory_order_relaxed);
+        for (auto it = buffers_.begin(); retired > kRetiredBuffers && it != buffers_.end();) {
+            if ((*it)->retired.load(std::memory_order_relaxed)) {
+                it = buffers_.erase(it);
+                retired--;
+            } else {
+                ++it;
+            }
+        }
+        buffers_.push_back(holder.buffer);
+    }
+    return *holder.buffer;
+}
+
+uint64_t Tracer::sample() {
+    uint32_t every = sample_every_.load(std::memory_order_relaxed);
+    if (every == 0) return 0;
+    ThreadBuffer& buffer = local();
+    if (buffer.sample_counter++ % every != 0) return 0;
+    return next_id_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Tracer::record(uint64_t trace_id, const char* name, uint64_t begin_ns, uint64_t end_ns, int64_t arg) {
+    ThreadBuffer& buffer = local();
+    uint64_t index = buffer.head.load(std::memory_order_relaxed);
+    Slot& slot = buffer.slots[index % kEventsPerThread];
+
+    uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = Event{trace_id, name, begin_ns, end_ns, arg};
+    slot.version.store(version + 2, std::memory_order_release);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::set_thread_name(const std::string& name) {
+    ThreadBuffer& buffer = local();
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffer.name = name;
+}
+
+void Tracer::clear() {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<ThreadBuffer>& b) { return b->retired.load(); }),
+                   buffers_.end());
+    // Live threads keep their buffers; dumps skip what they recorded so far
+    cleared_at_ = ChatUtils::Clock::monotonic_ns();
+}
+
+std::string Tracer::to_chrome_json() const {
+    struct Flat {
+        Event event;
+        int tid;
+    };
+    std::vector<Flat> events;
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        uint64_t cleared_at = cleared_at_;
+        for (const auto& b : buffers_) {
+            uint64_t head = b->head.load(std::memory_order_acquire);
+            uint64_t begin = head > kEventsPerThread ? head - kEventsPerThread : 0;
+            for (uint64_t i = begin; i < head; ++i) {
+                const Slot& slot = b->slots[i % kEventsPerThread];
+                uint64_t before = slot.version.load(std::memory_order_acquire);
+                Event e = slot.event;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if ((before & 1) || slot.version.load(std::memory_order_relaxed) != before) continue;
+                if (e.begin_ns < cleared_at) continue;
+                events.push_back(Flat{e, b->tid});
+            }
+
+            if (!b->name.empty()) {
+                out += first ? "" : ",";
+                first = false;
+                std::snprintf(line, sizeof(line), "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", b->tid);
+                out += line;
+                append_json_string(out, b->name);
+                out += "}}";
+            }
+        }
+    }
+
+    // One complete ("X") event per span
+    for (const Flat& f : events) {
+        const Event& e = f.event;
+        std::snprintf(line, sizeof(line),
+                      "%s{\"ph\":\"X\",\"cat\":\"message\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"trace_id\":%llu",
+                      first ? "" : ",", e.name, f.tid, e.begin_ns / 1000.0,
+                      (e.end_ns > e.begin_ns ? e.end_ns - e.begin_ns : 0) / 1000.0,
+                      static_cast<unsigned long long>(e.trace_id));
+        first = false;
+        out += line;
+        if (e.arg >= 0) {
+            std::snprintf(line, sizeof(line), ",\"arg\":%lld", static_cast<long long>(e.arg));
+            out += line;
+        }
+        out += "}}";
+    }
+
+    // Flow arrows tie one message's spans together across threads
+    std::sort(events.begin(), events.end(), [](const Flat& a, const Flat& b) {
+        return a.event.trace_id != b.event.trace_id ? a.event.trace_id < b.event.trace_id
+                                                    : a.event.begin_ns < b.event.begin_ns;
+    });
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i].event;
+        bool starts = i == 0 || events[i - 1].event.trace_id != e.trace_id;
+        bool ends = i + 1 == events.size() || events[i + 1].event.trace_id != e.trace_id;
+        if (starts && ends) continue;  // A lone span needs no arrow
+        const char* phase = starts ? "s" : ends ? "f" : "t";
+        std::snprintf(line, sizeof(line),
+                      ",{\"ph\":\"%s\",\"cat\":\"message\",\"name\":\"message\",\"id\":%llu,\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f%s}",
+                      phase, static_cast<unsigned long long>(e.trace_id), events[i].tid, e.begin_ns / 1000.0,
+                      ends ? ",\"bp\":\"e\"" : "");
+        out += line;
+    }
+
+    out += "]}\n";
+    return out;
+}
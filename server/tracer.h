@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Sampled per-message tracing with Chrome trace-event export
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../shared/clock.h"
+
+/**
+ * A sampled message gets a non-zero trace id at ingest (Message::trace_id)
+ * and every stage it passes through records a span against that id:
+ *
+ *   read      payload bytes arriving after the length prefix
+ *   decode    Message::parse
+ *   queue     waiting in the client's inbox for its strand
+ *   stages    pipeline stages (validate, timestamp, hooks)
+ *   sequence  waiting in the room's sequencer queue
+ *   fan_out   member-list lock plus every send
+ *   write     one recipient's send (arg: recipient id)
+ *
+ * Spans go into a per-thread flight-recorder ring (newest kept) and are
+ * only formatted when someone asks for a dump. Unsampled messages cost one
+ * branch per probe.
+ */
+class Tracer {
+public:
+    static constexpr size_t kEventsPerThread = 1024;
+
+    static Tracer& global();
+
+    // Trace every n-th message per ingest thread; 0 turns tracing off
+    void set_sample_every(uint32_t n) { sample_every_.store(n, std::memory_order_relaxed); }
+    uint32_t sample_every() const { return sample_every_.load(std::memory_order_relaxed); }
+
+    // New trace id for a message entering the server, or 0 if not sampled
+    uint64_t sample();
+
+    void record(uint64_t trace_id, const char* name, uint64_t begin_ns, uint64_t end_ns, int64_t arg = -1);
+
+    // Label the calling thread in dumps ("client 7", "worker 0", ...)
+    void set_thread_name(const std::string& name);
+
+    // Everything currently buffered, as Chrome trace-event JSON
+    // (load in chrome://tracing or ui.perfetto.dev)
+    std::string to_chrome_json() const;
+
+    // Forget everything recorded so far
+    void clear();
+
+private:
+    struct Event {
+        uint64_t trace_id;
+        const char* name;  // Static string
+        uint64_t begin_ns;
+        uint64_t end_ns;
+        int64_t arg;
+    };
+
+    // Seqlock per slot so a dump never reads a half-written event
+    struct Slot {
+        std::atomic<uint64_t> version{0};  // Odd while being written
+        Event event;
+    };
+
+    struct ThreadBuffer {
+        std::atomic<uint64_t> head{0};
+        Slot slots[kEventsPerThread];
+        int tid = 0;
+        std::string name;
+        std::atomic<bool> retired{false};
+        uint64_t sample_counter = 0;
+    };
+
+    struct BufferHolder;
+
+    Tracer() = default;
+    ThreadBuffer& local();
+
+    std::atomic<uint32_t> sample_every_{0};
+    std::atomic<uint64_t> next_id_{1};
+
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    uint64_t cleared_at_ = 0;  // Spans that began before the last clear() are hidden
+};
+
+// Records [construction, destruction) as one span when trace_id != 0
+class TraceSpan {
+public:
+    TraceSpan(uint64_t trace_id, const char* name, int64_t arg = -1)
+        : trace_id_(trace_id), name_(name), arg_(arg),
+          begin_ns_(trace_id ? ChatUtils::Clock::monotonic_ns() : 0) {}
+
+    ~TraceSpan() {
+        if (trace_id_) Tracer::global().record(trace_id_, name_, begin_ns_, ChatUtils::Clock::monotonic_ns(), arg_);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    uint64_t trace_id_;
+    const char* name_;
+    int64_t arg_;
+    uint64_t begin_ns_;
+};
+
+#endif  // TRACER_H
@@ -0,0 +1,51 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ */
+
+#include "user_directory.h"
+#include <mutex>
+
+void UserDirectory::add(const std::string& user, const std::shared_ptr<ClientHandler>& client) {
+    Shard& shard = shard_for(user);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.users[user] = client;
+}
+
+void UserDirectory::remove(const std::string& user, const ClientHandler* client) {
+    std::shared_ptr<ClientHandler> removed;  // Released after unlocking
+    Shard& shard = shard_for(user);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(user);
+    if (it != shard.users.end() && it->second.get() == client) {
+        removed = std::move(it->second);
+        shard.users.erase(it);
+    }
+}
+
+std::shared_ptr<ClientHandler> UserDirectory::find(const std::string& user) const {
+    const Shard& shard = shard_for(user);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.users.find(user);
+    return it != shard.users.end() ? it->second : nullptr;
+}
+
+size_t UserDirectory::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.users.size();
+    }
+    return total;
+}
+
+void UserDirectory::clear() {
+    for (Shard& shard : shards_) {
+        // A handler freed here may leave on its way out, which takes the lock
+        std::unordered_map<std::string, std::shared_ptr<ClientHandler>> users;
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            users.swap(shard.users);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Username -> connection directory for direct messages
+ */
+
+#ifndef USER_DIRECTORY_H
+#define USER_DIRECTORY_H
+
+#include <array>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+class ClientHandler;
+
+/**
+ * Hash map split into shards by the name's hash, each behind its own
+ * reader/writer lock. A lookup is one hash, one shared lock on 1/64th of
+ * the users and one map probe, so readers on different names never touch
+ * the same lock and readers of the same shard do not block each other;
+ * only joins and leaves take a shard exclusively.
+ *
+ * Names are not unique: the newest registration wins (a reconnecting
+ * client usually arrives before its old connection has gone), and
+ * remove() only removes the entry if it still belongs to that client.
+ */
+class UserDirectory {
+public:
+    static constexpr size_t kShards = 64;
+
+    UserDirectory() = default;
+    ~UserDirectory() { clear(); }
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
+
+    void add(const std::string& user, const std::shared_ptr<ClientHandler>& client);
+    void remove(const std::string& user, const ClientHandler* client);
+
+    // The connection registered under `user`, or null
+    std::shared_ptr<ClientHandler> find(const std::string& user) const;
+
+    size_t size() const;
+    void clear();
+
+private:
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<ClientHandler>> users;
+    };
+
+    Shard& shard_for(const std::string& user) { return shards_[std::hash<std::string>()(user) % kShards]; }
+    const Shard& shard_for(const std::string& user) const {
+        return shards_[std::hash<std::string>()(user) % kShards];
+    }
+
+    std::array<Shard, kShards> shards_;
+};
+
+#endif  // USER_DIRECTORY_H
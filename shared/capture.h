@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Traffic capture file format (written by chat_server --capture, read by chat_replay)
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "protocol.h"
+
+namespace ChatUtils {
+
+/*
+ * File layout, all integers little-endian:
+ *
+ *   header   "CHATCAP1" | u64 realtime ns at capture start
+ *   record   u64 ns since start | u32 connection | u16 kind | u16 length | payload
+ *
+ * A connection's first record is HELLO (the join frame), then its FRAMEs,
+ * then BYE when it goes away. Payloads are the JSON exactly as read off the
+ * socket, without the length prefix.
+ */
+struct CaptureRecord {
+    enum Kind : uint16_t { HELLO = 1, FRAME = 2, BYE = 3 };
+
+    uint64_t ns;
+    uint32_t connection;
+    uint16_t kind;
+    std::string payload;
+};
+
+constexpr char kCaptureMagic[8] = {'C', 'H', 'A', 'T', 'C', 'A', 'P', '1'};
+constexpr size_t kCaptureHeaderLen = 16;
+constexpr size_t kCaptureRecordHeaderLen = 16;
+
+inline void capture_put(char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<char>(value >> (8 * i));
+}
+
+inline uint64_t capture_get(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+// Load a whole capture; false if the file is missing or not a capture.
+// A record cut short at the end (server killed mid-write) is ignored.
+inline bool read_capture(const std::string& path, std::vector<CaptureRecord>& records, uint64_t* start_realtime_ns = nullptr) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char header[kCaptureHeaderLen];
+    if (std::fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        std::memcmp(header, kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+        std::fclose(f);
+        return false;
+    }
+    if (start_realtime_ns) *start_realtime_ns = capture_get(header + 8, 8);
+
+    char rec[kCaptureRecordHeaderLen];
+    while (std::fread(rec, 1, sizeof(rec), f) == sizeof(rec)) {
+        CaptureRecord r;
+        r.ns = capture_get(rec, 8);
+        r.connection = static_cast<uint32_t>(capture_get(rec + 8, 4));
+        r.kind = static_cast<uint16_t>(capture_get(rec + 12, 2));
+        r.payload.resize(capture_get(rec + 14, 2));
+        if (!r.payload.empty() && std::fread(&r.payload[0], 1, r.payload.size(), f) != r.payload.size()) break;
+        records.push_back(std::move(r));
+    }
+    std::fclose(f);
+    return true;
+}
+
+// A captured hello as a replayer should send it: one that reads plain
+// frames must not offer compressed batches ("deflate"), and one that
+// matches echoes by sender name must not ask for ids ("intern")
+inline std::string replay_hello(const std::string& payload) {
+    Message hello = Message::from_json(payload);
+    hello.deflate = false;
+    hello.intern = false;
+    return hello.to_json();
+}
+
+}  // namespace ChatUtils
+
+#endif  // CAPTURE_H
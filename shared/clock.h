@@ -0,0 +1,105 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Clock service: cheap wall-clock ISO-8601 strings and monotonic time
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+namespace ChatUtils {
+
+/**
+ * Wall-clock formatting goes through a per-thread cache of the
+ * "YYYY-MM-DDTHH:MM:SS" prefix for the current second, so gmtime_r and
+ * strftime run at most once per second per thread. Sub-second digits are
+ * appended by hand.
+ */
+class Clock {
+public:
+    enum class Precision { SECONDS, MILLIS, MICROS };
+
+    // Longest string format_iso8601() writes, terminator included
+    static constexpr size_t kIsoLen = sizeof("2025-12-08T01:47:00.123456Z");
+
+    // Monotonic nanoseconds; only meaningful as a difference (latency)
+    static uint64_t monotonic_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    // Wall-clock nanoseconds since the Unix epoch
+    static int64_t realtime_ns() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    /**
+     * Write `ns` (realtime) as UTC ISO-8601, e.g. 2025-12-08T01:47:00.123Z.
+     * Returns the length written, 0 if `cap` is too small.
+     */
+    static size_t format_iso8601(int64_t ns, char* out, size_t cap, Precision precision = Precision::SECONDS) {
+        static const size_t kFraction[] = {0, 4, 7};  // "", ".mmm", ".uuuuuu"
+        size_t fraction = kFraction[static_cast<int>(precision)];
+        if (cap < kPrefixLen + fraction + 2) {
+            if (cap) out[0] = '\0';
+            return 0;
+        }
+
+        int64_t second = ns >= 0 ? ns / 1000000000 : (ns - 999999999) / 1000000000;
+        SecondCache& cache = second_cache();
+        if (cache.second != second) {
+            time_t t = static_cast<time_t>(second);
+            struct tm utc;
+            gmtime_r(&t, &utc);
+            strftime(cache.prefix, sizeof(cache.prefix), "%Y-%m-%dT%H:%M:%S", &utc);
+            cache.second = second;
+        }
+        std::memcpy(out, cache.prefix, kPrefixLen);
+
+        char* p = out + kPrefixLen;
+        if (fraction) {
+            uint32_t sub = static_cast<uint32_t>(ns - second * 1000000000);
+            int digits = precision == Precision::MILLIS ? 3 : 6;
+            sub /= precision == Precision::MILLIS ? 1000000 : 1000;
+            *p++ = '.';
+            for (int i = digits - 1; i >= 0; --i) {
+                p[i] = static_cast<char>('0' + sub % 10);
+                sub /= 10;
+            }
+            p += digits;
+        }
+        *p++ = 'Z';
+        *p = '\0';
+        return static_cast<size_t>(p - out);
+    }
+
+    static size_t format_now(char* out, size_t cap, Precision precision = Precision::SECONDS) {
+        return format_iso8601(realtime_ns(), out, cap, precision);
+    }
+
+private:
+    static constexpr size_t kPrefixLen = 19;  // "YYYY-MM-DDTHH:MM:SS"
+
+    struct SecondCache {
+        int64_t second = INT64_MIN;
+        char prefix[32];
+    };
+
+    static SecondCache& second_cache() {
+        static thread_local SecondCache cache;
+        return cache;
+    }
+};
+
+}  // namespace ChatUtils
+
+#endif  // CLOCK_H
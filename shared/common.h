@@ -12,28 +12,94 @@
 #include <string>
 #include <vector>
 #include <cstring>
+#include <cerrno>
 #include <arpa/inet.h>
+#include <sys/socket.h>
+#include "logger.h"
 #include "protocol.h"
 
 namespace ChatUtils {
 
 // ===== Socket Utilities =====
 
+/**
+ * Send one already-framed buffer: [4-byte big-endian length] [payload].
+ * Loops over short writes; MSG_NOSIGNAL so a vanished peer is an error, not SIGPIPE.
+ */
+inline bool send_frame(int socket, const char* frame, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(socket, frame, len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        frame += sent;
+        len -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * Write whatever part of `len` bytes the socket takes right now, without
+ * waiting: the count written (0 if the socket is full), -1 on error.
+ */
+inline ssize_t send_some(int socket, const char* data, size_t len) {
+    ssize_t sent;
+    do {
+        sent = send(socket, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    return sent;
+}
+
+/**
+ * Frame a message into `out` (at least MAX_FRAME_LEN + 4 bytes).
+ * Returns the total frame length, 0 if the message did not fit.
+ */
+inline size_t encode_frame(const Message& msg, char* out, size_t cap, NameForm names = NameForm::NAMES) {
+    if (cap < 5) return 0;
+    size_t json_len = msg.encode(out + 4, cap - 5, names);
+    if (json_len == 0) return 0;
+    out[4 + json_len] = MESSAGE_SEPARATOR;
+    uint32_t len = htonl(static_cast<uint32_t>(json_len + 1));
+    std::memcpy(out, &len, sizeof(len));
+    return 4 + json_len + 1;
+}
+
 /**
  * Send a message over socket with length prefix
  * Format: [4-byte big-endian length] [JSON payload]
  */
 inline bool send_message(int socket, const Message& msg) {
-    std::string json = msg.to_json() + "\n";
-    uint32_t len = htonl(static_cast<uint32_t>(json.length()));
-    
-    if (send(socket, &len, sizeof(len), 0) < 0) {
-        perror("send (length)");
+    char frame[MAX_FRAME_LEN + 4];
+    size_t len = encode_frame(msg, frame, sizeof(frame));
+    if (len == 0 || !send_frame(socket, frame, len)) {
+        perror("send");
         return false;
     }
-    if (send(socket, json.c_str(), json.length(), 0) < 0) {
-        perror("send (payload)");
-        return false;
+    return true;
+}
+
+/**
+ * Receive one frame's payload into `buffer` (at least MAX_FRAME_LEN bytes).
+ * Reads length prefix, then exact number of bytes; strips the trailing newline.
+ * `prefix_ns`, if given, gets the monotonic time the length prefix arrived.
+ */
+inline bool recv_frame(int socket, char* buffer, size_t& len, uint64_t* prefix_ns = nullptr) {
+    uint32_t len_net = 0;
+    ssize_t bytes = recv(socket, &len_net, sizeof(len_net), MSG_WAITALL);
+    if (bytes != static_cast<ssize_t>(sizeof(len_net))) return false;  // Connection closed or error
+    if (prefix_ns) *prefix_ns = Clock::monotonic_ns();
+
+    len = ntohl(len_net);
+    if (len > MAX_FRAME_LEN) return false;  // Sanity check
+
+    bytes = recv(socket, buffer, len, MSG_WAITALL);
+    if (bytes != static_cast<ssize_t>(len)) return false;
+
+    // Remove trailing newline if present
+    if (len > 0 && buffer[len - 1] == MESSAGE_SEPARATOR) {
+        len--;
     }
     return true;
 }
@@ -43,42 +109,37 @@ inline bool send_message(int socket, const Message& msg) {
  * Reads length prefix, then exact number of bytes
  */
 inline bool recv_message(int socket, Message& msg) {
-    uint32_t len_net = 0;
-    int bytes = recv(socket, &len_net, sizeof(len_net), MSG_WAITALL);
-    
-    if (bytes <= 0) return false;  // Connection closed or error
-    
-    uint32_t len = ntohl(len_net);
-    if (len > 2048) return false;  // Sanity check
-    
-    std::string buffer(len, '\0');
-    bytes = recv(socket, &buffer[0], len, MSG_WAITALL);
-    
-    if (bytes <= 0) return false;
-    
-    // Remove trailing newline if present
-    if (!buffer.empty() && buffer.back() == '\n') {
-        buffer.pop_back();
-    }
-    
-    msg = Message::from_json(buffer);
+    char buffer[MAX_FRAME_LEN];
+    size_t len = 0;
+    if (!recv_frame(socket, buffer, len)) return false;
+    Message::parse(buffer, len, msg);
     return true;
 }
 
 // ===== Logging =====
 
-enum class LogLevel { DEBUG, INFO, WARN, ERROR };
-
+/**
+ * Log through the asynchronous Logger (see logger.h). The macros take any
+ * mix of strings and numbers and skip evaluating them when the level is
+ * filtered out:  LOG_INFO("Server", "Client ", id, " connected");
+ */
 inline void log(LogLevel level, const std::string& module, const std::string& msg) {
-    const char* level_str[] = {"[DEBUG]", "[INFO]", "[WARN]", "[ERROR]"};
-    std::cerr << level_str[static_cast<int>(level)] 
-              << " [" << module << "] " << msg << std::endl;
+    Logger& logger = Logger::instance();
+    if (logger.enabled(level)) logger.write(level, module.c_str(), msg);
 }
 
-#define LOG_INFO(module, msg) log(LogLevel::INFO, module, msg)
-#define LOG_WARN(module, msg) log(LogLevel::WARN, module, msg)
-#define LOG_ERROR(module, msg) log(LogLevel::ERROR, module, msg)
-#define LOG_DEBUG(module, msg) log(LogLevel::DEBUG, module, msg)
+#define CHAT_LOG(level, module, ...)                                       \
+    do {                                                                   \
+        ChatUtils::Logger& chat_logger_ = ChatUtils::Logger::instance();   \
+        if (chat_logger_.enabled(level)) {                                 \
+            chat_logger_.write(level, module, __VA_ARGS__);                \
+        }                                                                  \
+    } while (0)
+
+#define LOG_INFO(module, ...) CHAT_LOG(ChatUtils::LogLevel::INFO, module, __VA_ARGS__)
+#define LOG_WARN(module, ...) CHAT_LOG(ChatUtils::LogLevel::WARN, module, __VA_ARGS__)
+#define LOG_ERROR(module, ...) CHAT_LOG(ChatUtils::LogLevel::ERROR, module, __VA_ARGS__)
+#define LOG_DEBUG(module, ...) CHAT_LOG(ChatUtils::LogLevel::DEBUG, module, __VA_ARGS__)
 
 }  // namespace ChatUtils
 
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Streaming deflate for compressed batch frames
+ */
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <cstring>
+#include <zlib.h>
+
+namespace ChatUtils {
+
+/**
+ * One direction of a connection's deflate stream. Each block ends with a
+ * sync flush, so the peer can inflate it as soon as it arrives, while the
+ * 32 KiB window carries over: a block is compressed against everything
+ * the connection was sent before it, not just its own bytes. Raw deflate
+ * (no zlib header or checksum; TCP already has one).
+ *
+ * The stream allocates once, when constructed (about 150 KiB to deflate,
+ * 40 KiB to inflate); blocks never do.
+ */
+class DeflateStream {
+public:
+    // Fast levels suit chat: most of the win is repeated keys and names
+    explicit DeflateStream(int level = 1) {
+        std::memset(&z_, 0, sizeof(z_));
+        ok_ = init_ = deflateInit2(&z_, level, Z_DEFLATED, -15, 5, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~DeflateStream() {
+        if (init_) deflateEnd(&z_);
+    }
+
+    DeflateStream(const DeflateStream&) = delete;
+    DeflateStream& operator=(const DeflateStream&) = delete;
+
+    bool ok() const { return ok_; }
+
+    // Worst-case block size for `len` input bytes
+    static size_t bound(size_t len) { return len + len / 16 + 64; }
+
+    // Start a block written to `out`
+    void begin(char* out, size_t cap) {
+        z_.next_out = reinterpret_cast<Bytef*>(out);
+        z_.avail_out = static_cast<uInt>(cap);
+        cap_ = cap;
+    }
+
+    bool write(const char* data, size_t len) { return run(data, len, Z_NO_FLUSH); }
+
+    // Finish the block; its length, 0 if it did not fit (the stream is then unusable)
+    size_t end() {
+        if (!run(nullptr, 0, Z_SYNC_FLUSH)) return 0;
+        return cap_ - z_.avail_out;
+    }
+
+private:
+    bool run(const char* data, size_t len, int flush) {
+        if (!ok_) return false;
+        z_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        z_.avail_in = static_cast<uInt>(len);
+        int rc = deflate(&z_, flush);
+        if ((rc != Z_OK && rc != Z_BUF_ERROR) || z_.avail_in != 0 || z_.avail_out == 0) {
+            ok_ = false;  // Out of room: the stream state is past repair
+            return false;
+        }
+        return true;
+    }
+
+    z_stream z_;
+    bool init_ = false;
+    bool ok_ = false;  // Initialised and not broken
+    size_t cap_ = 0;
+};
+
+// The receiving side of a DeflateStream
+class InflateStream {
+public:
+    InflateStream() {
+        std::memset(&z_, 0, sizeof(z_));
+        ok_ = init_ = inflateInit2(&z_, -15) == Z_OK;
+    }
+    ~InflateStream() {
+        if (init_) inflateEnd(&z_);
+    }
+
+    InflateStream(const InflateStream&) = delete;
+    InflateStream& operator=(const InflateStream&) = delete;
+
+    // Inflate one block into `out`; its length, or -1 if the block is
+    // corrupt or does not fit in less than `cap` bytes
+    long inflate_block(const char* data, size_t len, char* out, size_t cap) {
+        if (!ok_) return -1;
+        z_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        z_.avail_in = static_cast<uInt>(len);
+        z_.next_out = reinterpret_cast<Bytef*>(out);
+        z_.avail_out = static_cast<uInt>(cap);
+        int rc = inflate(&z_, Z_SYNC_FLUSH);
+        if ((rc != Z_OK && rc != Z_BUF_ERROR) || z_.avail_in != 0 || z_.avail_out == 0) {
+            ok_ = false;
+            return -1;
+        }
+        return static_cast<long>(cap - z_.avail_out);
+    }
+
+private:
+    z_stream z_;
+    bool init_ = false;
+    bool ok_ = false;
+};
+
+}  // namespace ChatUtils
+
+#endif  // COMPRESSION_H
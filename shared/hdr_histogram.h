@@ -0,0 +1,145 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * HDR-style log-linear histogram for latency measurement
+ */
+
+#ifndef HDR_HISTOGRAM_H
+#define HDR_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ChatUtils {
+
+/**
+ * Fixed-size log-linear histogram. Values below 2^kSubBits are counted
+ * exactly; above that each power-of-two range is split into 2^kSubBits
+ * linear buckets, so any recorded value is reported within ~3% (like an
+ * HdrHistogram with two significant digits). Values past kMaxValue are
+ * clamped into the last bucket.
+ *
+ * record() is a relaxed atomic add and safe from any thread; in the server
+ * each thread records into its own instance and scrapes merge them.
+ */
+class HdrHistogram {
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr int kMaxExponent = 40;  // 2^40 ns ~ 18 minutes
+    static constexpr uint64_t kMaxValue = (1ULL << (kMaxExponent + 1)) - 1;
+    static constexpr size_t kBucketCount = static_cast<size_t>(kMaxExponent - kSubBits + 2) << kSubBits;
+
+    HdrHistogram() { reset(); }
+
+    HdrHistogram(const HdrHistogram& other) {
+        reset();
+        merge(other);
+    }
+
+    HdrHistogram& operator=(const HdrHistogram& other) {
+        if (this != &other) {
+            reset();
+            merge(other);
+        }
+        return *this;
+    }
+
+    void record(uint64_t value, uint64_t count = 1) {
+        if (value > kMaxValue) value = kMaxValue;
+        buckets_[bucket_index(value)].fetch_add(count, std::memory_order_relaxed);
+        total_.fetch_add(count, std::memory_order_relaxed);
+        sum_.fetch_add(value * count, std::memory_order_relaxed);
+
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Add another histogram's counts into this one
+    void merge(const HdrHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+            if (n) buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+        total_.fetch_add(other.count(), std::memory_order_relaxed);
+        sum_.fetch_add(other.sum(), std::memory_order_relaxed);
+        uint64_t other_max = other.max();
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (other_max > seen && !max_.compare_exchange_weak(seen, other_max, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        total_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? static_cast<double>(sum()) / count() : 0.0; }
+
+    // Smallest value v such that `percentile` percent of samples are <= v
+    uint64_t value_at_percentile(double percentile) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total) rank = total;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = bucket_upper(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    // Samples <= `value` (exact at bucket boundaries, otherwise conservative)
+    uint64_t count_at_or_below(uint64_t value) const {
+        uint64_t n = 0;
+        for (size_t i = 0; i < kBucketCount && bucket_upper(i) <= value; ++i) {
+            n += buckets_[i].load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < (1ULL << kSubBits)) return static_cast<size_t>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int shift = exponent - kSubBits;
+        size_t group = static_cast<size_t>(shift + 1);
+        size_t sub = static_cast<size_t>((value >> shift) - (1ULL << kSubBits));
+        return (group << kSubBits) + sub;
+    }
+
+    static uint64_t bucket_lower(size_t index) {
+        size_t group = index >> kSubBits;
+        if (group == 0) return index;
+        uint64_t sub = index & ((1u << kSubBits) - 1);
+        return ((1ULL << kSubBits) + sub) << (group - 1);
+    }
+
+    static uint64_t bucket_upper(size_t index) {
+        size_t group = index >> kSubBits;
+        if (group == 0) return index;
+        return bucket_lower(index) + (1ULL << (group - 1)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> buckets_[kBucketCount];
+    std::atomic<uint64_t> total_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+}  // namespace ChatUtils
+
+#endif  // HDR_HISTOGRAM_H
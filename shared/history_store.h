@@ -0,0 +1,207 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Append-only on-disk message history with an offset index, read through mmap
+ */
+
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ChatUtils {
+
+/**
+ * Two files per history:
+ *
+ *   <base>.log   records: u32 length | "user\0timestamp\0text"
+ *   <base>.idx   u64 offset of every record in .log, in order
+ *
+ * Appends go through pwrite at the end of each file (data first, then its
+ * index entry, so a crash can only lose the last message). Reads go
+ * through read-only mappings of both files, so opening costs the same
+ * however long the history is, and only the pages actually read become
+ * resident. The mappings are refreshed when a read goes past them.
+ */
+class HistoryStore {
+public:
+    HistoryStore() = default;
+    ~HistoryStore() { close(); }
+
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    bool open(const std::string& base_path) {
+        close();
+        data_fd_ = ::open((base_path + ".log").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        index_fd_ = ::open((base_path + ".idx").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (data_fd_ < 0 || index_fd_ < 0) {
+            close();
+            return false;
+        }
+
+        struct stat data_st, index_st;
+        if (fstat(data_fd_, &data_st) != 0 || fstat(index_fd_, &index_st) != 0) {
+            close();
+            return false;
+        }
+        data_size_ = static_cast<uint64_t>(data_st.st_size);
+        count_ = static_cast<uint64_t>(index_st.st_size) / sizeof(uint64_t);
+
+        // Drop index entries whose record did not make it to disk
+        while (count_ > 0 && !record_complete(count_ - 1)) count_--;
+        if (count_ > 0) {
+            data_size_ = offset(count_ - 1) + sizeof(uint32_t) + record_length(count_ - 1);
+        } else {
+            data_size_ = 0;
+        }
+        // Cut any torn tail so later appends never sit behind stale entries
+        if (ftruncate(index_fd_, static_cast<off_t>(count_ * sizeof(uint64_t))) != 0 ||
+            ftruncate(data_fd_, static_cast<off_t>(data_size_)) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        unmap();
+        if (data_fd_ >= 0) ::close(data_fd_);
+        if (index_fd_ >= 0) ::close(index_fd_);
+        data_fd_ = index_fd_ = -1;
+        count_ = data_size_ = 0;
+    }
+
+    bool is_open() const { return data_fd_ >= 0; }
+    uint64_t count() const { return count_; }
+
+    // Append one message; returns its index, or UINT64_MAX on I/O failure
+    uint64_t append(const std::string& user, const std::string& timestamp, const std::string& text) {
+        if (!is_open()) return UINT64_MAX;
+        std::string record(sizeof(uint32_t), '\0');
+        record += user;
+        record += '\0';
+        record += timestamp;
+        record += '\0';
+        record += text;
+        uint32_t len = static_cast<uint32_t>(record.size() - sizeof(uint32_t));
+        std::memcpy(&record[0], &len, sizeof(len));
+
+        uint64_t at = data_size_;
+        if (!write_all(data_fd_, record.data(), record.size(), at) ||
+            !write_all(index_fd_, &at, sizeof(at), count_ * sizeof(uint64_t))) {
+            return UINT64_MAX;
+        }
+        data_size_ += record.size();
+        return count_++;
+    }
+
+    // Fetch message `index` (0 = oldest)
+    bool get(uint64_t index, std::string& user, std::string& timestamp, std::string& text) {
+        if (index >= count_ || !ensure_mapped(index)) return false;
+        const char* p = data_map_ + offset(index) + sizeof(uint32_t);
+        const char* end = p + record_length(index);
+        const char* a = static_cast<const char*>(std::memchr(p, '\0', end - p));
+        const char* b = a ? static_cast<const char*>(std::memchr(a + 1, '\0', end - a - 1)) : nullptr;
+        if (!b) return false;
+        user.assign(p, a);
+        timestamp.assign(a + 1, b);
+        text.assign(b + 1, end);
+        return true;
+    }
+
+private:
+    static bool write_all(int fd, const void* buf, size_t len, uint64_t at) {
+        const char* p = static_cast<const char*>(buf);
+        while (len > 0) {
+            ssize_t n = pwrite(fd, p, len, static_cast<off_t>(at));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            at += static_cast<uint64_t>(n);
+            len -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Raw reads used while validating on open (before anything is mapped)
+    uint64_t offset(uint64_t index) const {
+        if (index_map_ && index < index_mapped_) return index_map_[index];
+        uint64_t value = 0;
+        if (pread(index_fd_, &value, sizeof(value), static_cast<off_t>(index * sizeof(uint64_t))) != sizeof(value)) {
+            return UINT64_MAX;
+        }
+        return value;
+    }
+
+    uint32_t record_length(uint64_t index) const {
+        uint64_t at = offset(index);
+        if (data_map_ && at + sizeof(uint32_t) <= data_mapped_) {
+            uint32_t len;
+            std::memcpy(&len, data_map_ + at, sizeof(len));
+            return len;
+        }
+        uint32_t len = 0;
+        if (pread(data_fd_, &len, sizeof(len), static_cast<off_t>(at)) != sizeof(len)) return UINT32_MAX;
+        return len;
+    }
+
+    bool record_complete(uint64_t index) const {
+        uint64_t at = offset(index);
+        uint32_t len = record_length(index);
+        return at != UINT64_MAX && len != UINT32_MAX && at + sizeof(uint32_t) + len <= data_size_;
+    }
+
+    // Map (or remap) so record `index` is readable; records below
+    // index_mapped_ always lie inside the data mapping
+    bool ensure_mapped(uint64_t index) {
+        if (index < index_mapped_) return true;
+        unmap();
+        if (count_ == 0) return true;
+
+        void* offsets = mmap(nullptr, count_ * sizeof(uint64_t), PROT_READ, MAP_SHARED, index_fd_, 0);
+        void* data = mmap(nullptr, data_size_, PROT_READ, MAP_SHARED, data_fd_, 0);
+        if (offsets == MAP_FAILED || data == MAP_FAILED) {
+            if (offsets != MAP_FAILED) munmap(offsets, count_ * sizeof(uint64_t));
+            if (data != MAP_FAILED) munmap(data, data_size_);
+            return false;
+        }
+        index_map_ = static_cast<const uint64_t*>(offsets);
+        index_mapped_ = count_;
+        data_map_ = static_cast<const char*>(data);
+        data_mapped_ = data_size_;
+        return true;
+    }
+
+    void unmap() {
+        if (index_map_) munmap(const_cast<uint64_t*>(index_map_), index_mapped_ * sizeof(uint64_t));
+        if (data_map_) munmap(const_cast<char*>(data_map_), data_mapped_);
+        index_map_ = nullptr;
+        data_map_ = nullptr;
+        index_mapped_ = data_mapped_ = 0;
+    }
+
+    int data_fd_ = -1;
+    int index_fd_ = -1;
+    uint64_t count_ = 0;      // Complete records
+    uint64_t data_size_ = 0;  // Bytes of .log in use
+
+    const uint64_t* index_map_ = nullptr;
+    uint64_t index_mapped_ = 0;  // Entries covered by index_map_
+    const char* data_map_ = nullptr;
+    uint64_t data_mapped_ = 0;   // Bytes covered by data_map_
+};
+
+}  // namespace ChatUtils
+
+#endif  // HISTORY_STORE_H
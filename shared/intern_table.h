@@ -0,0 +1,124 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Small integer ids for user and room names
+ */
+
+#ifndef INTERN_TABLE_H
+#define INTERN_TABLE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "protocol.h"
+
+namespace ChatUtils {
+
+// Room enough for either kind of name
+static constexpr size_t kInternedNameLen = MAX_USERNAME_LEN > MAX_ROOMNAME_LEN ? MAX_USERNAME_LEN : MAX_ROOMNAME_LEN;
+
+/**
+ * Name -> id for a whole server. A name keeps its id for the life of the
+ * table, so a frame encoded once with ids means the same to every
+ * connection; what differs per connection is only which ids it has been
+ * sent the names for (IdSet). Ids start at 1; past MAX_INTERNED_NAMES
+ * names intern() gives 0 and those names simply go out in full.
+ *
+ * Interning happens when a connection says hello, not per message, so a
+ * mutex is plenty.
+ */
+class InternTable {
+public:
+    // The id bound to `name`, binding the next one on first use; 0 for an
+    // empty name or a full table
+    uint32_t intern(const std::string& name) {
+        if (name.empty() || name.size() >= kInternedNameLen) return 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) return it->second;
+        if (names_.size() >= MAX_INTERNED_NAMES) return 0;
+        names_.push_back(name);
+        uint32_t id = static_cast<uint32_t>(names_.size());
+        ids_.emplace(name, id);
+        return id;
+    }
+
+    // The name bound to `id`; empty if none
+    std::string name(uint32_t id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return id && id <= names_.size() ? names_[id - 1] : std::string();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return names_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<std::string> names_;  // By id - 1
+};
+
+// The ids one connection has been sent names for. Grows to the largest
+// id seen (8 KiB at most), then never allocates.
+class IdSet {
+public:
+    // True if `id` was not in the set (0 never is)
+    bool insert(uint32_t id) {
+        if (!id) return false;
+        size_t word = id / 64;
+        if (word >= bits_.size()) bits_.resize(word + 1);
+        uint64_t bit = uint64_t(1) << (id % 64);
+        if (bits_[word] & bit) return false;
+        bits_[word] |= bit;
+        return true;
+    }
+
+    // Forget every id; keeps the storage
+    void clear() { std::fill(bits_.begin(), bits_.end(), 0); }
+
+private:
+    std::vector<uint64_t> bits_;
+};
+
+/**
+ * The receiving side: id -> name as bound by the frames of one
+ * connection. Lookups are an index; a new connection starts empty.
+ */
+class NameDictionary {
+public:
+    // Bind `id` to `name`; false for an id out of range
+    bool bind(uint32_t id, const char* name) {
+        if (!id || id > MAX_INTERNED_NAMES) return false;
+        if (id > names_.size()) names_.resize(id);
+        Entry& entry = names_[id - 1];
+        std::strncpy(entry.name, name, kInternedNameLen - 1);
+        entry.name[kInternedNameLen - 1] = '\0';
+        return true;
+    }
+
+    // The name bound to `id`, or null
+    const char* find(uint32_t id) const {
+        if (!id || id > names_.size() || !names_[id - 1].name[0]) return nullptr;
+        return names_[id - 1].name;
+    }
+
+    void clear() { names_.clear(); }
+
+private:
+    struct Entry {
+        char name[kInternedNameLen] = {};
+    };
+    std::vector<Entry> names_;  // By id - 1
+};
+
+}  // namespace ChatUtils
+
+#endif  // INTERN_TABLE_H
@@ -0,0 +1,472 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Asynchronous logger: per-thread lock-free rings, deferred formatting and
+ * a background drain thread
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+#include "clock.h"
+#include "spsc_queue.h"
+
+namespace ChatUtils {
+
+enum class LogLevel { DEBUG, INFO, WARN, ERROR };
+
+/**
+ * One log call, captured raw. Arguments are stored as tagged binary values
+ * (integers, doubles, copied strings) and only turned into text on the
+ * drain thread. Strings that do not fit are truncated.
+ */
+struct LogRecord {
+    static constexpr size_t kDataSize = 232;
+
+    int64_t time_ns = 0;  // CLOCK_REALTIME at the call
+    uint8_t level = 0;
+    uint8_t truncated = 0;
+    uint16_t used = 0;
+    char data[kDataSize];  // Module string, then arguments
+
+    enum Tag : uint8_t { INT, UINT, DOUBLE, CHAR, BOOL, STR };
+
+    void put_raw(Tag tag, const void* bytes, size_t len) {
+        if (used + 1 + len > kDataSize) {
+            truncated = 1;
+            return;
+        }
+        data[used++] = static_cast<char>(tag);
+        std::memcpy(data + used, bytes, len);
+        used = static_cast<uint16_t>(used + len);
+    }
+
+    void put_str(const char* s, size_t len) {
+        size_t room = used + 3u < kDataSize ? kDataSize - used - 3u : 0;
+        if (len > room) {
+            len = room;
+            truncated = 1;
+        }
+        if (used + 3u > kDataSize) return;
+        uint16_t n = static_cast<uint16_t>(len);
+        data[used++] = static_cast<char>(STR);
+        std::memcpy(data + used, &n, sizeof(n));
+        std::memcpy(data + used + 2, s, len);
+        used = static_cast<uint16_t>(used + 2 + len);
+    }
+
+    void put(const char* s) { put_str(s ? s : "(null)", s ? std::strlen(s) : 6); }
+    void put(char* s) { put(static_cast<const char*>(s)); }
+    void put(const std::string& s) { put_str(s.data(), s.size()); }
+    void put(char c) { put_raw(CHAR, &c, 1); }
+    void put(bool b) {
+        uint8_t v = b;
+        put_raw(BOOL, &v, 1);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type put(T value) {
+        if (std::is_floating_point<T>::value) {
+            double v = static_cast<double>(value);
+            put_raw(DOUBLE, &v, sizeof(v));
+        } else if (std::is_signed<T>::value) {
+            int64_t v = static_cast<int64_t>(value);
+            put_raw(INT, &v, sizeof(v));
+        } else {
+            uint64_t v = static_cast<uint64_t>(value);
+            put_raw(UINT, &v, sizeof(v));
+        }
+    }
+
+    // Append the arguments as text (drain thread)
+    void format_args(std::string& out, size_t from) const {
+        size_t pos = from;
+        char num[32];
+        while (pos < used) {
+            Tag tag = static_cast<Tag>(data[pos++]);
+            switch (tag) {
+            case INT: {
+                int64_t v;
+                std::memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(v)));
+                break;
+            }
+            case UINT: {
+                uint64_t v;
+                std::memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::snprintf(num, sizeof(num), "%llu", static_cast<unsigned long long>(v)));
+                break;
+            }
+            case DOUBLE: {
+                double v;
+                std::memcpy(&v, data + pos, sizeof(v));
+                pos += sizeof(v);
+                out.append(num, std::snprintf(num, sizeof(num), "%g", v));
+                break;
+            }
+            case CHAR:
+                out.push_back(data[pos++]);
+                break;
+            case BOOL:
+                out.append(data[pos++] ? "true" : "false");
+                break;
+            case STR: {
+                uint16_t n;
+                std::memcpy(&n, data + pos, sizeof(n));
+                out.append(data + pos + 2, n);
+                pos += 2 + n;
+                break;
+            }
+            default:
+                return;
+            }
+        }
+    }
+};
+
+/**
+ * Process-wide logger. Each logging thread gets its own SPSC ring on first
+ * use; a call encodes its arguments into a slot and returns, it never takes
+ * a lock or waits for I/O. One drain thread formats the records and writes
+ * them in batches.
+ *
+ * - A full ring drops the record and counts it (dropped()).
+ * - set_level() filters at the call site, before arguments are evaluated.
+ * - set_rate_limit(n) caps each thread at n records per second (token
+ *   bucket, burst n); the excess is counted in rate_limited().
+ * The drain thread reports new drops as a WARN line of its own.
+ */
+class Logger {
+public:
+    static constexpr size_t kRingCapacity = 128;  // Records per thread (32KB)
+
+    static Logger& instance() {
+        // Never destroyed: threads may still log while statics are torn down
+        static Logger* logger = [] {
+            Logger* l = new Logger();
+            std::atexit([] { Logger::instance().shutdown(); });
+            return l;
+        }();
+        return *logger;
+    }
+
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+
+    void set_level(LogLevel level) { level_.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel level() const { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+
+    // "debug", "info", "warn" or "error"
+    static bool parse_level(const char* name, LogLevel& level) {
+        static const char* const names[] = {"debug", "info", "warn", "error"};
+        for (int i = 0; i < 4; ++i) {
+            if (std::strcmp(name, names[i]) == 0) {
+                level = static_cast<LogLevel>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Records per second per thread; 0 disables the limit
+    void set_rate_limit(uint32_t per_second) { rate_limit_.store(per_second, std::memory_order_relaxed); }
+
+    // Where formatted lines go (default: stderr)
+    void set_output(int fd) { output_fd_.store(fd, std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void write(LogLevel level, const char* module, const Args&... args) {
+        ThreadRing* ring = local_ring();
+        if (!ring) return;
+
+        int64_t now = Clock::realtime_ns();
+        if (!ring->admit(now, rate_limit_.load(std::memory_order_relaxed))) {
+            ring->rate_limited.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        LogRecord record;
+        record.time_ns = now;
+        record.level = static_cast<uint8_t>(level);
+        record.put(module);
+        (record.put(args), ...);
+
+        if (!ring->queue.push(record)) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (level >= LogLevel::ERROR) wake();
+    }
+
+    // Block until every record logged before this call has been written
+    void flush() {
+        std::unique_lock<std::mutex> lock(drain_mutex_);
+        if (!drain_thread_.joinable()) {
+            lock.unlock();
+            drain_once();
+            return;
+        }
+        uint64_t ticket = ++flush_requested_;
+        drain_cv_.notify_one();
+        flushed_cv_.wait(lock, [&] { return flushed_ >= ticket || !running_; });
+    }
+
+    // Stop the drain thread after writing everything queued
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(drain_mutex_);
+            if (!running_) return;
+            running_ = false;
+            drain_cv_.notify_one();
+        }
+        if (drain_thread_.joinable()) drain_thread_.join();
+        drain_once();
+    }
+
+    uint64_t dropped() const { return sum(&ThreadRing::dropped, retired_dropped_); }
+    uint64_t rate_limited() const { return sum(&ThreadRing::rate_limited, retired_rate_limited_); }
+
+private:
+    struct ThreadRing {
+        SpscQueue<LogRecord, kRingCapacity> queue;
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> rate_limited{0};
+        std::atomic<bool> retired{false};  // Owning thread has exited
+
+        // Token bucket, touched only by the owning thread
+        double tokens = 0;
+        int64_t refilled_ns = 0;
+
+        bool admit(int64_t now, uint32_t rate) {
+            if (rate == 0) return true;
+            if (refilled_ns == 0) {
+                tokens = rate;
+            } else {
+                tokens += static_cast<double>(now - refilled_ns) * rate / 1e9;
+                if (tokens > rate) tokens = rate;
+            }
+            refilled_ns = now;
+            if (tokens < 1) return false;
+            tokens -= 1;
+            return true;
+        }
+    };
+
+    // Marks the ring retired when its thread exits; the drain thread frees it
+    struct RingHolder {
+        std::shared_ptr<ThreadRing> ring;
+        ~RingHolder() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    Logger() : level_(static_cast<int>(LogLevel::INFO)), rate_limit_(0), output_fd_(STDERR_FILENO) {}
+
+    ThreadRing* local_ring() {
+        static thread_local RingHolder holder;
+        if (!holder.ring) {
+            holder.ring = std::make_shared<ThreadRing>();
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(holder.ring);
+            start_locked();
+        }
+        return holder.ring.get();
+    }
+
+    // Caller holds rings_mutex_
+    void start_locked() {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        if (started_) return;
+        started_ = true;
+        running_ = true;
+        drain_thread_ = std::thread(&Logger::drain_loop, this);
+    }
+
+    void wake() {
+        if (drain_mutex_.try_lock()) {
+            drain_cv_.notify_one();
+            drain_mutex_.unlock();
+        }
+    }
+
+    // Live rings plus the retired ones' share, read together so a ring
+    // being retired is counted exactly once
+    uint64_t sum(std::atomic<uint64_t> ThreadRing::*counter, const std::atomic<uint64_t>& retired) const {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        uint64_t total = retired.load();
+        for (auto& ring : rings_) total += ((*ring).*counter).load(std::memory_order_relaxed);
+        return total;
+    }
+
+    void drain_loop() {
+        std::unique_lock<std::mutex> lock(drain_mutex_);
+        while (running_) {
+            uint64_t ticket = flush_requested_;
+            lock.unlock();
+            size_t written = drain_once();
+            lock.lock();
+
+            if (ticket > flushed_) {
+                flushed_ = ticket;
+                flushed_cv_.notify_all();
+            }
+            if (written == 0 && flush_requested_ == flushed_ && running_) {
+                drain_cv_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+        flushed_ = flush_requested_;
+        flushed_cv_.notify_all();
+    }
+
+    // Format and write everything currently queued; returns records written.
+    // rings_mutex_ is held only to list the rings and to drop retired ones,
+    // never across a write, so a stalled sink does not hold up new threads
+    // or the loss counters.
+    size_t drain_once() {
+        std::lock_guard<std::mutex> output_lock(output_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            draining_.clear();
+            for (auto& ring : rings_) draining_.push_back(ring.get());
+        }
+        size_t written = 0;
+        bool any_retired = false;
+        LogRecord record;
+
+        // Rings leave rings_ only below, under output_mutex_, so these stay valid
+        for (ThreadRing*& ring : draining_) {
+            bool retired = ring->retired.load(std::memory_order_acquire);
+            while (ring->queue.pop(record)) {
+                format(record, out_);
+                written++;
+                if (out_.size() > 60 * 1024) write_out();
+            }
+            if (!retired) ring = nullptr;
+            any_retired |= retired;
+        }
+
+        if (any_retired) {
+            // Drained after their threads exited: fold their counters in and free them
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            for (ThreadRing* ring : draining_) {
+                if (!ring) continue;
+                retired_dropped_.fetch_add(ring->dropped.load());
+                retired_rate_limited_.fetch_add(ring->rate_limited.load());
+                auto it = std::find_if(rings_.begin(), rings_.end(), [ring](const std::shared_ptr<ThreadRing>& r) {
+                    return r.get() == ring;
+                });
+                *it = std::move(rings_.back());
+                rings_.pop_back();
+            }
+        }
+
+        report_losses();
+        write_out();
+        return written;
+    }
+
+    // Caller holds output_mutex_
+    void report_losses() {
+        uint64_t lost = dropped();
+        uint64_t limited = rate_limited();
+        if (lost == reported_dropped_ && limited == reported_limited_) return;
+
+        LogRecord note;
+        note.time_ns = Clock::realtime_ns();
+        note.level = static_cast<uint8_t>(LogLevel::WARN);
+        note.put("Logger");
+        note.put(lost - reported_dropped_);
+        note.put(" records dropped (ring full), ");
+        note.put(limited - reported_limited_);
+        note.put(" rate-limited");
+        format(note, out_);
+        reported_dropped_ = lost;
+        reported_limited_ = limited;
+    }
+
+    static void format(const LogRecord& record, std::string& out) {
+        static const char* const level_str[] = {"[DEBUG]", "[INFO]", "[WARN]", "[ERROR]"};
+
+        char stamp[Clock::kIsoLen + 1];
+        size_t n = Clock::format_iso8601(record.time_ns, stamp, sizeof(stamp), Clock::Precision::MILLIS);
+        stamp[n++] = ' ';
+        out.append(stamp, n);
+        out.append(level_str[record.level & 3]);
+
+        // The module is always the first (string) argument
+        uint16_t module_len = 0;
+        std::memcpy(&module_len, record.data + 1, sizeof(module_len));
+        out.append(" [");
+        out.append(record.data + 3, module_len);
+        out.append("] ");
+        record.format_args(out, 3 + module_len);
+        if (record.truncated) out.append("...");
+        out.push_back('\n');
+    }
+
+    void write_out() {
+        const char* p = out_.data();
+        size_t left = out_.size();
+        int fd = output_fd_.load(std::memory_order_relaxed);
+        while (left > 0) {
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            p += n;
+            left -= static_cast<size_t>(n);
+        }
+        out_.clear();
+    }
+
+    std::atomic<int> level_;
+    std::atomic<uint32_t> rate_limit_;
+    std::atomic<int> output_fd_;
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    std::atomic<uint64_t> retired_dropped_{0};
+    std::atomic<uint64_t> retired_rate_limited_{0};
+
+    // Drain thread state
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+    std::condition_variable flushed_cv_;
+    std::thread drain_thread_;
+    bool started_ = false;
+    bool running_ = false;
+    uint64_t flush_requested_ = 0;
+    uint64_t flushed_ = 0;
+
+    // Output side (drain thread, or flush()/shutdown() when it is not running)
+    std::mutex output_mutex_;
+    std::string out_;
+    std::vector<ThreadRing*> draining_;  // This pass's rings; retired ones left non-null
+    uint64_t reported_dropped_ = 0;
+    uint64_t reported_limited_ = 0;
+};
+
+}  // namespace ChatUtils
+
+#endif  // LOGGER_H
@@ -8,97 +8,282 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
 #include <string>
+#include "clock.h"
 
 // ===== Configuration Constants =====
 #define DEFAULT_PORT 5000
 #define DEFAULT_SHM_NAME "/os_chat_shm"
 #define SHM_MUTEX_NAME "/os_chat_mutex"
 #define SHM_COUNT_NAME "/os_chat_count"
-#define SHM_BUFFER_SIZE (1024 * 1024)  // 1 MB
+#define SHM_BUFFER_SIZE (16 * 1024 * 1024)  // Upper bound a room may grow to
 
 // ===== Message Limits =====
 #define MAX_USERNAME_LEN 32
+#define MAX_ROOMNAME_LEN 32
 #define MAX_TIMESTAMP_LEN 32
 #define MAX_MESSAGE_LEN 512
-#define MAX_SLOTS 64  // Ring buffer slots
+#define MAX_FRAME_LEN 2048  // Largest JSON payload accepted on a socket
+#define MAX_SLOTS 64  // Initial ring buffer slots (rooms grow on demand)
+#define DEFAULT_ROOM "lobby"
 
 // ===== Socket Protocol =====
 // Messages are length-prefixed JSON lines
 // Format: [4-byte big-endian length] [JSON payload]
-// JSON: {"user":"name","time":"2025-12-08T01:47:00Z","text":"message"}
+// JSON: {"user":"name","time":"2025-12-08T01:47:00Z","room":"lobby","seq":42,"text":"message"}
+// "room", "to" and "seq" are optional. With "to" the message is a direct
+// message: the server routes it to that user alone, unsequenced, instead
+// of publishing it to the room. "seq" is stamped by the server's per-room
+// sequencer and increases by one per message, so a gap means a lost frame.
+// With "filter":1 the text is the sender's subscription filter for its
+// room instead of chat: comma-separated keywords, "^word" for a prefix of
+// the text, case-insensitive; from then on the server only sends it room
+// messages matching one of them. An empty list subscribes to everything.
+// A hello may carry a filter too.
+// A hello with "conflate":1 asks for the latest state rather than every
+// message: when the connection falls behind, the server replaces the room
+// messages queued for it with one "[System]" summary ("N messages
+// skipped, last seq X") whose seq is X, so the sequence has no gap.
+// "ping":1 and "pong":1 mark keep-alives: the server pings a connection
+// that has been quiet for a while, the client answers with a pong, and a
+// connection silent past the idle timeout is closed. Neither is chat.
+// In a client's first (hello) frame, "seq" is the last one it saw before a
+// reconnect; the server replays what it still holds after it.
+// "text" is always the last key.
+// A hello with "deflate":1 offers compression. The server may then send
+// a compressed batch: a frame whose length prefix has FRAME_COMPRESSED
+// set, the rest of the prefix being the length of a raw-deflate block.
+// Blocks continue one deflate stream per connection and each ends with a
+// sync flush; a block inflates to one or more ordinary frames, at most
+// MAX_BATCH_LEN bytes of them.
+// A hello with "intern":1 asks for names by id. The server then sends
+// "uid":N with or instead of "user", and "rid":N with or instead of
+// "room": a frame carrying both binds the id to the name for the rest of
+// the connection, and later frames may carry the id alone. Once its own
+// name is bound, the client may send its "uid" in place of "user" too.
+// Ids are shared by users and rooms and never exceed MAX_INTERNED_NAMES.
 
 #define MESSAGE_SEPARATOR '\n'
+#define FRAME_COMPRESSED 0x80000000u  // Length-prefix flag of a compressed batch
+#define MAX_BATCH_LEN 16384           // Inflated size of a compressed batch, at most
+#define MAX_COMPRESSED_LEN (MAX_BATCH_LEN + MAX_BATCH_LEN / 16 + 64)
+#define MAX_INTERNED_NAMES 65535  // Largest "uid" / "rid"
+#define HEARTBEAT_PING 1  // Message::heartbeat values
+#define HEARTBEAT_PONG 2
+
+// How Message::encode() writes the sender and room (see "intern" above)
+enum class NameForm {
+    NAMES,  // Names only, as every client understands
+    BIND,   // Names and their ids
+    IDS     // Ids in place of the names that have one
+};
 
 struct Message {
     char user[MAX_USERNAME_LEN];
     char timestamp[MAX_TIMESTAMP_LEN];
     char text[MAX_MESSAGE_LEN];
+    char room[MAX_ROOMNAME_LEN];
+    char to[MAX_USERNAME_LEN];  // Recipient of a direct message; empty for the room
+    uint64_t seq;  // 0 until sequenced by the server
+    bool filter;   // The text is a subscription filter, not a chat message
+    bool conflate;  // Hello only: summarise a backlog instead of sending all of it
+    bool deflate;   // Hello only: compressed batches are welcome
+    bool intern;    // Hello only: names may be sent as ids
+    uint32_t uid;   // Interned id of `user`, 0 if none
+    uint32_t rid;   // Interned id of `room`, 0 if none
+    uint8_t heartbeat;  // HEARTBEAT_PING / HEARTBEAT_PONG keep-alive, or 0
+    uint64_t ingress_ns;  // Clock::monotonic_ns() once the server read and decoded it (local, not on the wire)
+    uint64_t trace_id;    // Non-zero when sampled for tracing (local, not on the wire)
 
-    Message() {
+    Message()
+        : seq(0), filter(false), conflate(false), deflate(false), intern(false), uid(0), rid(0), heartbeat(0),
+          ingress_ns(0), trace_id(0) {
         std::memset(user, 0, MAX_USERNAME_LEN);
         std::memset(timestamp, 0, MAX_TIMESTAMP_LEN);
         std::memset(text, 0, MAX_MESSAGE_LEN);
+        std::memset(room, 0, MAX_ROOMNAME_LEN);
+        std::memset(to, 0, MAX_USERNAME_LEN);
     }
 
     // Convert to JSON string
     std::string to_json() const {
-        std::string json = "{\"user\":\"";
-        json += user;
-        json += "\",\"time\":\"";
-        json += timestamp;
-        json += "\",\"text\":\"";
-        
-        // Escape quotes in text
-        for (const char* p = text; *p; ++p) {
-            if (*p == '"') json += "\\\"";
-            else if (*p == '\\') json += "\\\\";
-            else json += *p;
-        }
-        
-        json += "\"}";
-        return json;
+        char buffer[MAX_FRAME_LEN];
+        return std::string(buffer, encode(buffer, sizeof(buffer)));
     }
 
     // Parse from JSON string
     static Message from_json(const std::string& json) {
         Message msg;
-        // Simple JSON parser (production code would use nlohmann/json)
-        size_t user_start = json.find("\"user\":\"") + 8;
-        size_t user_end = json.find('"', user_start);
-        if (user_end != std::string::npos) {
-            std::string username = json.substr(user_start, user_end - user_start);
-            strncpy(msg.user, username.c_str(), MAX_USERNAME_LEN - 1);
+        parse(json.data(), json.size(), msg);
+        return msg;
+    }
+
+    /**
+     * Serialise into a caller-provided buffer without allocating.
+     * Returns the number of bytes written (no terminator), 0 if it did not fit.
+     */
+    size_t encode(char* out, size_t cap, NameForm names = NameForm::NAMES) const {
+        size_t n = 0;
+        auto put = [&](const char* s, size_t len) {
+            if (n + len > cap) {
+                n = cap + 1;  // Sticky overflow
+                return;
+            }
+            std::memcpy(out + n, s, len);
+            n += len;
+        };
+        auto put_str = [&](const char* s) { put(s, std::strlen(s)); };
+        auto put_num = [&](const char* key, uint64_t value) {
+            put_str(key);
+            char digits[20];
+            size_t len = 0;
+            do {
+                digits[sizeof(digits) - ++len] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value);
+            put(digits + sizeof(digits) - len, len);
+        };
+
+        if (names == NameForm::IDS && uid) {
+            put_num("{\"uid\":", uid);
+            put_str(",");
+        } else {
+            put_str("{\"user\":\"");
+            put(user, strnlen(user, MAX_USERNAME_LEN));
+            put_str("\",");
+            if (names != NameForm::NAMES && uid) {
+                put_num("\"uid\":", uid);
+                put_str(",");
+            }
         }
-        
-        size_t time_start = json.find("\"time\":\"") + 8;
-        size_t time_end = json.find('"', time_start);
-        if (time_end != std::string::npos) {
-            std::string ts = json.substr(time_start, time_end - time_start);
-            strncpy(msg.timestamp, ts.c_str(), MAX_TIMESTAMP_LEN - 1);
+        put_str("\"time\":\"");
+        put(timestamp, strnlen(timestamp, MAX_TIMESTAMP_LEN));
+        put_str("\"");
+        if (names == NameForm::IDS && rid) {
+            put_num(",\"rid\":", rid);
+        } else if (room[0]) {
+            put_str(",\"room\":\"");
+            put(room, strnlen(room, MAX_ROOMNAME_LEN));
+            put_str("\"");
+            if (names != NameForm::NAMES && rid) put_num(",\"rid\":", rid);
         }
-        
-        size_t text_start = json.find("\"text\":\"") + 8;
-        size_t text_end = json.rfind('"');
-        if (text_end != std::string::npos && text_end > text_start) {
-            std::string text = json.substr(text_start, text_end - text_start);
-            strncpy(msg.text, text.c_str(), MAX_MESSAGE_LEN - 1);
+        if (to[0]) {
+            put_str(",\"to\":\"");
+            put(to, strnlen(to, MAX_USERNAME_LEN));
+            put_str("\"");
         }
-        
-        return msg;
+        if (seq) put_num(",\"seq\":", seq);
+        if (filter) put_str(",\"filter\":1");
+        if (conflate) put_str(",\"conflate\":1");
+        if (deflate) put_str(",\"deflate\":1");
+        if (intern) put_str(",\"intern\":1");
+        if (heartbeat == HEARTBEAT_PING) put_str(",\"ping\":1");
+        if (heartbeat == HEARTBEAT_PONG) put_str(",\"pong\":1");
+        put_str(",\"text\":\"");
+
+        // Escape quotes in text
+        for (const char* p = text; p < text + MAX_MESSAGE_LEN && *p; ++p) {
+            if (*p == '"') put("\\\"", 2);
+            else if (*p == '\\') put("\\\\", 2);
+            else put(p, 1);
+        }
+
+        put_str("\"}");
+        return n > cap ? 0 : n;
+    }
+
+    /**
+     * Parse a JSON payload in place without allocating.
+     * Optional keys ("uid", "room", "rid", "to", "seq", "filter", "conflate",
+     * "deflate", "intern", "ping", "pong") must come before "text", which
+     * is last. Returns false without a "user" or a "uid".
+     */
+    static bool parse(const char* json, size_t len, Message& msg) {
+        msg = Message();
+        const char* end = json + len;
+        const char* text_key = find_key(json, end, "\"text\":\"");
+        const char* limit = text_key ? text_key : end;
+
+        auto copy_string = [&](const char* key, char* dst, size_t cap) {
+            const char* start = find_key(json, limit, key);
+            if (!start) return false;
+            start += std::strlen(key);
+            const char* stop = static_cast<const char*>(std::memchr(start, '"', end - start));
+            if (!stop) return false;
+            size_t n = std::min(static_cast<size_t>(stop - start), cap - 1);
+            std::memcpy(dst, start, n);
+            dst[n] = '\0';
+            return true;
+        };
+
+        bool has_user = copy_string("\"user\":\"", msg.user, MAX_USERNAME_LEN);
+        copy_string("\"time\":\"", msg.timestamp, MAX_TIMESTAMP_LEN);
+        copy_string("\"room\":\"", msg.room, MAX_ROOMNAME_LEN);
+        copy_string("\"to\":\"", msg.to, MAX_USERNAME_LEN);
+
+        auto number = [&](const char* key) {
+            uint64_t value = 0;
+            if (const char* start = find_key(json, limit, key)) {
+                for (const char* p = start + std::strlen(key); p < limit && *p >= '0' && *p <= '9'; ++p) {
+                    value = value * 10 + static_cast<uint64_t>(*p - '0');
+                }
+            }
+            return value;
+        };
+        msg.seq = number("\"seq\":");
+        uint64_t uid = number("\"uid\":");
+        uint64_t rid = number("\"rid\":");
+        msg.uid = uid <= MAX_INTERNED_NAMES ? static_cast<uint32_t>(uid) : 0;
+        msg.rid = rid <= MAX_INTERNED_NAMES ? static_cast<uint32_t>(rid) : 0;
+        msg.filter = find_key(json, limit, "\"filter\":1") != nullptr;
+        msg.conflate = find_key(json, limit, "\"conflate\":1") != nullptr;
+        msg.deflate = find_key(json, limit, "\"deflate\":1") != nullptr;
+        msg.intern = find_key(json, limit, "\"intern\":1") != nullptr;
+        if (find_key(json, limit, "\"ping\":1")) msg.heartbeat = HEARTBEAT_PING;
+        if (find_key(json, limit, "\"pong\":1")) msg.heartbeat = HEARTBEAT_PONG;
+
+        if (text_key) {
+            // Text runs to the last quote; undo the escaping done by encode()
+            const char* p = text_key + 8;
+            const char* stop = end;
+            while (stop > p && *(stop - 1) != '"') --stop;
+            if (stop > p) --stop;
+            size_t n = 0;
+            for (; p < stop && n < MAX_MESSAGE_LEN - 1; ++p) {
+                if (*p == '\\' && p + 1 < stop) ++p;
+                msg.text[n++] = *p;
+            }
+            msg.text[n] = '\0';
+        }
+
+        return has_user || msg.uid;
     }
 
     // Get current timestamp in ISO 8601 format
     static std::string get_current_timestamp() {
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        std::ostringstream oss;
-        oss << std::put_time(std::gmtime(&time), "%Y-%m-%dT%H:%M:%SZ");
-        return oss.str();
+        char buffer[MAX_TIMESTAMP_LEN];
+        format_timestamp(buffer, sizeof(buffer));
+        return buffer;
+    }
+
+    // Same, written into a caller buffer (no allocation; cached per second)
+    static void format_timestamp(char* out, size_t cap,
+                                 ChatUtils::Clock::Precision precision = ChatUtils::Clock::Precision::SECONDS) {
+        ChatUtils::Clock::format_now(out, cap, precision);
+    }
+
+private:
+    static const char* find_key(const char* begin, const char* end, const char* key) {
+        if (end <= begin) return nullptr;
+        return static_cast<const char*>(memmem(begin, end - begin, key, std::strlen(key)));
     }
 };
 
@@ -107,21 +292,37 @@ struct Message {
  * Shared memory segment structure:
  * [
  *   ShmHeader (metadata)
- *   Message[MAX_SLOTS] (ring buffer)
+ *   Message[capacity] (ring buffer, MAX_SLOTS initially)
  * ]
+ *
+ * The segment grows online: a writer extends the object, re-lays the live
+ * slots out for the new capacity and bumps `generation`. Every process
+ * compares `generation` with the one it mapped and remaps when it changed.
  */
 
 struct ShmHeader {
-    volatile int read_index;   // Consumer pointer (protected by mutex)
-    volatile int write_index;  // Producer pointer (protected by mutex)
-    volatile int count;        // Number of unread messages
-    int capacity;              // Total slots
-    int msg_size;              // Size of each message
+    volatile uint64_t read_index;   // Oldest message still held (protected by mutex)
+    volatile uint64_t write_index;  // Producer pointer (protected by mutex); never wraps
+    volatile uint32_t wake;         // Low 32 bits of write_index: the word readers futex-wait on
+    volatile int count;             // Number of messages held in the ring
+    int capacity;                   // Total slots in the current generation
+    int msg_size;                   // Size of each message
+    volatile int generation;        // Bumped every time the segment is grown
+    volatile int grow_requested;    // Set by a reader that was overrun
+    volatile int waiters;           // Readers sleeping on wake
 };
 
 struct ShmLayout {
     ShmHeader header;
-    Message messages[MAX_SLOTS];
+    Message messages[MAX_SLOTS];  // Extends past MAX_SLOTS once the room has grown
 };
 
+// Bytes needed for a segment holding `capacity` slots
+inline size_t shm_segment_size(int capacity) {
+    return offsetof(ShmLayout, messages) + static_cast<size_t>(capacity) * sizeof(Message);
+}
+
+// Largest capacity that still fits in SHM_BUFFER_SIZE
+#define SHM_MAX_SLOTS static_cast<int>((SHM_BUFFER_SIZE - offsetof(ShmLayout, messages)) / sizeof(Message))
+
 #endif  // PROTOCOL_H
@@ -0,0 +1,311 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Growable shared-memory ring for the local chat room (System B)
+ */
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include "protocol.h"
+
+/**
+ * One process's view of a shared-memory room.
+ *
+ * Writers serialise on a named semaphore and append at `write_index`.
+ * Every reader keeps its own cursor, so each message reaches every reader;
+ * a reader that falls a whole ring behind skips ahead, counts the overrun
+ * and asks the next writer to double the ring.
+ *
+ * Growing extends the backing object and bumps `generation` in the header.
+ * Other processes notice the new generation the next time they take the
+ * mutex and remap; cursors are absolute indices, so nothing is lost.
+ */
+class ShmRing {
+public:
+    ShmRing() = default;
+    ~ShmRing() { close(); }
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Open (or create) the room; the cursor starts at the live edge
+    bool open(const std::string& shm_name, const std::string& mutex_name = SHM_MUTEX_NAME,
+              int initial_capacity = MAX_SLOTS) {
+        close();
+
+        fd_ = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0666);
+        if (fd_ < 0) return false;
+
+        mutex_ = sem_open(mutex_name.c_str(), O_CREAT, 0666, 1);
+        if (mutex_ == SEM_FAILED) {
+            mutex_ = nullptr;
+            close();
+            return false;
+        }
+
+        if (!lock()) {
+            close();
+            return false;
+        }
+
+        struct stat st;
+        bool ok = fstat(fd_, &st) == 0;
+        size_t size = ok ? static_cast<size_t>(st.st_size) : 0;
+        bool fresh = size < sizeof(ShmHeader);
+        if (ok && fresh) {
+            size = shm_segment_size(initial_capacity);
+            ok = ftruncate(fd_, size) == 0;
+        }
+        if (ok) ok = map(size);
+
+        if (ok && (fresh || layout_->header.capacity == 0)) {
+            ShmHeader& h = layout_->header;
+            h.read_index = 0;
+            h.write_index = 0;
+            h.wake = 0;
+            h.count = 0;
+            h.capacity = initial_capacity;
+            h.msg_size = sizeof(Message);
+            h.generation = 0;
+            h.grow_requested = 0;
+            h.waiters = 0;
+        }
+        if (ok) {
+            generation_ = layout_->header.generation;
+            cursor_ = layout_->header.write_index;
+        }
+        unlock();
+
+        if (!ok) close();
+        return ok;
+    }
+
+    void close() {
+        if (layout_) {
+            munmap(layout_, mapped_size_);
+            layout_ = nullptr;
+            mapped_size_ = 0;
+        }
+        if (mutex_) {
+            sem_close(mutex_);
+            mutex_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // Remove the named objects (the last process to close frees the memory)
+    static void unlink(const std::string& shm_name, const std::string& mutex_name = SHM_MUTEX_NAME) {
+        shm_unlink(shm_name.c_str());
+        sem_unlink(mutex_name.c_str());
+    }
+
+    bool is_open() const { return layout_ != nullptr; }
+
+    // Append a message for every reader
+    bool write(const Message& msg) {
+        if (!layout_ || !lock()) return false;
+        if (!remap_locked()) {
+            unlock();
+            return false;
+        }
+
+        if (layout_->header.grow_requested) {
+            layout_->header.grow_requested = 0;
+            grow_locked(layout_->header.capacity * 2);
+        }
+
+        ShmHeader& h = layout_->header;
+        uint64_t index = h.write_index;
+        *slot(index) = msg;
+        if (h.count < h.capacity) h.count = h.count + 1;
+        __atomic_store_n(&h.write_index, index + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&h.wake, static_cast<uint32_t>(index + 1), __ATOMIC_RELEASE);
+        h.read_index = index + 1 - static_cast<uint64_t>(h.count);
+        bool wake = __atomic_load_n(&h.waiters, __ATOMIC_ACQUIRE) > 0;
+        unlock();
+
+        if (wake) {
+            syscall(SYS_futex, &h.wake, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+        }
+        return true;
+    }
+
+    // Next message after our cursor, waiting up to timeout_ms for one
+    bool read(Message& msg, int timeout_ms) {
+        if (!layout_) return false;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        add_ms(deadline, timeout_ms);
+
+        for (;;) {
+            if (!lock()) return false;
+            if (!remap_locked()) {
+                unlock();
+                return false;
+            }
+
+            ShmHeader& h = layout_->header;
+            if (take_locked(msg)) {
+                unlock();
+                return true;
+            }
+            uint32_t observed = h.wake;
+            unlock();
+
+            struct timespec now, remaining;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += 1000000000L;
+            }
+            if (remaining.tv_sec < 0) return false;
+
+            __atomic_fetch_add(&h.waiters, 1, __ATOMIC_ACQ_REL);
+            syscall(SYS_futex, &h.wake, FUTEX_WAIT, observed, &remaining, nullptr, 0);
+            __atomic_fetch_sub(&h.waiters, 1, __ATOMIC_ACQ_REL);
+        }
+    }
+
+    // Next message after our cursor if one is already there (never waits)
+    bool try_read(Message& msg) {
+        if (!layout_) return false;
+        // Unlocked peek: nothing new means nothing to lock for
+        if (cursor_ == __atomic_load_n(&layout_->header.write_index, __ATOMIC_ACQUIRE)) return false;
+        if (!lock()) return false;
+        bool ok = remap_locked() && take_locked(msg);
+        unlock();
+        return ok;
+    }
+
+    // Grow the room to at least new_capacity slots (capped at SHM_MAX_SLOTS)
+    bool grow(int new_capacity) {
+        if (!layout_ || !lock()) return false;
+        bool ok = remap_locked() && grow_locked(new_capacity);
+        unlock();
+        return ok;
+    }
+
+    int capacity() const { return layout_ ? layout_->header.capacity : 0; }
+    int generation() const { return generation_; }
+    uint64_t cursor() const { return cursor_; }
+    unsigned long overruns() const { return overruns_; }
+
+private:
+    static void add_ms(struct timespec& ts, int ms) {
+        ts.tv_sec += ms / 1000;
+        ts.tv_nsec += static_cast<long>(ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+    }
+
+    bool lock() {
+        // Timed so a crashed peer holding the mutex cannot wedge us forever
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+        while (sem_timedwait(mutex_, &ts) != 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+    }
+
+    void unlock() { sem_post(mutex_); }
+
+    bool map(size_t size) {
+        void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (ptr == MAP_FAILED) return false;
+        if (layout_) munmap(layout_, mapped_size_);
+        layout_ = static_cast<ShmLayout*>(ptr);
+        mapped_size_ = size;
+        return true;
+    }
+
+    // Copy out the message at our cursor, skipping anything overwritten (mutex held)
+    bool take_locked(Message& msg) {
+        ShmHeader& h = layout_->header;
+        uint64_t oldest = h.write_index - static_cast<uint64_t>(h.count);
+        if (cursor_ < oldest) {
+            // Writers lapped us: skip what was overwritten and ask for a bigger ring
+            overruns_ += static_cast<unsigned long>(oldest - cursor_);
+            cursor_ = oldest;
+            h.grow_requested = 1;
+        }
+        if (cursor_ >= h.write_index) return false;
+        msg = *slot(cursor_++);
+        return true;
+    }
+
+    // Follow a grow done by another process (mutex held)
+    bool remap_locked() {
+        int current = __atomic_load_n(&layout_->header.generation, __ATOMIC_ACQUIRE);
+        if (current == generation_) return true;
+
+        struct stat st;
+        if (fstat(fd_, &st) != 0 || !map(static_cast<size_t>(st.st_size))) return false;
+        generation_ = current;
+        return true;
+    }
+
+    // Extend the object and re-lay the live slots for the new capacity (mutex held)
+    bool grow_locked(int new_capacity) {
+        if (new_capacity > SHM_MAX_SLOTS) new_capacity = SHM_MAX_SLOTS;
+        int old_capacity = layout_->header.capacity;
+        if (new_capacity <= old_capacity) return false;
+
+        uint64_t first = layout_->header.write_index - static_cast<uint64_t>(layout_->header.count);
+        std::vector<Message> live(static_cast<size_t>(layout_->header.count));
+        for (size_t i = 0; i < live.size(); ++i) {
+            live[i] = *slot(first + i);
+        }
+
+        if (ftruncate(fd_, shm_segment_size(new_capacity)) != 0 ||
+            !map(shm_segment_size(new_capacity))) {
+            return false;
+        }
+
+        ShmHeader& h = layout_->header;
+        h.capacity = new_capacity;
+        for (size_t i = 0; i < live.size(); ++i) {
+            *slot(first + i) = live[i];
+        }
+        generation_ = h.generation + 1;
+        __atomic_store_n(&h.generation, generation_, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    Message* slot(uint64_t index) {
+        return &layout_->messages[0] + index % static_cast<uint64_t>(layout_->header.capacity);
+    }
+
+    int fd_ = -1;
+    sem_t* mutex_ = nullptr;
+    ShmLayout* layout_ = nullptr;
+    size_t mapped_size_ = 0;
+    int generation_ = 0;
+    uint64_t cursor_ = 0;  // Absolute index of the next message to read
+    unsigned long overruns_ = 0;
+};
+
+#endif  // SHM_RING_H
@@ -0,0 +1,68 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Bounded lock-free single-producer / single-consumer ring
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Fixed-capacity ring for exactly one producer thread and one consumer
+ * thread at a time. Capacity must be a power of two. Slots are constructed
+ * once and reused, so push/pop never allocate.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head_(0), tail_(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side; false when full
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) return false;
+        slots_[tail & (Capacity - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when empty
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return false;
+        item = slots_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    // Safe from any thread. Head is read first: it never passes the tail
+    // read after it, though both may move between the loads
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t used = tail_.load(std::memory_order_acquire) - head;
+        return used < Capacity ? used : Capacity;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    T slots_[Capacity];
+};
+
+#endif  // SPSC_QUEUE_H
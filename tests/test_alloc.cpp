@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Hot-Path Allocation Tests
+ *
+ * Interposes malloc/free for the whole process and counts calls made while
+ * a steady stream of messages goes through the real server path: handler
+ * read -> parse -> task pool strand -> pipeline -> sequencer -> fan-out.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../server/client_handler.h"
+#include "../server/memory_pool.h"
+#include "../server/sequencer.h"
+#include "../server/server_context.h"
+#include "../shared/common.h"
+
+// ===== malloc hook =====
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t align, size_t size);
+void __libc_free(void* ptr);
+}
+
+static std::atomic<bool> g_counting(false);
+static std::atomic<uint64_t> g_mallocs(0);
+static std::atomic<uint64_t> g_frees(0);
+
+static inline void count_malloc() {
+    if (g_counting.load(std::memory_order_relaxed)) g_mallocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" {
+void* malloc(size_t size) {
+    count_malloc();
+    return __libc_malloc(size);
+}
+void* calloc(size_t n, size_t size) {
+    count_malloc();
+    return __libc_calloc(n, size);
+}
+void* realloc(void* ptr, size_t size) {
+    count_malloc();
+    return __libc_realloc(ptr, size);
+}
+void* memalign(size_t align, size_t size) {
+    count_malloc();
+    return __libc_memalign(align, size);
+}
+void* aligned_alloc(size_t align, size_t size) {
+    count_malloc();
+    return __libc_memalign(align, size);
+}
+int posix_memalign(void** out, size_t align, size_t size) {
+    count_malloc();
+    *out = __libc_memalign(align, size);
+    return *out ? 0 : ENOMEM;
+}
+void free(void* ptr) {
+    if (ptr && g_counting.load(std::memory_order_relaxed)) g_frees.fetch_add(1, std::memory_order_relaxed);
+    __libc_free(ptr);
+}
+}
+
+// ===== Test harness =====
+
+struct TestClient {
+    int fd = -1;                 // Our end of the socketpair
+    std::atomic<uint64_t> received{0};
+    std::thread reader;
+};
+
+static void read_frames(TestClient* client) {
+    char buffer[MAX_FRAME_LEN];
+    size_t len = 0;
+    while (ChatUtils::recv_frame(client->fd, buffer, len)) {
+        client->received.fetch_add(1, std::memory_order_release);
+    }
+}
+
+static void send_text(int fd, const char* user, int n) {
+    Message msg;
+    strncpy(msg.user, user, MAX_USERNAME_LEN - 1);
+    std::snprintf(msg.text, MAX_MESSAGE_LEN, "message number %d with some text", n);
+    char frame[MAX_FRAME_LEN + 4];
+    size_t len = ChatUtils::encode_frame(msg, frame, sizeof(frame));
+    assert(len > 0);
+    bool sent = ChatUtils::send_frame(fd, frame, len);
+    assert(sent);
+}
+
+static void wait_for(const std::vector<std::unique_ptr<TestClient>>& clients, uint64_t each) {
+    for (int i = 0; i < 1000; ++i) {
+        bool done = true;
+        for (auto& c : clients) {
+            if (c->received.load(std::memory_order_acquire) < each) done = false;
+        }
+        if (done) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(false && "messages were not delivered");
+}
+
+// Send in fixed windows so warm-up and measurement have the same in-flight depth
+static void send_windows(const std::vector<std::unique_ptr<TestClient>>& clients,
+                         int first, int count, int window) {
+    for (int n = first; n < first + count; n += window) {
+        int end = std::min(n + window, first + count);
+        for (int k = n; k < end; ++k) {
+            send_text(clients[k % clients.size()]->fd, "ignored", k);
+        }
+        wait_for(clients, end);
+    }
+}
+
+void test_zero_allocations_per_message() {
+    std::cout << "\n=== Test: Zero Allocations Per Message ===" << std::endl;
+
+    const int client_count = 3;
+    const int warmup = 300;
+    const int measured = 2000;
+    const int window = 50;
+
+    // Same prewarm as the server's startup
+    Sequencer::reserve_nodes(1024);
+    FrameBuffer::reserve(MAX_FRAME_LEN + 4, 1024);
+
+    ServerContext context;
+    context.pool = std::make_unique<TaskPool>(2);
+    context.pool->start();
+
+    // An "indexing" hook that needs scratch memory takes it from the arena
+    std::atomic<uint64_t> indexed(0);
+    context.pipeline.add_stage("index", [&indexed](Message& msg, const ClientHandler&) {
+        size_t len = strnlen(msg.text, MAX_MESSAGE_LEN);
+        char* lowered = static_cast<char*>(Arena::local().allocate(len + 1, 1));
+        for (size_t i = 0; i <= len; ++i) {
+            lowered[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(msg.text[i])));
+        }
+        if (strstr(lowered, "message")) indexed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    });
+
+    std::vector<std::unique_ptr<TestClient>> clients;
+    std::vector<std::shared_ptr<ClientHandler>> handlers;
+    for (int i = 0; i < client_count; ++i) {
+        int sv[2];
+        int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        assert(paired == 0);
+        auto client = std::make_unique<TestClient>();
+        client->fd = sv[1];
+
+        auto handler = std::make_shared<ClientHandler>(sv[0], i, context);
+        handler->start();
+        handlers.push_back(handler);
+
+        Message join;
+        std::snprintf(join.user, MAX_USERNAME_LEN, "user%d", i);
+        strncpy(join.room, "alloc", MAX_ROOMNAME_LEN - 1);
+        strncpy(join.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+        join.intern = i == 0;  // One connection takes names as ids
+        bool sent = ChatUtils::send_message(client->fd, join);
+        assert(sent);
+
+        client->reader = std::thread(read_frames, client.get());
+        clients.push_back(std::move(client));
+    }
+
+    auto room = context.rooms.get_or_create("alloc");
+    for (int i = 0; i < 200 && room->member_count() < static_cast<size_t>(client_count); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert(room->member_count() == static_cast<size_t>(client_count));
+
+    // Warm up pools, arenas and thread caches; pools only grow to the peak
+    // number of messages in flight, so the measured phase keeps the same depth
+    send_windows(clients, 0, warmup, window);
+
+    g_counting = true;
+    send_windows(clients, warmup, measured, window);
+    g_counting = false;
+
+    uint64_t mallocs = g_mallocs.load();
+    uint64_t frees = g_frees.load();
+    std::cout << "Messages: " << measured << ", frames delivered: " << measured * client_count
+              << ", malloc calls: " << mallocs << ", free calls: " << frees
+              << " (" << static_cast<double>(mallocs + frees) / measured << " per message)" << std::endl;
+    assert(indexed.load() >= static_cast<uint64_t>(warmup + measured));
+    assert(mallocs == 0);
+    assert(frees == 0);
+
+    // Teardown: closing our ends lets the handlers' reads fail
+    for (auto& c : clients) {
+        shutdown(c->fd, SHUT_RDWR);
+    }
+    while (room->member_count() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handlers.clear();
+    for (auto& c : clients) {
+        c->reader.join();
+        close(c->fd);
+    }
+    context.pool->stop();
+
+    std::cout << "✓ Zero-allocation test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== Hot-Path Allocation Tests ==========\n" << std::endl;
+
+    try {
+        test_zero_allocations_per_message();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,663 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Headless Client Library Tests
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include "../libchatclient/event_loop.h"
+#include "../libchatclient/shm_session.h"
+#include "../libchatclient/socket_session.h"
+#include "../server/capture_writer.h"
+#include "../server/client_handler.h"
+#include "../server/metrics.h"
+#include "../server/server_context.h"
+#include "../shared/capture.h"
+#include "../shared/common.h"
+
+using namespace ChatClient;
+
+// In-process server: one ClientHandler per accepted connection
+class TestServer {
+public:
+    TestServer() {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        assert(listen_fd_ >= 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool listening = bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                         listen(listen_fd_, SOMAXCONN) == 0;
+        assert(listening);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread(&TestServer::accept_loop, this);
+    }
+
+    ~TestServer() {
+        stop_ = true;
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    int port() const { return port_; }
+    ServerContext& context() { return context_; }
+
+    // Wait until the room has `members` (the hello frame was processed)
+    void wait_members(const std::string& room, size_t members) {
+        auto r = context_.rooms.get_or_create(room);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (r->member_count() != members) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Cut `user`'s connection from the server side, as a network drop would
+    void drop(const std::string& user) {
+        std::lock_guard<std::mutex> lock(handlers_mutex_);
+        for (auto& handler : handlers_) {
+            if (handler->is_connected() && handler->get_username() == user) shutdown(handler->get_socket(), SHUT_RDWR);
+        }
+    }
+
+private:
+    void accept_loop() {
+        int next_id = 1;
+        while (!stop_) {
+            pollfd pfd{listen_fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) continue;
+            auto handler = std::make_shared<ClientHandler>(fd, next_id++, context_);
+            handler->start();
+            std::lock_guard<std::mutex> lock(handlers_mutex_);
+            handlers_.push_back(handler);
+        }
+    }
+
+    ServerContext context_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+    std::mutex handlers_mutex_;
+    std::vector<std::shared_ptr<ClientHandler>> handlers_;
+};
+
+// Run the loop until `done` or the deadline
+template <typename Pred>
+static bool run_until(EventLoop& loop, Pred done, int timeout_ms = 10000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        loop.run_once(10);
+    }
+    return true;
+}
+
+void test_many_sessions_one_loop(TestServer& server) {
+    std::cout << "\n=== Test: Many Socket Sessions On One Loop ===" << std::endl;
+
+    const int sessions = 200;
+    const int senders = 10;
+    EventLoop loop;
+    int connected = 0;
+    long received = 0;
+    std::vector<std::unique_ptr<SocketSession>> bots;
+    for (int i = 0; i < sessions; ++i) {
+        Callbacks callbacks;
+        callbacks.on_connected = [&connected]() { connected++; };
+        callbacks.on_message = [&received](const Message& msg) {
+            if (std::strncmp(msg.text, "bot says", 8) == 0) received++;
+        };
+        bots.emplace_back(new SocketSession(loop, callbacks));
+        bool started = bots.back()->connect("127.0.0.1", server.port(), "bot" + std::to_string(i), "bots");
+        assert(started);
+    }
+    assert(loop.watched() == static_cast<size_t>(sessions));
+    bool done = run_until(loop, [&]() { return connected == sessions; });
+    assert(done);
+    server.wait_members("bots", sessions);
+
+    // Every message reaches every member, the sender included
+    for (int i = 0; i < senders; ++i) {
+        bool sent = bots[i]->send("bot says " + std::to_string(i));
+        assert(sent);
+    }
+    done = run_until(loop, [&]() { return received == static_cast<long>(sessions) * senders; });
+    assert(done);
+    for (auto& bot : bots) assert(bot->missed() == 0);
+    std::cout << "Sessions: " << sessions << ", messages delivered: " << received << std::endl;
+
+    for (auto& bot : bots) bot->close();
+    assert(loop.watched() == 0);
+    server.wait_members("bots", 0);
+
+    std::cout << "✓ Many sessions test passed" << std::endl;
+}
+
+void test_connect_failure_and_close() {
+    std::cout << "\n=== Test: Connect Failure And Close ===" << std::endl;
+
+    // Grab a free port, then close it so nothing listens there
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    assert(bound);
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+
+    EventLoop loop;
+    bool errored = false, disconnected = false;
+    Callbacks callbacks;
+    callbacks.on_error = [&errored](const std::string&) { errored = true; };
+    callbacks.on_disconnected = [&disconnected]() { disconnected = true; };
+    SocketSession session(loop, callbacks);
+    bool connected = session.connect("not-an-address", 1, "x");
+    assert(!connected);
+    connected = session.connect("127.0.0.1", ntohs(addr.sin_port), "x");
+    assert(connected);
+    bool done = run_until(loop, [&]() { return disconnected; });
+    assert(done);
+    assert(errored && !session.is_open());
+    bool sent = session.send("nobody listens");
+    assert(!sent);
+    assert(loop.watched() == 0);
+
+    std::cout << "✓ Failure test passed" << std::endl;
+}
+
+void test_post_and_stop(TestServer& server) {
+    std::cout << "\n=== Test: Driving A Loop From Another Thread ===" << std::endl;
+
+    EventLoop loop;
+    std::atomic<int> echoes(0);
+    Callbacks callbacks;
+    callbacks.on_message = [&echoes](const Message& msg) {
+        if (std::strcmp(msg.user, "poster") == 0) echoes++;
+    };
+    SocketSession session(loop, callbacks);
+    bool connected = session.connect("127.0.0.1", server.port(), "poster", "posted");
+    assert(connected);
+    std::thread runner([&loop]() { loop.run(); });
+
+    // The only thread-safe way in: hand the work to the loop
+    server.wait_members("posted", 1);
+    for (int i = 0; i < 50; ++i) {
+        loop.post([&session, i]() {
+            bool sent = session.send("posted " + std::to_string(i));
+            assert(sent);
+        });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (echoes < 50) {
+        assert(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    loop.post([&session]() { session.close(); });
+    loop.stop();
+    runner.join();
+    assert(!session.is_open());
+    server.wait_members("posted", 0);
+
+    std::cout << "✓ Post test passed" << std::endl;
+}
+
+void test_reconnect_and_resume(TestServer& server) {
+    std::cout << "\n=== Test: Reconnect And Resume From Sequence ===" << std::endl;
+
+    EventLoop loop;
+    int connects = 0, reconnecting = 0, disconnects = 0;
+    std::vector<std::string> heard;
+    std::unique_ptr<SocketSession> talker;
+    const int during_outage = 20;
+
+    Callbacks callbacks;
+    callbacks.on_connected = [&connects]() { connects++; };
+    callbacks.on_disconnected = [&disconnects]() { disconnects++; };
+    callbacks.on_message = [&heard](const Message& msg) {
+        if (std::strcmp(msg.user, "talker") == 0) heard.push_back(msg.text);
+    };
+    callbacks.on_reconnecting = [&](int attempt, int delay_ms) {
+        assert(attempt >= 1 && delay_ms >= 0 && delay_ms <= 400);
+        // The room keeps talking while we are away
+        if (reconnecting++ == 0) {
+            for (int i = 0; i < during_outage; ++i) {
+                bool sent = talker->send("talk " + std::to_string(5 + i));
+                assert(sent);
+            }
+        }
+    };
+    SocketSession listener(loop, callbacks);
+    ReconnectPolicy policy;
+    policy.initial_delay_ms = 200;
+    policy.max_delay_ms = 400;
+    listener.set_reconnect(policy);
+
+    talker.reset(new SocketSession(loop, Callbacks()));
+    bool connected = listener.connect("127.0.0.1", server.port(), "listener", "resume");
+    assert(connected);
+    connected = talker->connect("127.0.0.1", server.port(), "talker", "resume");
+    assert(connected);
+    bool done = run_until(loop, [&]() { return connects == 1; });
+    assert(done);
+    server.wait_members("resume", 2);
+
+    for (int i = 0; i < 5; ++i) {
+        bool sent = talker->send("talk " + std::to_string(i));
+        assert(sent);
+    }
+    done = run_until(loop, [&]() { return heard.size() == 5; });
+    assert(done);
+
+    uint64_t replayed_before = Metrics::global().total(Counter::REPLAYED);
+    uint64_t batches_before = Metrics::global().total(Counter::COMPRESSED_BATCHES);
+    server.drop("listener");
+    done = run_until(loop, [&]() { return connects == 2; });
+    assert(done);
+    assert(disconnects == 0 && reconnecting >= 1);
+    server.wait_members("resume", 2);
+    for (int i = 0; i < 5; ++i) {
+        bool sent = talker->send("talk " + std::to_string(5 + during_outage + i));
+        assert(sent);
+    }
+
+    // Every message exactly once, in order: the gap came from the replay
+    // buffer, nothing from before the drop was sent again
+    const size_t total = 5 + during_outage + 5;
+    done = run_until(loop, [&]() { return heard.size() == total; });
+    assert(done);
+    for (size_t i = 0; i < total; ++i) assert(heard[i] == "talk " + std::to_string(i));
+    assert(listener.missed() == 0);
+    assert(Metrics::global().total(Counter::REPLAYED) - replayed_before == static_cast<uint64_t>(during_outage));
+    // The replay went out deflated: the session offers compression by default
+    assert(Metrics::global().total(Counter::COMPRESSED_BATCHES) > batches_before);
+
+    listener.close();
+    talker->close();
+    assert(loop.watched() == 0);
+    server.wait_members("resume", 0);
+
+    std::cout << "✓ Reconnect test passed" << std::endl;
+}
+
+void test_direct_messages(TestServer& server) {
+    std::cout << "\n=== Test: Direct Messages ===" << std::endl;
+
+    EventLoop loop;
+    std::vector<Message> to_alice, to_bob, to_carol;
+    auto collect = [](std::vector<Message>& into) {
+        Callbacks callbacks;
+        callbacks.on_message = [&into](const Message& msg) { into.push_back(msg); };
+        return callbacks;
+    };
+    SocketSession alice(loop, collect(to_alice)), bob(loop, collect(to_bob)), carol(loop, collect(to_carol));
+    bool connected = alice.connect("127.0.0.1", server.port(), "alice", "dm");
+    assert(connected);
+    connected = bob.connect("127.0.0.1", server.port(), "bob", "dm");
+    assert(connected);
+    connected = carol.connect("127.0.0.1", server.port(), "carol", "dm");
+    assert(connected);
+    auto room = server.context().rooms.get_or_create("dm");
+    bool done = run_until(loop, [&]() { return room->member_count() == 3; });
+    assert(done);
+    assert(server.context().users.find("bob") != nullptr);
+
+    uint64_t misses_before = Metrics::global().total(Counter::DIRECT_MISSES);
+    uint64_t timed_before = Metrics::global().merged(Histogram::DIRECT_LATENCY).count();
+    bool sent = alice.send_to("bob", "psst");
+    assert(sent);
+    sent = alice.send_to("nobody", "hello?");
+    assert(sent);
+    done = run_until(loop, [&]() { return to_bob.size() == 1 && to_alice.size() == 1; });
+    assert(done);
+    assert(std::strcmp(to_bob[0].user, "alice") == 0 && std::strcmp(to_bob[0].to, "bob") == 0);
+    assert(std::strcmp(to_bob[0].text, "psst") == 0 && to_bob[0].seq == 0);
+    assert(std::strcmp(to_alice[0].user, "[System]") == 0 && std::strstr(to_alice[0].text, "nobody"));
+    assert(Metrics::global().total(Counter::DIRECT_MISSES) - misses_before == 1);
+    assert(Metrics::global().merged(Histogram::DIRECT_LATENCY).count() - timed_before == 1);
+
+    // A room message after the DM reaches carol; the DM never did
+    sent = alice.send("everyone");
+    assert(sent);
+    done = run_until(loop, [&]() { return !to_carol.empty(); });
+    assert(done);
+    assert(to_carol.size() == 1 && std::strcmp(to_carol[0].text, "everyone") == 0);
+
+    alice.close();
+    bob.close();
+    carol.close();
+    server.wait_members("dm", 0);
+    assert(server.context().users.find("bob") == nullptr);
+
+    std::cout << "✓ Direct message test passed" << std::endl;
+}
+
+void test_subscription_filters(TestServer& server) {
+    std::cout << "\n=== Test: Subscription Filters ===" << std::endl;
+
+    EventLoop loop;
+    std::vector<std::string> to_bot, to_human;
+    Callbacks bot_callbacks, human_callbacks;
+    bot_callbacks.on_message = [&to_bot](const Message& msg) { to_bot.push_back(msg.text); };
+    human_callbacks.on_message = [&to_human](const Message& msg) { to_human.push_back(msg.text); };
+    SocketSession bot(loop, bot_callbacks), human(loop, human_callbacks);
+    bool filtered = bot.set_filter("alert, ^deploy");
+    assert(filtered);  // Before connecting: travels with the hello
+    bool connected = bot.connect("127.0.0.1", server.port(), "auditbot", "filters");
+    assert(connected);
+    connected = human.connect("127.0.0.1", server.port(), "human", "filters");
+    assert(connected);
+    auto room = server.context().rooms.get_or_create("filters");
+    bool done = run_until(loop, [&]() { return room->member_count() == 2; });
+    assert(done);
+
+    uint64_t filtered_before = Metrics::global().total(Counter::FILTERED);
+    const char* lines[] = {"hello", "ALERT disk full", "deploy v2 done", "redeploy later", "all good"};
+    for (const char* line : lines) {
+        bool sent = human.send(line);
+        assert(sent);
+    }
+    done = run_until(loop, [&]() { return to_human.size() == 5; });
+    assert(done);
+    done = run_until(loop, [&]() { return to_bot.size() == 2; });
+    assert(done);
+    assert((to_bot == std::vector<std::string>{"ALERT disk full", "deploy v2 done"}));
+    assert(bot.missed() == 0);
+    // Counted after the room's send loop, so possibly just after delivery
+    done = run_until(loop, [&]() { return Metrics::global().total(Counter::FILTERED) - filtered_before == 3; });
+    assert(done);
+
+    // A new filter applies once the room has rebuilt its automaton
+    auto rebuilt = [&](uint64_t before) {
+        return run_until(loop, [&]() { return Metrics::global().total(Counter::FILTER_BUILDS) > before; });
+    };
+    uint64_t builds = Metrics::global().total(Counter::FILTER_BUILDS);
+    filtered = bot.set_filter("good") && rebuilt(builds);
+    assert(filtered);
+    bool sent = human.send("deploy again");
+    assert(sent);
+    sent = human.send("still good");
+    assert(sent);
+    done = run_until(loop, [&]() { return to_bot.size() == 3; });
+    assert(done);
+    assert(to_bot.back() == "still good");
+
+    // Clearing it subscribes to everything again
+    builds = Metrics::global().total(Counter::FILTER_BUILDS);
+    filtered = bot.set_filter("") && rebuilt(builds);
+    assert(filtered);
+    sent = human.send("anything");
+    assert(sent);
+    done = run_until(loop, [&]() { return to_bot.size() == 4; });
+    assert(done);
+    assert(to_bot.back() == "anything");
+
+    bot.close();
+    human.close();
+    server.wait_members("filters", 0);
+
+    std::cout << "✓ Subscription filter test passed" << std::endl;
+}
+
+void test_keepalive(TestServer& server) {
+    std::cout << "\n=== Test: Sessions Answer Keep-Alive Pings ===" << std::endl;
+
+    IdleMonitor& idle = server.context().idle;
+    idle.configure(30, 200, 5);
+    idle.start();
+    uint64_t pings_before = Metrics::global().total(Counter::PINGS);
+
+    EventLoop loop;
+    int disconnects = 0;
+    std::vector<Message> heard;
+    Callbacks callbacks;
+    callbacks.on_disconnected = [&disconnects]() { disconnects++; };
+    callbacks.on_message = [&heard](const Message& msg) { heard.push_back(msg); };
+    SocketSession quiet(loop, callbacks);
+    bool connected = quiet.connect("127.0.0.1", server.port(), "quiet", "keepalive");
+    assert(connected);
+
+    // Never sends a thing after its hello, yet outlives the idle timeout
+    run_until(loop, []() { return false; }, 600);
+    assert(quiet.is_connected() && disconnects == 0);
+    assert(heard.empty());  // Pings are handled inside the session
+    assert(Metrics::global().total(Counter::PINGS) - pings_before >= 3);
+
+    idle.stop();
+    quiet.close();
+    server.wait_members("keepalive", 0);
+
+    std::cout << "✓ Keep-alive test passed" << std::endl;
+}
+
+void test_interned_names(TestServer& server) {
+    std::cout << "\n=== Test: Interned Names ===" << std::endl;
+
+    EventLoop loop;
+    std::vector<Message> heard_new, heard_old;
+    std::vector<bool> own_new, own_old;
+    std::unique_ptr<SocketSession> fresh, plain;
+    Callbacks new_callbacks, old_callbacks;
+    new_callbacks.on_message = [&](const Message& msg) {
+        heard_new.push_back(msg);
+        own_new.push_back(fresh->is_own(msg));
+    };
+    old_callbacks.on_message = [&](const Message& msg) {
+        heard_old.push_back(msg);
+        own_old.push_back(plain->is_own(msg));
+    };
+    fresh.reset(new SocketSession(loop, new_callbacks));
+    plain.reset(new SocketSession(loop, old_callbacks));
+    plain->set_interning(false);
+    bool connected = fresh->connect("127.0.0.1", server.port(), "fresh", "interned");
+    assert(connected);
+    connected = plain->connect("127.0.0.1", server.port(), "plain", "interned");
+    assert(connected);
+    auto room = server.context().rooms.get_or_create("interned");
+    bool done = run_until(loop, [&]() { return room->member_count() == 2; });
+    assert(done);
+
+    // Once its name is bound the session sends its id in place of the name
+    const size_t rounds = 5;
+    std::vector<uint64_t> sent_bytes;
+    for (size_t i = 0; i < rounds; ++i) {
+        uint64_t bytes_before = Metrics::global().total(Counter::BYTES_IN);
+        bool sent = fresh->send("from fresh " + std::to_string(i));
+        assert(sent);
+        done = run_until(loop, [&]() { return heard_new.size() == i + 1 && heard_old.size() == i + 1; });
+        assert(done);
+        sent_bytes.push_back(Metrics::global().total(Counter::BYTES_IN) - bytes_before);
+    }
+    assert(sent_bytes[1] < sent_bytes[0] && sent_bytes[rounds - 1] == sent_bytes[1]);
+    bool sent = plain->send("from plain");
+    assert(sent);
+    done = run_until(loop, [&]() { return heard_new.size() == rounds + 1 && heard_old.size() == rounds + 1; });
+    assert(done);
+
+    // Both see every name filled in; only the interning one sees ids
+    for (size_t i = 0; i <= rounds; ++i) {
+        const char* sender = i < rounds ? "fresh" : "plain";
+        for (const Message* msg : {&heard_new[i], &heard_old[i]}) {
+            assert(std::strcmp(msg->user, sender) == 0 && std::strcmp(msg->room, "interned") == 0);
+        }
+        assert(heard_new[i].uid != 0 && heard_new[i].rid != 0 && heard_old[i].uid == 0);
+        assert(own_new[i] == (i < rounds) && own_old[i] == (i == rounds));
+    }
+    assert(heard_new[0].uid == server.context().names.intern("fresh"));
+    assert(heard_new[rounds].uid == server.context().names.intern("plain"));
+
+    fresh->close();
+    plain->close();
+    server.wait_members("interned", 0);
+
+    std::cout << "✓ Interned names test passed" << std::endl;
+}
+
+void test_replayed_capture(TestServer& server) {
+    std::cout << "\n=== Test: Replaying A Captured Session ===" << std::endl;
+
+    // Record a default session (it offers compression) on a capturing server
+    char path[] = "/tmp/chat_replay_XXXXXX";
+    int tmp = mkstemp(path);
+    assert(tmp >= 0);
+    close(tmp);
+    const int messages = 5;
+    {
+        TestServer recorder;
+        recorder.context().capture = std::make_unique<CaptureWriter>();
+        bool opened = recorder.context().capture->open(path);
+        assert(opened);
+        EventLoop loop;
+        int heard = 0;
+        Callbacks callbacks;
+        callbacks.on_message = [&heard](const Message&) { heard++; };
+        SocketSession session(loop, callbacks);
+        bool connected = session.connect("127.0.0.1", recorder.port(), "recorded", "replayed");
+        assert(connected);
+        auto room = recorder.context().rooms.get_or_create("replayed");
+        bool joined = run_until(loop, [&]() { return room->member_count() == 1; });
+        assert(joined);
+        for (int i = 0; i < messages; ++i) {
+            bool sent = session.send("line " + std::to_string(i));
+            assert(sent);
+        }
+        bool echoed = run_until(loop, [&]() { return heard == messages; });
+        assert(echoed);
+        session.close();
+        recorder.wait_members("replayed", 0);
+        recorder.context().capture->close();
+    }
+    std::vector<ChatUtils::CaptureRecord> records;
+    bool loaded = ChatUtils::read_capture(path, records);
+    assert(loaded && records.size() == messages + 2);
+    std::remove(path);
+    const std::string& captured = records.front().payload;
+    Message offered = Message::from_json(captured);
+    assert(records.front().kind == ChatUtils::CaptureRecord::HELLO && offered.deflate && offered.intern);
+
+    // Replayed byte for byte except the hello, the echoes come back as plain
+    // frames that name their sender
+    std::string hello = ChatUtils::replay_hello(captured);
+    Message replayed = Message::from_json(hello);
+    assert(!replayed.deflate && !replayed.intern && std::strcmp(replayed.user, "recorded") == 0);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(server.port()));
+    int rc = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    assert(rc == 0);
+    auto send_payload = [fd](const std::string& payload) {
+        uint32_t len = htonl(static_cast<uint32_t>(payload.size() + 1));
+        std::string frame(reinterpret_cast<const char*>(&len), sizeof(len));
+        frame += payload;
+        frame += MESSAGE_SEPARATOR;
+        return ChatUtils::send_frame(fd, frame.data(), frame.size());
+    };
+    bool sent = send_payload(hello);
+    for (size_t i = 1; sent && i + 1 < records.size(); ++i) sent = send_payload(records[i].payload);
+    assert(sent);
+    for (int i = 0; i < messages; ++i) {
+        Message echo;
+        bool received = ChatUtils::recv_message(fd, echo);
+        assert(received && echo.text == "line " + std::to_string(i));
+        assert(std::strcmp(echo.user, "recorded") == 0 && echo.uid == 0);
+    }
+    close(fd);
+    server.wait_members("replayed", 0);
+
+    std::cout << "✓ Replayed capture test passed" << std::endl;
+}
+
+void test_shm_sessions() {
+    std::cout << "\n=== Test: Shared Memory Sessions On One Loop ===" << std::endl;
+
+    std::string name = "/os_chat_test_client_" + std::to_string(getpid());
+    EventLoop loop;
+    int connected = 0;
+    std::vector<std::string> seen_by_b;
+    Callbacks a_callbacks, b_callbacks;
+    a_callbacks.on_connected = [&connected]() { connected++; };
+    b_callbacks.on_connected = [&connected]() { connected++; };
+    ShmSession* reader = nullptr;
+    b_callbacks.on_message = [&seen_by_b, &reader](const Message& msg) {
+        // Stamped with a hash of the writer's name, so not mistaken for ours
+        assert(msg.uid != 0 && !reader->is_own(msg));
+        seen_by_b.push_back(msg.text);
+    };
+
+    ShmSession a(loop, a_callbacks), b(loop, b_callbacks);
+    reader = &b;
+    bool joined = a.join(name, "alice");
+    assert(joined);
+    joined = b.join(name, "bob");
+    assert(joined);
+    assert(connected == 0);  // Never from inside join()
+
+    // Stay inside the initial ring so nothing is overrun
+    const int messages = MAX_SLOTS - 1;
+    for (int i = 0; i < messages; ++i) {
+        bool sent = a.send("shm " + std::to_string(i));
+        assert(sent);
+    }
+    bool done = run_until(loop, [&]() { return seen_by_b.size() == static_cast<size_t>(messages); });
+    assert(done);
+    assert(connected == 2);
+    for (int i = 0; i < messages; ++i) assert(seen_by_b[i] == "shm " + std::to_string(i));
+    assert(b.missed() == 0);
+
+    a.close();
+    b.close();
+    bool sent = a.send("gone");
+    assert(!sent);
+    shm_unlink(name.c_str());  // The room mutex is shared with real rooms; leave it
+
+    std::cout << "✓ SHM session test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== Client Library Tests ==========\n" << std::endl;
+
+    try {
+        TestServer server;
+        test_many_sessions_one_loop(server);
+        test_connect_failure_and_close();
+        test_post_and_stop(server);
+        test_reconnect_and_resume(server);
+        test_direct_messages(server);
+        test_subscription_filters(server);
+        test_keepalive(server);
+        test_interned_names(server);
+        test_replayed_capture(server);
+        test_shm_sessions();
+        server.context().rooms.clear();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Clock Service Tests
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../shared/clock.h"
+
+using namespace ChatUtils;
+
+// Reference: full gmtime_r + strftime for the whole second
+static std::string reference(int64_t second) {
+    time_t t = static_cast<time_t>(second);
+    struct tm utc;
+    gmtime_r(&t, &utc);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    return buffer;
+}
+
+void test_matches_strftime() {
+    std::cout << "\n=== Test: Cached Prefix Matches strftime ===" << std::endl;
+
+    char out[Clock::kIsoLen];
+    // Walk across second, minute, day and year boundaries in both directions
+    const int64_t seconds[] = {0, 59, 60, 86399, 86400, 1733622420, 1735689599, 1735689600, 1735689599};
+    for (int64_t s : seconds) {
+        int64_t ns = s * 1000000000LL + 123456789;
+        assert(Clock::format_iso8601(ns, out, sizeof(out)) == 20);
+        assert(std::string(out) == reference(s) + "Z");
+
+        assert(Clock::format_iso8601(ns, out, sizeof(out), Clock::Precision::MILLIS) == 24);
+        assert(std::string(out) == reference(s) + ".123Z");
+
+        assert(Clock::format_iso8601(ns, out, sizeof(out), Clock::Precision::MICROS) == 27);
+        assert(std::string(out) == reference(s) + ".123456Z");
+    }
+
+    // Leading zeros in the fraction
+    Clock::format_iso8601(1735689600LL * 1000000000LL + 7000, out, sizeof(out), Clock::Precision::MICROS);
+    assert(std::string(out) == "2025-01-01T00:00:00.000007Z");
+    std::cout << "Sample: " << out << std::endl;
+
+    // Too small a buffer writes nothing
+    char tiny[8];
+    assert(Clock::format_iso8601(0, tiny, sizeof(tiny)) == 0 && tiny[0] == '\0');
+
+    std::cout << "✓ Format test passed" << std::endl;
+}
+
+void test_now_and_threads() {
+    std::cout << "\n=== Test: Per-Thread Caches ===" << std::endl;
+
+    // Every thread has its own cache; all agree with a fresh strftime
+    std::vector<std::thread> threads;
+    std::atomic<int> mismatches(0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&mismatches]() {
+            char out[Clock::kIsoLen];
+            for (int i = 0; i < 20000; ++i) {
+                int64_t ns = Clock::realtime_ns();
+                Clock::format_iso8601(ns, out, sizeof(out), Clock::Precision::MILLIS);
+                if (std::string(out, 19) != reference(ns / 1000000000)) mismatches++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    assert(mismatches == 0);
+
+    std::cout << "✓ Thread cache test passed" << std::endl;
+}
+
+void test_monotonic() {
+    std::cout << "\n=== Test: Monotonic Nanoseconds ===" << std::endl;
+
+    uint64_t last = Clock::monotonic_ns();
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t now = Clock::monotonic_ns();
+        assert(now >= last);
+        last = now;
+    }
+    uint64_t before = Clock::monotonic_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t elapsed = Clock::monotonic_ns() - before;
+    assert(elapsed >= 20000000ULL && elapsed < 2000000000ULL);
+
+    std::cout << "✓ Monotonic test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== Clock Tests ==========\n" << std::endl;
+
+    try {
+        test_matches_strftime();
+        test_now_and_threads();
+        test_monotonic();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
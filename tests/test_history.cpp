@@ -0,0 +1,173 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Message History Store Tests
+ */
+
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../shared/history_store.h"
+
+using namespace ChatUtils;
+
+static std::string base_path() {
+    return "/tmp/test_history_" + std::to_string(getpid());
+}
+
+static void remove_files(const std::string& base) {
+    std::remove((base + ".log").c_str());
+    std::remove((base + ".idx").c_str());
+}
+
+static off_t file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+void test_append_and_get() {
+    std::cout << "\n=== Test: Append and Read Back ===" << std::endl;
+    std::string base = base_path();
+    remove_files(base);
+
+    HistoryStore store;
+    bool opened = store.open(base);
+    assert(opened);
+    assert(store.count() == 0);
+
+    uint64_t index = store.append("alice", "2025-01-01T00:00:00Z", "hello");
+    assert(index == 0);
+    index = store.append("bob", "", "");
+    assert(index == 1);
+    index = store.append("carol", "ts", std::string(5000, 'x'));
+    assert(index == 2);
+    assert(store.count() == 3);
+
+    std::string user, ts, text;
+    bool found = store.get(0, user, ts, text);
+    assert(found);
+    assert(user == "alice" && ts == "2025-01-01T00:00:00Z" && text == "hello");
+    found = store.get(1, user, ts, text);
+    assert(found);
+    assert(user == "bob" && ts.empty() && text.empty());
+    found = store.get(2, user, ts, text);
+    assert(found);
+    assert(user == "carol" && text.size() == 5000);
+    found = store.get(3, user, ts, text);
+    assert(!found);
+
+    // Appends after the first read land beyond the mapping and force a remap
+    for (int i = 0; i < 1000; ++i) {
+        index = store.append("u" + std::to_string(i), "t", "m" + std::to_string(i));
+        assert(index == static_cast<uint64_t>(3 + i));
+    }
+    found = store.get(1002, user, ts, text);
+    assert(found);
+    assert(user == "u999" && text == "m999");
+    found = store.get(0, user, ts, text);
+    assert(found && user == "alice");
+
+    store.close();
+    remove_files(base);
+    std::cout << "✓ Append test passed" << std::endl;
+}
+
+void test_reopen() {
+    std::cout << "\n=== Test: Reopen Keeps History ===" << std::endl;
+    std::string base = base_path();
+    remove_files(base);
+
+    {
+        HistoryStore store;
+        bool opened = store.open(base);
+        assert(opened);
+        for (int i = 0; i < 500; ++i) store.append("user", "ts", "message " + std::to_string(i));
+    }
+
+    HistoryStore store;
+    bool opened = store.open(base);
+    assert(opened);
+    assert(store.count() == 500);
+    std::string user, ts, text;
+    bool found = store.get(499, user, ts, text);
+    assert(found && text == "message 499");
+    found = store.get(0, user, ts, text);
+    assert(found && text == "message 0");
+
+    uint64_t index = store.append("user", "ts", "message 500");
+    assert(index == 500);
+    found = store.get(500, user, ts, text);
+    assert(found && text == "message 500");
+
+    store.close();
+    remove_files(base);
+    std::cout << "✓ Reopen test passed" << std::endl;
+}
+
+void test_torn_tail() {
+    std::cout << "\n=== Test: Torn Tail Is Dropped ===" << std::endl;
+    std::string base = base_path();
+    remove_files(base);
+
+    {
+        HistoryStore store;
+        bool opened = store.open(base);
+        assert(opened);
+        for (int i = 0; i < 10; ++i) store.append("user", "ts", "message " + std::to_string(i));
+    }
+
+    // Simulate a crash mid-append: the last record is cut short and the
+    // index has half an entry after it
+    off_t log_size = file_size(base + ".log");
+    int cut = truncate((base + ".log").c_str(), log_size - 3);
+    assert(cut == 0);
+    int fd = open((base + ".idx").c_str(), O_WRONLY | O_APPEND);
+    assert(fd >= 0);
+    ssize_t written = write(fd, "\x01\x02\x03", 3);
+    assert(written == 3);
+    close(fd);
+
+    HistoryStore store;
+    bool opened = store.open(base);
+    assert(opened);
+    assert(store.count() == 9);
+    assert(file_size(base + ".idx") == static_cast<off_t>(9 * sizeof(uint64_t)));
+
+    // New records continue cleanly after the last complete one
+    uint64_t index = store.append("user", "ts", "replacement");
+    assert(index == 9);
+    store.close();
+    opened = store.open(base);
+    assert(opened);
+    assert(store.count() == 10);
+    std::string user, ts, text;
+    bool found = store.get(8, user, ts, text);
+    assert(found && text == "message 8");
+    found = store.get(9, user, ts, text);
+    assert(found && text == "replacement");
+
+    store.close();
+    remove_files(base);
+    std::cout << "✓ Torn tail test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== History Store Tests ==========\n" << std::endl;
+
+    try {
+        test_append_and_get();
+        test_reopen();
+        test_torn_tail();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
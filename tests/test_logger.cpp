@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Asynchronous Logger Tests
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../shared/common.h"
+
+using namespace ChatUtils;
+
+// Log into a temp file and read back what the drain thread wrote
+class CapturedOutput {
+public:
+    CapturedOutput() {
+        char path[] = "/tmp/chat_logger_testXXXXXX";
+        fd_ = mkstemp(path);
+        assert(fd_ >= 0);
+        unlink(path);
+        Logger::instance().set_output(fd_);
+    }
+
+    ~CapturedOutput() {
+        Logger::instance().flush();
+        Logger::instance().set_output(STDERR_FILENO);
+        close(fd_);
+    }
+
+    std::string text() {
+        Logger::instance().flush();
+        std::string out;
+        char buffer[4096];
+        ssize_t n;
+        off_t offset = 0;
+        while ((n = pread(fd_, buffer, sizeof(buffer), offset)) > 0) {
+            out.append(buffer, static_cast<size_t>(n));
+            offset += n;
+        }
+        return out;
+    }
+
+private:
+    int fd_;
+};
+
+static size_t count_of(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void test_deferred_formatting() {
+    std::cout << "\n=== Test: Deferred Formatting ===" << std::endl;
+
+    CapturedOutput out;
+    std::string user = "alice";
+    LOG_INFO("Test", "Client ", 42, " connected as \"", user, "\" ratio=", 0.5, " ok=", true, " neg=", -7L);
+    LOG_WARN("Test", std::string("plain string message"));
+    log(LogLevel::ERROR, "Test", "through log()");
+
+    std::string text = out.text();
+    std::cout << text;
+    assert(text.find("[INFO] [Test] Client 42 connected as \"alice\" ratio=0.5 ok=true neg=-7\n") != std::string::npos);
+    assert(text.find("[WARN] [Test] plain string message\n") != std::string::npos);
+    assert(text.find("[ERROR] [Test] through log()\n") != std::string::npos);
+
+    // Over-long arguments are cut, not overflowed
+    std::string big(1000, 'x');
+    LOG_INFO("Test", "big:", big);
+    text = out.text();
+    assert(text.find("[INFO] [Test] big:xxx") != std::string::npos);
+    assert(text.find("xxx...\n") != std::string::npos);
+
+    std::cout << "✓ Deferred formatting test passed" << std::endl;
+}
+
+void test_many_threads_keep_order() {
+    std::cout << "\n=== Test: Per-Thread Order Across Threads ===" << std::endl;
+
+    const int threads = 4;
+    const int per_thread = 100;  // Fits in one ring: nothing may drop
+    CapturedOutput out;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                LOG_INFO("Order", "t", t, " n", i, ";");
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    // The rings of exited threads are still drained
+    std::string text = out.text();
+    for (int t = 0; t < threads; ++t) {
+        size_t pos = 0;
+        for (int i = 0; i < per_thread; ++i) {
+            std::string needle = "t" + std::to_string(t) + " n" + std::to_string(i) + ";";
+            pos = text.find(needle, pos);
+            assert(pos != std::string::npos);
+        }
+    }
+    std::cout << "✓ " << threads * per_thread << " records written in per-thread order" << std::endl;
+}
+
+void test_level_filter() {
+    std::cout << "\n=== Test: Runtime Level Filter ===" << std::endl;
+
+    CapturedOutput out;
+    int evaluated = 0;
+    auto expensive = [&evaluated]() {
+        evaluated++;
+        return std::string("costly");
+    };
+
+    Logger::instance().set_level(LogLevel::WARN);
+    LOG_INFO("Filter", "hidden ", expensive());
+    LOG_DEBUG("Filter", "hidden ", expensive());
+    LOG_WARN("Filter", "shown ", expensive());
+    Logger::instance().set_level(LogLevel::INFO);
+
+    std::string text = out.text();
+    assert(evaluated == 1);  // Filtered calls do not evaluate their arguments
+    assert(text.find("hidden") == std::string::npos);
+    assert(text.find("[WARN] [Filter] shown costly") != std::string::npos);
+
+    std::cout << "✓ Level filter test passed" << std::endl;
+}
+
+void test_rate_limit() {
+    std::cout << "\n=== Test: Per-Thread Rate Limit ===" << std::endl;
+
+    const int attempts = 1000;
+    const uint32_t rate = 50;
+    CapturedOutput out;
+    uint64_t limited_before = Logger::instance().rate_limited();
+
+    Logger::instance().set_rate_limit(rate);
+    std::thread spammer([]() {
+        for (int i = 0; i < attempts; ++i) {
+            LOG_INFO("Rate", "spam;");
+        }
+    });
+    spammer.join();
+    Logger::instance().set_rate_limit(0);
+
+    std::string text = out.text();
+    size_t written = count_of(text, "spam;");
+    uint64_t limited = Logger::instance().rate_limited() - limited_before;
+    std::cout << "Written: " << written << ", rate-limited: " << limited << std::endl;
+    assert(written + limited == static_cast<uint64_t>(attempts));
+    assert(written >= rate && written <= rate + 10);
+    assert(text.find("rate-limited") != std::string::npos);
+
+    std::cout << "✓ Rate limit test passed" << std::endl;
+}
+
+void test_full_ring_drops_instead_of_blocking() {
+    std::cout << "\n=== Test: Full Ring Drops Instead of Blocking ===" << std::endl;
+
+    const int attempts = 5000;
+    uint64_t dropped_before = Logger::instance().dropped();
+
+    // Nobody reads the pipe yet, so the drain thread stalls once it is full
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    fcntl(fds[1], F_SETPIPE_SZ, 4096);  // Smaller than one ring's worth
+    Logger::instance().set_output(fds[1]);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < attempts; ++i) {
+        LOG_INFO("Drop", "record;");
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // While the writer is stuck, a thread that has never logged can still
+    // start to, and the loss counters can still be read
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::atomic<bool> late_logged(false), counted(false);
+    std::thread late([&late_logged]() {
+        for (int i = 0; i < 10; ++i) LOG_INFO("Drop", "late;");
+        late_logged = true;
+    });
+    std::thread counter([&counted]() {
+        Logger::instance().dropped();
+        counted = true;
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while ((!late_logged || !counted) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool unblocked = late_logged && counted;
+
+    std::string text;
+    std::thread reader([&text, fd = fds[0]]() {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) > 0) text.append(buffer, static_cast<size_t>(n));
+    });
+    Logger::instance().flush();
+    Logger::instance().set_output(STDERR_FILENO);
+    close(fds[1]);
+    reader.join();
+    late.join();
+    counter.join();
+    close(fds[0]);
+
+    size_t written = count_of(text, "record;");
+    uint64_t dropped = Logger::instance().dropped() - dropped_before;
+    std::cout << "Logged " << attempts << " in " << elapsed * 1000 << " ms: written " << written
+              << ", dropped " << dropped << std::endl;
+    assert(dropped > 0);
+    assert(written + dropped == static_cast<uint64_t>(attempts));
+    assert(text.find("records dropped (ring full)") != std::string::npos);
+    assert(elapsed < 1.0);  // The caller never waited on the stalled writer
+    assert(unblocked);
+    assert(count_of(text, "late;") == 10);
+
+    std::cout << "✓ Drop test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== Logger Tests ==========\n" << std::endl;
+
+    try {
+        test_deferred_formatting();
+        test_many_threads_keep_order();
+        test_level_filter();
+        test_rate_limit();
+        test_full_ring_drops_instead_of_blocking();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
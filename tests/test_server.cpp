@@ -0,0 +1,1436 @@
+/*
+ * MIT License
+ * Copyright (c) 2025 OS Chat Project
+ *
+ * Server Core Tests
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include "../server/client_handler.h"
+#include "../server/filter_matcher.h"
+#include "../server/metrics.h"
+#include "../server/metrics_server.h"
+#include "../server/outbox.h"
+#include "../server/rate_limiter.h"
+#include "../server/replay_buffer.h"
+#include "../server/sequencer.h"
+#include "../server/server_context.h"
+#include "../server/task_pool.h"
+#include "../server/timer_wheel.h"
+#include "../server/tracer.h"
+#include "../shared/capture.h"
+#include "../shared/compression.h"
+#include "../shared/common.h"
+#include "../shared/hdr_histogram.h"
+
+void test_sequencer_total_order() {
+    std::cout << "\n=== Test: Sequencer Total Order ===" << std::endl;
+
+    const int producers = 4;
+    const int per_producer = 5000;
+
+    std::vector<uint64_t> seqs;
+    std::vector<int> last(producers, -1);
+    bool fifo_ok = true;
+
+    Sequencer sequencer([&](const Message& msg, int sender_id) {
+        seqs.push_back(msg.seq);
+        int n = std::atoi(msg.text);
+        if (n != last[sender_id] + 1) fifo_ok = false;
+        last[sender_id] = n;
+    });
+    sequencer.start();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&sequencer, p]() {
+            Message msg;
+            for (int n = 0; n < per_producer; ++n) {
+                std::snprintf(msg.text, MAX_MESSAGE_LEN, "%d", n);
+                sequencer.submit(msg, p);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    const uint64_t total = static_cast<uint64_t>(producers) * per_producer;
+    for (int i = 0; i < 500 && sequencer.last_sequence() < total; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    sequencer.stop();
+
+    assert(sequencer.last_sequence() == total);
+    assert(seqs.size() == total);
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        assert(seqs[i] == i + 1);  // Dense and monotonic
+    }
+    assert(fifo_ok);  // Each sender's messages keep their order
+
+    std::cout << "✓ Sequencer test passed" << std::endl;
+}
+
+void test_sequence_on_wire() {
+    std::cout << "\n=== Test: Sequence Number On The Wire ===" << std::endl;
+
+    Message msg;
+    strncpy(msg.user, "alice", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "ops", MAX_ROOMNAME_LEN - 1);
+    strncpy(msg.text, "seq \"quoted\" text", MAX_MESSAGE_LEN - 1);
+    msg.seq = 1234567890123ULL;
+
+    Message parsed = Message::from_json(msg.to_json());
+    assert(parsed.seq == msg.seq);
+    assert(strcmp(parsed.room, "ops") == 0);
+    assert(strcmp(parsed.user, "alice") == 0);
+
+    // Frames without the optional keys still parse
+    Message plain = Message::from_json("{\"user\":\"bob\",\"time\":\"t\",\"text\":\"hi\"}");
+    assert(plain.seq == 0);
+    assert(plain.room[0] == '\0');
+    assert(strcmp(plain.text, "hi") == 0);
+
+    std::cout << "✓ Wire sequence test passed" << std::endl;
+}
+
+void test_replay_buffer() {
+    std::cout << "\n=== Test: Replay Buffer ===" << std::endl;
+
+    ReplayBuffer recent(4);
+    std::vector<uint64_t> got;
+    auto collect = [&got](const char* frame, size_t len) {
+        got.push_back(std::strtoull(std::string(frame, len).c_str(), nullptr, 10));
+        return true;
+    };
+    size_t replayed = recent.replay_after(0, collect);
+    assert(replayed == 0);
+
+    char frame[32];
+    for (uint64_t seq = 1; seq <= 10; ++seq) {
+        int len = std::snprintf(frame, sizeof(frame), "%llu", static_cast<unsigned long long>(seq));
+        recent.append(seq, frame, static_cast<size_t>(len));
+    }
+    assert(recent.newest() == 10);
+
+    // Only the gap, oldest first; what fell out of the ring is skipped
+    replayed = recent.replay_after(8, collect);
+    assert(replayed == 2);
+    assert((got == std::vector<uint64_t>{9, 10}));
+    got.clear();
+    replayed = recent.replay_after(2, collect);
+    assert(replayed == 4);
+    assert((got == std::vector<uint64_t>{7, 8, 9, 10}));
+    replayed = recent.replay_after(10, collect);
+    assert(replayed == 0);
+    replayed = recent.replay_after(50, collect);
+    assert(replayed == 0);
+
+    // A failed send stops the replay
+    replayed = recent.replay_after(0, [](const char*, size_t) { return false; });
+    assert(replayed == 0);
+
+    // The byte budget evicts too: 10 bytes hold only the last three of these
+    ReplayBuffer tight(8, 10);
+    for (uint64_t seq = 1; seq <= 5; ++seq) {
+        int len = std::snprintf(frame, sizeof(frame), "%03llu", static_cast<unsigned long long>(seq));
+        tight.append(seq, frame, static_cast<size_t>(len));
+    }
+    got.clear();
+    replayed = tight.replay_after(0, collect);
+    assert(replayed == 3);
+    assert((got == std::vector<uint64_t>{3, 4, 5}));
+
+    std::cout << "✓ Replay buffer test passed" << std::endl;
+}
+
+void test_token_bucket() {
+    std::cout << "\n=== Test: Token Bucket ===" << std::endl;
+
+    // 10 per second, bursts of 5: the burst goes at once, then one per 100 ms
+    const uint64_t ms = 1000000;
+    TokenBucket bucket(10, 5);
+    uint64_t now = 1000 * ms;
+    for (int i = 0; i < 5; ++i) {
+        uint64_t wait = bucket.take(now);
+        assert(wait == 0);
+    }
+    uint64_t wait = bucket.take(now);
+    assert(wait == 100 * ms);
+    uint64_t again = bucket.take(now + wait - 1);
+    assert(again != 0);  // Refused takes cost nothing
+    again = bucket.take(now + wait);
+    assert(again == 0);
+    again = bucket.take(now + 10000 * ms);
+    assert(again == 0);  // Idle time refills, up to the burst
+
+    TokenBucket unlimited;
+    uint64_t none = unlimited.take(now);
+    assert(!unlimited.limited() && none == 0);
+
+    // Shared across threads without a lock: exactly the burst gets through
+    TokenBucket shared(1, 1000);
+    std::atomic<int> taken(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i) {
+                if (shared.take(now) == 0) taken++;
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    assert(taken == 1000);
+
+    // Connections from one address share a bucket, which goes with the last of them
+    ServerContext context;
+    context.limits.ip_rate = 50;
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool bound = bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    assert(bound);
+    bool listening = listen(listener, 4) == 0;
+    assert(listening);
+    socklen_t len = sizeof(addr);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len);
+    int a = socket(AF_INET, SOCK_STREAM, 0), b = socket(AF_INET, SOCK_STREAM, 0);
+    bool connected = connect(a, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    assert(connected);
+    connected = connect(b, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    assert(connected);
+    {
+        auto bucket_a = context.ip_buckets.bucket_for(a, context.limits);
+        auto bucket_b = context.ip_buckets.bucket_for(b, context.limits);
+        assert(bucket_a && bucket_a == bucket_b);
+        int sv[2];
+        int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        assert(paired == 0);
+        assert(!context.ip_buckets.bucket_for(sv[0], context.limits));  // No address to key on
+        close(sv[0]);
+        close(sv[1]);
+        std::weak_ptr<TokenBucket> weak = bucket_a;
+        bucket_a.reset();
+        bucket_b.reset();
+        assert(weak.expired());
+    }
+    close(a);
+    close(b);
+    close(listener);
+
+    std::cout << "✓ Token bucket test passed" << std::endl;
+}
+
+void test_client_rate_limit() {
+    std::cout << "\n=== Test: Per-Client Rate Limit ===" << std::endl;
+
+    // 200 messages per second after a burst of 20: 100 messages take ~0.4 s
+    const int messages = 100;
+    ServerContext context;
+    context.limits.client_rate = 200;
+    context.limits.client_burst = 20;
+
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 3, context);
+    handler->start();
+
+    Message msg;
+    strncpy(msg.user, "flood", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "limited", MAX_ROOMNAME_LEN - 1);
+    strncpy(msg.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+    bool sent = ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    auto room = context.rooms.get_or_create("limited");
+    for (int i = 0; i < 200 && room->member_count() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // The flood goes into the socket at once; the server reads it at its pace
+    uint64_t throttled_before = Metrics::global().total(Counter::THROTTLED);
+    auto start = std::chrono::steady_clock::now();
+    std::thread flood([&]() {
+        Message line = msg;
+        for (int i = 0; i < messages; ++i) {
+            std::snprintf(line.text, MAX_MESSAGE_LEN, "flood %d", i);
+            bool sent = ChatUtils::send_message(sv[1], line);
+            assert(sent);
+        }
+    });
+    Message echo;
+    for (int i = 0; i < messages; ++i) {
+        bool received = ChatUtils::recv_message(sv[1], echo);
+        assert(received);
+        assert(echo.text == "flood " + std::to_string(i));  // Held back, never dropped
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    flood.join();
+    uint64_t throttled = Metrics::global().total(Counter::THROTTLED) - throttled_before;
+    std::cout << "Messages: " << messages << " in " << elapsed << " s, throttled: " << throttled << std::endl;
+    assert(elapsed > 0.3);
+    assert(throttled >= static_cast<uint64_t>(messages - 20 - 5));
+
+    shutdown(sv[1], SHUT_RDWR);
+    while (!handler->is_finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handler.reset();
+    room.reset();
+    context.rooms.clear();
+    close(sv[1]);
+
+    std::cout << "✓ Client rate limit test passed" << std::endl;
+}
+
+void test_timer_wheel() {
+    std::cout << "\n=== Test: Hierarchical Timer Wheel ===" << std::endl;
+
+    // Deadlines on every level fire exactly on their tick
+    TimerWheel wheel(1000);
+    struct Probe : TimerWheel::Timer {
+        uint64_t fired_at = 0;
+    };
+    std::vector<Probe> probes(6);
+    const uint64_t due[] = {1000, 1001, 1063, 1064, 1000 + 5000, 1000 + 300000};
+    for (size_t i = 0; i < probes.size(); ++i) wheel.schedule(&probes[i], due[i]);
+    assert(wheel.size() == 6);
+
+    // Cancel and re-arm before anything runs
+    Probe cancelled, moved;
+    wheel.schedule(&cancelled, 1010);
+    wheel.cancel(&cancelled);
+    wheel.schedule(&moved, 1010);
+    wheel.schedule(&moved, 1020);
+    assert(!cancelled.armed() && wheel.size() == 7);
+
+    uint64_t tick = 1000;
+    auto record = [&tick](TimerWheel::Timer* t) { static_cast<Probe*>(t)->fired_at = tick; };
+    for (; tick <= 1000 + 300000; ++tick) wheel.advance(tick, record);
+    for (size_t i = 0; i < probes.size(); ++i) assert(probes[i].fired_at == due[i]);
+    assert(moved.fired_at == 1020 && cancelled.fired_at == 0);
+    assert(wheel.size() == 0);
+
+    // A callback may re-arm its own timer, and a jump fires everything due
+    TimerWheel again;
+    Probe repeating;
+    int fires = 0;
+    again.schedule(&repeating, 10);
+    again.advance(1000, [&](TimerWheel::Timer* t) {
+        if (++fires < 5) again.schedule(t, again.now() + 100);
+    });
+    assert(fires == 5 && again.size() == 0);
+
+    // Many timers, random deadlines up to four levels out, none early or late
+    std::vector<Probe> many(100000);
+    TimerWheel big;
+    uint64_t seed = 12345;
+    for (auto& p : many) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        big.schedule(&p, 1 + (seed >> 33) % 200000);
+    }
+    size_t fired = 0;
+    bool exact = true;
+    for (tick = 0; big.size() > 0; ++tick) {
+        fired += big.advance(tick, [&](TimerWheel::Timer* t) {
+            if (t->expires != tick) exact = false;
+        });
+    }
+    assert(fired == many.size() && exact);
+
+    std::cout << "✓ Timer wheel test passed" << std::endl;
+}
+
+void test_idle_reaping() {
+    std::cout << "\n=== Test: Keep-Alive Pings And Idle Reaping ===" << std::endl;
+
+    ServerContext context;
+    context.idle.configure(50, 250, 5);
+    context.idle.start();
+    uint64_t pings_before = Metrics::global().total(Counter::PINGS);
+    uint64_t reaped_before = Metrics::global().total(Counter::IDLE_REAPED);
+
+    // One peer answers every ping, one goes silent after its hello, one never says hello
+    int live[2], mute[2], silent[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, live);
+    assert(paired == 0);
+    paired = socketpair(AF_UNIX, SOCK_STREAM, 0, mute);
+    assert(paired == 0);
+    paired = socketpair(AF_UNIX, SOCK_STREAM, 0, silent);
+    assert(paired == 0);
+    auto live_handler = std::make_shared<ClientHandler>(live[0], 1, context);
+    auto mute_handler = std::make_shared<ClientHandler>(mute[0], 2, context);
+    auto silent_handler = std::make_shared<ClientHandler>(silent[0], 3, context);
+    live_handler->start();
+    mute_handler->start();
+    silent_handler->start();
+    assert(context.idle.watched() == 3);
+
+    Message hello;
+    std::strncpy(hello.user, "alive", MAX_USERNAME_LEN - 1);
+    std::strncpy(hello.room, "idle", MAX_ROOMNAME_LEN - 1);
+    bool sent = ChatUtils::send_message(live[1], hello);
+    assert(sent);
+    std::strncpy(hello.user, "mute", MAX_USERNAME_LEN - 1);
+    sent = ChatUtils::send_message(mute[1], hello);
+    assert(sent);
+
+    // Answer pings for well past the idle timeout
+    int answered = 0;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(800);
+    while (std::chrono::steady_clock::now() < until) {
+        pollfd pfd{live[1], POLLIN, 0};
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        Message ping;
+        bool received = ChatUtils::recv_message(live[1], ping);
+        assert(received);
+        assert(ping.heartbeat == HEARTBEAT_PING);
+        Message pong;
+        std::strncpy(pong.user, "alive", MAX_USERNAME_LEN - 1);
+        pong.heartbeat = HEARTBEAT_PONG;
+        sent = ChatUtils::send_message(live[1], pong);
+        assert(sent);
+        answered++;
+    }
+    assert(answered >= 3);
+    assert(live_handler->is_connected() && !live_handler->is_finished());
+    assert(mute_handler->is_finished() && silent_handler->is_finished());
+    assert(Metrics::global().total(Counter::IDLE_REAPED) - reaped_before == 2);
+    assert(Metrics::global().total(Counter::PINGS) - pings_before >= static_cast<uint64_t>(answered));
+    assert(context.idle.watched() == 1);
+
+    // Pongs never reached the room
+    auto room = context.rooms.get_or_create("idle");
+    assert(room->last_sequence() == 0);
+
+    shutdown(live[1], SHUT_RDWR);
+    live_handler->stop();
+    mute_handler->stop();
+    silent_handler->stop();
+    context.idle.stop();
+    assert(context.idle.watched() == 0);
+    for (int fd : {live[1], mute[1], silent[1]}) close(fd);
+    room.reset();
+    context.rooms.clear();
+
+    std::cout << "Pings answered: " << answered << std::endl;
+    std::cout << "✓ Idle reaping test passed" << std::endl;
+}
+
+void test_throttled_not_idle() {
+    std::cout << "\n=== Test: Throttled Client Is Not Idle ===" << std::endl;
+
+    // Two messages a second, reaped after 400 ms of silence
+    ServerContext context;
+    context.limits.client_rate = 2;
+    context.limits.client_burst = 1;
+    context.idle.configure(0, 400, 5);
+    context.idle.start();
+    uint64_t reaped_before = Metrics::global().total(Counter::IDLE_REAPED);
+
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 1, context);
+    handler->start();
+    Message msg;
+    strncpy(msg.user, "patient", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "throttled", MAX_ROOMNAME_LEN - 1);
+    bool sent = ChatUtils::send_message(sv[1], msg);
+
+    // The first spends the token; the second, 300 ms on, is held for 200 ms
+    // more. Quiet for 500 ms by the time it is admitted, but it was read at 300.
+    strncpy(msg.text, "first", MAX_MESSAGE_LEN - 1);
+    sent = sent && ChatUtils::send_message(sv[1], msg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    strncpy(msg.text, "second", MAX_MESSAGE_LEN - 1);
+    sent = sent && ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    Message echo;
+    bool received = ChatUtils::recv_message(sv[1], echo) && ChatUtils::recv_message(sv[1], echo);
+    assert(received && strcmp(echo.text, "second") == 0);
+    assert(!handler->is_finished());
+    assert(Metrics::global().total(Counter::IDLE_REAPED) == reaped_before);
+
+    shutdown(sv[1], SHUT_RDWR);
+    handler->stop();
+    context.idle.stop();
+    close(sv[1]);
+    handler.reset();
+    context.rooms.clear();
+
+    std::cout << "✓ Throttled client test passed" << std::endl;
+}
+
+static FrameRef tagged_frame(char tag, size_t size) {
+    FrameRef frame(FrameBuffer::acquire(size));
+    std::memset(frame->data(), tag, size);
+    frame->set_size(size);
+    return frame;
+}
+
+void test_outbox_lanes() {
+    std::cout << "\n=== Test: Outbox Priority Lanes ===" << std::endl;
+
+    Outbox outbox;
+    FrameRef none = outbox.pop();
+    assert(outbox.empty() && !none);
+
+    // Control first, then a room turn (two 1000-byte frames fit a quantum),
+    // then the direct lane's small frames, then the room again
+    for (int i = 0; i < 6; ++i) outbox.push(Outbox::ROOM, tagged_frame('r', 1000));
+    for (int i = 0; i < 6; ++i) outbox.push(Outbox::DIRECT, tagged_frame('d', 100));
+    outbox.push(Outbox::CONTROL, tagged_frame('c', 20));
+    assert(outbox.frames() == 13 && outbox.bytes() == 6 * 1000 + 6 * 100 + 20);
+    std::string order;
+    while (FrameRef frame = outbox.pop()) {
+        order += frame->data()[0];
+        if (order.size() == 4) outbox.push(Outbox::CONTROL, tagged_frame('c', 20));  // Jumps the queue
+    }
+    std::cout << "Order: " << order << std::endl;
+    assert(order == "crrdcdddddrrrr");
+    assert(outbox.empty() && outbox.bytes() == 0);
+
+    // Both sources backlogged: bytes are shared evenly, whatever the frame sizes
+    for (int i = 0; i < 200; ++i) outbox.push(Outbox::ROOM, tagged_frame('r', 2000));
+    for (int i = 0; i < 2000; ++i) outbox.push(Outbox::DIRECT, tagged_frame('d', 150));
+    size_t room_bytes = 0, direct_bytes = 0;
+    while (room_bytes + direct_bytes < 200000) {
+        FrameRef frame = outbox.pop();
+        (frame->data()[0] == 'r' ? room_bytes : direct_bytes) += frame->size();
+    }
+    std::cout << "Room bytes: " << room_bytes << ", direct bytes: " << direct_bytes << std::endl;
+    assert(room_bytes > 90000 && direct_bytes > 90000);
+
+    // Messages pick their lane
+    Message msg;
+    strncpy(msg.user, "alice", MAX_USERNAME_LEN - 1);
+    assert(Outbox::lane_for(msg) == Outbox::ROOM);
+    strncpy(msg.to, "bob", MAX_USERNAME_LEN - 1);
+    assert(Outbox::lane_for(msg) == Outbox::DIRECT);
+    msg.heartbeat = HEARTBEAT_PONG;
+    assert(Outbox::lane_for(msg) == Outbox::CONTROL);
+
+    outbox.clear();
+    assert(outbox.empty() && outbox.frames(Outbox::ROOM) == 0 && outbox.frames(Outbox::DIRECT) == 0);
+
+    std::cout << "✓ Outbox lanes test passed" << std::endl;
+}
+
+// What connect_client() says in its hello, and how its socket is set up
+enum ClientFlags {
+    SLOW_READER = 1,  // A small send buffer, so a backlog piles up in the outbox
+    CONFLATE = 2,
+    DEFLATE = 4,
+    INTERN = 8,
+};
+
+// A handler on one end of a socketpair; the test is the client on `peer`
+struct TestClient {
+    std::shared_ptr<ClientHandler> handler;
+    std::shared_ptr<Room> room;
+    int peer = -1;
+};
+
+// Start a handler and say hello as `user`, returning once it has joined `room`
+static TestClient connect_client(ServerContext& context, int id, const char* user, const char* room,
+                                 int flags = 0) {
+    TestClient client;
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    if (flags & SLOW_READER) {
+        int small = 16384;
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    }
+    client.handler = std::make_shared<ClientHandler>(sv[0], id, context);
+    client.handler->start();
+    client.peer = sv[1];
+
+    Message hello;
+    strncpy(hello.user, user, MAX_USERNAME_LEN - 1);
+    strncpy(hello.room, room, MAX_ROOMNAME_LEN - 1);
+    hello.conflate = flags & CONFLATE;
+    hello.deflate = flags & DEFLATE;
+    hello.intern = flags & INTERN;
+    client.room = context.rooms.get_or_create(room);
+    size_t members = client.room->member_count();
+    bool sent = ChatUtils::send_message(client.peer, hello);
+    assert(sent);
+    while (client.room->member_count() == members) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return client;
+}
+
+// Hang up and wait for the handler to finish
+static void disconnect_client(TestClient& client) {
+    shutdown(client.peer, SHUT_RDWR);
+    while (!client.handler->is_finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    client.handler.reset();
+    client.room.reset();
+    close(client.peer);
+    client.peer = -1;
+}
+
+void test_backlogged_client() {
+    std::cout << "\n=== Test: Backlogged Client ===" << std::endl;
+
+    const int messages = 500;
+    Message line;
+    strncpy(line.user, "bulk", MAX_USERNAME_LEN - 1);
+    std::memset(line.text, 'x', 400);
+
+    // A reader that has stopped reading: the room's stream piles up in its outbox
+    ServerContext context;
+    TestClient slow = connect_client(context, 1, "slow", "lanes", SLOW_READER);
+    uint64_t queued_before = Metrics::global().total(Counter::SEND_QUEUED);
+    for (int i = 0; i < messages; ++i) slow.room->publish(line, 0);
+    while (slow.room->last_sequence() < messages || slow.room->queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Fan-out never waited for the reader
+    assert(slow.handler->outbox_bytes() > 0);
+    assert(Metrics::global().total(Counter::SEND_QUEUED) > queued_before);
+
+    // A ping now is answered ahead of everything still queued
+    uint64_t frames_in = Metrics::global().total(Counter::FRAMES_IN);
+    Message ping;
+    strncpy(ping.user, "slow", MAX_USERNAME_LEN - 1);
+    ping.heartbeat = HEARTBEAT_PING;
+    bool sent = ChatUtils::send_message(slow.peer, ping);
+    assert(sent);
+    while (Metrics::global().total(Counter::FRAMES_IN) == frames_in) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    int before_pong = -1;
+    uint64_t expected = 1;
+    Message in;
+    while (expected <= static_cast<uint64_t>(messages)) {
+        bool received = ChatUtils::recv_message(slow.peer, in);
+        assert(received);
+        if (in.heartbeat == HEARTBEAT_PONG) {
+            before_pong = static_cast<int>(expected - 1);
+            continue;
+        }
+        assert(in.seq == expected);  // The room's stream itself stays in order
+        expected++;
+    }
+    std::cout << "Room frames ahead of the pong: " << before_pong << " of " << messages << std::endl;
+    assert(before_pong >= 0 && before_pong < messages / 2);
+    assert(slow.handler->outbox_bytes() == 0);
+
+    disconnect_client(slow);
+    context.rooms.clear();
+
+    // Past the outbox limit the reader is cut off rather than buffered forever
+    ServerContext strict;
+    strict.outbox_limit = 64 * 1024;
+    TestClient stuck = connect_client(strict, 2, "slow", "lanes", SLOW_READER);
+    uint64_t slow_before = Metrics::global().total(Counter::SLOW_CONSUMERS);
+    for (int i = 0; i < messages; ++i) stuck.room->publish(line, 0);
+    while (!stuck.handler->is_finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    assert(Metrics::global().total(Counter::SLOW_CONSUMERS) - slow_before == 1);
+    assert(stuck.room->member_count() == 0);
+
+    disconnect_client(stuck);
+    strict.rooms.clear();
+
+    std::cout << "✓ Backlogged client test passed" << std::endl;
+}
+
+void test_conflation() {
+    std::cout << "\n=== Test: Conflating Slow Reader ===" << std::endl;
+
+    // The hello carries the request
+    Message hello;
+    hello.conflate = true;
+    char json[MAX_FRAME_LEN];
+    Message parsed;
+    assert(Message::parse(json, hello.encode(json, sizeof(json)), parsed) && parsed.conflate);
+
+    const int messages = 500;
+    ServerContext context;
+    context.conflate_after = 32 * 1024;
+    TestClient dashboard = connect_client(context, 1, "dashboard", "ticker", SLOW_READER | CONFLATE);
+
+    // Nobody reads while the room sends ~225 KB
+    uint64_t conflated_before = Metrics::global().total(Counter::CONFLATED);
+    Message line;
+    strncpy(line.user, "feed", MAX_USERNAME_LEN - 1);
+    std::memset(line.text, 'x', 400);
+    for (int i = 0; i < messages; ++i) dashboard.room->publish(line, 0);
+    while (dashboard.room->last_sequence() < messages || dashboard.room->queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(dashboard.handler->outbox_bytes() <= context.conflate_after + MAX_FRAME_LEN);
+    uint64_t conflated = Metrics::global().total(Counter::CONFLATED) - conflated_before;
+    assert(conflated > 0);
+
+    // What arrives is a gapless sequence: skipped runs stand in for themselves
+    uint64_t expected = 1, received = 0, skipped = 0, summaries = 0;
+    Message in;
+    while (expected <= static_cast<uint64_t>(messages)) {
+        bool got = ChatUtils::recv_message(dashboard.peer, in);
+        assert(got);
+        if (std::strcmp(in.user, "[System]") == 0) {
+            unsigned long long count = 0, last = 0;
+            int fields = std::sscanf(in.text, "%llu messages skipped, last seq %llu", &count, &last);
+            assert(fields == 2);
+            assert(last == in.seq && in.seq == expected + count - 1);
+            skipped += count;
+            summaries++;
+            expected = in.seq + 1;
+            continue;
+        }
+        assert(in.seq == expected);
+        expected++;
+        received++;
+    }
+    std::cout << "Received " << received << ", skipped " << skipped << " in " << summaries << " summaries"
+              << std::endl;
+    assert(received + skipped == static_cast<uint64_t>(messages));
+    assert(skipped == conflated && summaries > 0);
+    assert(std::strcmp(in.user, "feed") == 0 && in.seq == static_cast<uint64_t>(messages));  // The latest made it
+
+    disconnect_client(dashboard);
+    context.rooms.clear();
+
+    std::cout << "✓ Conflation test passed" << std::endl;
+}
+
+// One frame off the wire, as it came: the prefix (with FRAME_COMPRESSED) and the payload
+static uint32_t recv_raw_frame(int fd, std::vector<char>& payload) {
+    uint32_t prefix = 0;
+    ssize_t got = recv(fd, &prefix, 4, MSG_WAITALL);
+    assert(got == 4);
+    uint32_t value = ntohl(prefix);
+    payload.resize(value & ~FRAME_COMPRESSED);
+    got = recv(fd, payload.data(), payload.size(), MSG_WAITALL);
+    assert(got == static_cast<ssize_t>(payload.size()));
+    return value;
+}
+
+void test_compressed_batches() {
+    std::cout << "\n=== Test: Compressed Batches ===" << std::endl;
+
+    const int messages = 300;
+    ServerContext context;
+    TestClient zipped = connect_client(context, 1, "zipped", "deflate", SLOW_READER | DEFLATE);
+
+    // One message to an idle reader goes out as it is
+    Message line;
+    strncpy(line.user, "chatter", MAX_USERNAME_LEN - 1);
+    strncpy(line.text, "hello there", MAX_MESSAGE_LEN - 1);
+    zipped.room->publish(line, 0);
+    std::vector<char> frame;
+    uint32_t value = recv_raw_frame(zipped.peer, frame);
+    assert(!(value & FRAME_COMPRESSED));
+
+    // A backlog of chat text goes out as deflated batches
+    uint64_t batches_before = Metrics::global().total(Counter::COMPRESSED_BATCHES);
+    uint64_t bytes_before = Metrics::global().total(Counter::BYTES_OUT);
+    for (int i = 0; i < messages; ++i) {
+        std::snprintf(line.text, MAX_MESSAGE_LEN, "status update %d: build green, deploy to staging queued", i);
+        zipped.room->publish(line, 0);
+    }
+    while (zipped.room->last_sequence() < messages + 1 || zipped.room->queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ChatUtils::InflateStream inflater;
+    std::vector<char> inflated(MAX_BATCH_LEN + 1);
+    uint64_t expected = 2, raw_bytes = 0, batches = 0;
+    auto check = [&](const char* payload, size_t len) {
+        Message msg;
+        assert(Message::parse(payload, len, msg));
+        assert(msg.seq == expected);
+        assert(std::string(msg.text) == "status update " + std::to_string(expected - 2) +
+                                             ": build green, deploy to staging queued");
+        expected++;
+    };
+    while (expected < static_cast<uint64_t>(messages) + 2) {
+        value = recv_raw_frame(zipped.peer, frame);
+        if (!(value & FRAME_COMPRESSED)) {
+            raw_bytes += 4 + frame.size();
+            check(frame.data(), frame.size());
+            continue;
+        }
+        batches++;
+        long n = inflater.inflate_block(frame.data(), frame.size(), inflated.data(), inflated.size());
+        assert(n > 0);
+        for (size_t at = 0; at < static_cast<size_t>(n);) {
+            uint32_t inner;
+            std::memcpy(&inner, inflated.data() + at, 4);
+            size_t len = ntohl(inner);
+            raw_bytes += 4 + len;
+            check(inflated.data() + at + 4, len);
+            at += 4 + len;
+        }
+    }
+    uint64_t wire_bytes = Metrics::global().total(Counter::BYTES_OUT) - bytes_before;
+    std::cout << "Batches: " << batches << ", " << raw_bytes << " bytes of frames in " << wire_bytes
+              << " on the wire" << std::endl;
+    assert(batches > 0 && Metrics::global().total(Counter::COMPRESSED_BATCHES) - batches_before == batches);
+    assert(wire_bytes * 2 < raw_bytes);
+
+    disconnect_client(zipped);
+    context.rooms.clear();
+
+    // With no minimum any backlog is batched, and an empty outbox sends nothing
+    ServerContext eager;
+    eager.compress_min = 0;
+    TestClient keen = connect_client(eager, 2, "zipped", "deflate", SLOW_READER | DEFLATE);
+    for (int i = 0; i < messages; ++i) keen.room->publish(line, 0);
+    while (keen.room->last_sequence() < messages || keen.room->queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    int received = 0;
+    while (received < messages) {
+        value = recv_raw_frame(keen.peer, frame);
+        if (!(value & FRAME_COMPRESSED)) {
+            received++;
+            continue;
+        }
+        long n = inflater.inflate_block(frame.data(), frame.size(), inflated.data(), inflated.size());
+        assert(n > 0);
+        for (size_t at = 0; at < static_cast<size_t>(n); received++) {
+            uint32_t inner;
+            std::memcpy(&inner, inflated.data() + at, 4);
+            at += 4 + ntohl(inner);
+        }
+    }
+    pollfd pfd{keen.peer, POLLIN, 0};
+    int more = poll(&pfd, 1, 50);
+    assert(received == messages && more == 0);
+
+    disconnect_client(keen);
+    eager.rooms.clear();
+
+    std::cout << "✓ Compressed batch test passed" << std::endl;
+}
+
+void test_interned_names() {
+    std::cout << "\n=== Test: Interned Names ===" << std::endl;
+
+    // Alice asks for ids, Bob does not
+    ServerContext context;
+    TestClient alice = connect_client(context, 1, "alice", "names", INTERN);
+    TestClient bob = connect_client(context, 2, "bob", "names");
+    uint32_t alice_id = alice.handler->get_user_id(), room_id = alice.handler->get_room_id();
+    assert(alice_id && room_id && bob.handler->get_user_id() != alice_id);
+    assert(context.names.name(alice_id) == "alice");
+
+    // The second message names its sender by id alone, as a client may once bound
+    Message msg;
+    strncpy(msg.user, "alice", MAX_USERNAME_LEN - 1);
+    strncpy(msg.text, "first", MAX_MESSAGE_LEN - 1);
+    bool sent = ChatUtils::send_message(alice.peer, msg);
+    assert(sent);
+    msg = Message();
+    msg.uid = alice_id;
+    strncpy(msg.text, "again", MAX_MESSAGE_LEN - 1);
+    char out[MAX_FRAME_LEN + 4];
+    size_t out_len = ChatUtils::encode_frame(msg, out, sizeof(out), NameForm::IDS);
+    assert(out_len && !memmem(out, out_len, "\"user\"", 6));
+    sent = ChatUtils::send_frame(alice.peer, out, out_len);
+    assert(sent);
+
+    char first[MAX_FRAME_LEN], second[MAX_FRAME_LEN];
+    size_t first_len = 0, second_len = 0;
+    Message parsed;
+
+    // Alice: names with their ids, then the ids alone
+    bool received = ChatUtils::recv_frame(alice.peer, first, first_len) &&
+                    ChatUtils::recv_frame(alice.peer, second, second_len);
+    assert(received);
+    assert(Message::parse(first, first_len, parsed));
+    assert(std::strcmp(parsed.user, "alice") == 0 && std::strcmp(parsed.room, "names") == 0);
+    assert(parsed.uid == alice_id && parsed.rid == room_id);
+    assert(Message::parse(second, second_len, parsed));
+    assert(parsed.user[0] == '\0' && parsed.room[0] == '\0' && std::strcmp(parsed.text, "again") == 0);
+    assert(parsed.uid == alice_id && parsed.rid == room_id);
+    size_t alice_len = second_len;
+
+    // Bob: plain names throughout, byte for byte what he always got
+    received = ChatUtils::recv_frame(bob.peer, first, first_len) && ChatUtils::recv_frame(bob.peer, second, second_len);
+    assert(received);
+    assert(!memmem(first, first_len, "\"uid\"", 5) && !memmem(second, second_len, "\"rid\"", 5));
+    assert(Message::parse(second, second_len, parsed));
+    assert(std::strcmp(parsed.user, "alice") == 0 && std::strcmp(parsed.room, "names") == 0);
+    assert(parsed.uid == 0 && std::strcmp(parsed.text, "again") == 0);
+    std::cout << "Same message: " << second_len << " bytes with names, " << alice_len << " with ids" << std::endl;
+    assert(alice_len < second_len);
+
+    disconnect_client(alice);
+    disconnect_client(bob);
+    context.rooms.clear();
+
+    std::cout << "✓ Interned names test passed" << std::endl;
+}
+
+void test_filter_matcher() {
+    std::cout << "\n=== Test: Subscription Filter Automaton ===" << std::endl;
+
+    auto spec = FilterMatcher::parse_spec(" alert , ^Deploy,,^ , disk full");
+    assert((spec == std::vector<std::string>{"alert", "^Deploy", "disk full"}));
+    assert(FilterMatcher::parse_spec("").empty());
+
+    // Overlapping patterns across subscribers; ids deliberately unsorted
+    FilterMatcher matcher({{30, {"hers"}}, {10, {"he", "^deploy"}}, {20, {"she", "alert"}}, {40, {"xyz"}}});
+    assert(matcher.subscribers() == 4 && matcher.words() == 1);
+    assert(matcher.slot_of(10) == 0 && matcher.slot_of(40) == 3 && matcher.slot_of(99) == -1);
+
+    auto hits = [&matcher](const char* text) {
+        uint64_t matched = 0;
+        matcher.match(text, std::strlen(text), &matched);
+        std::vector<int> ids;
+        for (int id : {10, 20, 30, 40}) {
+            if (matched >> matcher.slot_of(id) & 1) ids.push_back(id);
+        }
+        return ids;
+    };
+    assert((hits("ushers") == std::vector<int>{10, 20, 30}));  // he, she and hers all end inside
+    assert((hits("SHE said") == std::vector<int>{10, 20}));     // Case-insensitive
+    assert((hits("Deploy done") == std::vector<int>{10}));
+    assert(hits("redeploy done").empty());                      // '^' anchors to the start
+    assert((hits("ALERT: disk") == std::vector<int>{20}));
+    assert(hits("nothing to see").empty());
+    assert(hits("").empty());
+
+    // More subscribers than one bitmap word
+    std::vector<FilterMatcher::Subscription> many;
+    for (int id = 0; id < 200; ++id) many.push_back({id, {"k" + std::to_string(id) + "!"}});
+    FilterMatcher wide(many);
+    assert(wide.words() == 4);
+    std::vector<uint64_t> bits(wide.words(), 0);
+    const char* text = "k7! k150! k199!";
+    wide.match(text, std::strlen(text), bits.data());
+    int set = 0;
+    for (uint64_t word : bits) set += __builtin_popcountll(word);
+    assert(set == 3);
+    assert(bits[wide.slot_of(150) / 64] >> (wide.slot_of(150) % 64) & 1);
+
+    std::cout << "States: " << wide.states() << " for " << many.size() << " patterns" << std::endl;
+    std::cout << "✓ Filter automaton test passed" << std::endl;
+}
+
+void test_filtered_resume() {
+    std::cout << "\n=== Test: Filtered Resume Replay ===" << std::endl;
+
+    ServerContext context;
+    auto room = context.rooms.get_or_create("watch");
+    Message line;
+    strncpy(line.user, "ops", MAX_USERNAME_LEN - 1);
+    const char* history[] = {"start", "alert one", "noise", "deploy now", "more noise", "ALERT two"};
+    for (const char* text : history) {
+        strncpy(line.text, text, MAX_MESSAGE_LEN - 1);
+        room->publish(line, 0);
+    }
+    while (room->last_sequence() < 6 || room->queue_depth() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Resuming after "start" with a filter: only what the filter lets through
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 1, context);
+    handler->start();
+    Message hello;
+    strncpy(hello.user, "watcher", MAX_USERNAME_LEN - 1);
+    strncpy(hello.room, "watch", MAX_ROOMNAME_LEN - 1);
+    strncpy(hello.text, "alert", MAX_MESSAGE_LEN - 1);
+    hello.filter = true;
+    hello.seq = 1;
+    uint64_t replayed_before = Metrics::global().total(Counter::REPLAYED);
+    bool sent = ChatUtils::send_message(sv[1], hello);
+    assert(sent);
+
+    // Then live traffic, filtered the same way
+    while (room->member_count() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    for (const char* text : {"noise again", "alert three"}) {
+        strncpy(line.text, text, MAX_MESSAGE_LEN - 1);
+        room->publish(line, 0);
+    }
+    std::vector<std::pair<uint64_t, std::string>> got;
+    for (int i = 0; i < 3; ++i) {
+        Message msg;
+        bool received = ChatUtils::recv_message(sv[1], msg);
+        assert(received);
+        got.emplace_back(msg.seq, msg.text);
+    }
+    assert((got == std::vector<std::pair<uint64_t, std::string>>{{2, "alert one"}, {6, "ALERT two"}, {8, "alert three"}}));
+    assert(Metrics::global().total(Counter::REPLAYED) - replayed_before == 2);
+
+    shutdown(sv[1], SHUT_RDWR);
+    while (!handler->is_finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handler.reset();
+    room.reset();
+    context.rooms.clear();
+    close(sv[1]);
+
+    std::cout << "✓ Filtered resume test passed" << std::endl;
+}
+
+void test_task_pool() {
+    std::cout << "\n=== Test: Work-Stealing Task Pool ===" << std::endl;
+
+    const int producers = 4;
+    const int per_producer = 2000;
+    std::atomic<int> done(0);
+
+    TaskPool pool(3);
+    pool.start();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            for (int n = 0; n < per_producer; ++n) {
+                // Every external task spawns a child on the worker's own deque
+                pool.submit([&]() {
+                    pool.submit([&]() { done.fetch_add(1); });
+                    done.fetch_add(1);
+                });
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    const int expected = producers * per_producer * 2;
+    for (int i = 0; i < 500 && done.load() < expected; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pool.stop();
+
+    assert(done.load() == expected);
+    assert(pool.executed() <= static_cast<uint64_t>(expected));
+
+    std::cout << "✓ Task pool test passed (" << pool.steals() << " steals)" << std::endl;
+}
+
+void test_strand_fairness() {
+    std::cout << "\n=== Test: Busy Strands Take Turns ===" << std::endl;
+
+    // One worker, two clients with more queued than one turn: neither waits
+    // for the other to go quiet
+    const int messages = 200;
+    ServerContext context;
+    context.pool = std::make_unique<TaskPool>(1);
+    std::atomic<bool> gate(false), entered(false);
+    std::mutex order_mutex;
+    std::string order;
+    context.pipeline.add_stage("slow", [&](Message& msg, const ClientHandler&) {
+        entered = true;
+        while (!gate) std::this_thread::yield();
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(100);
+        while (std::chrono::steady_clock::now() < until) {}
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order += msg.user[0];
+        return true;
+    });
+    context.pool->start();
+
+    int a[2], b[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, a);
+    assert(paired == 0);
+    paired = socketpair(AF_UNIX, SOCK_STREAM, 0, b);
+    assert(paired == 0);
+    auto first = std::make_shared<ClientHandler>(a[0], 1, context);
+    auto second = std::make_shared<ClientHandler>(b[0], 2, context);
+    first->start();
+    second->start();
+
+    Message line;
+    strncpy(line.room, "turns", MAX_ROOMNAME_LEN - 1);
+    auto flood = [&line](int fd, const char* user) {
+        Message msg = line;
+        strncpy(msg.user, user, MAX_USERNAME_LEN - 1);
+        bool sent = ChatUtils::send_message(fd, msg);  // Hello
+        for (int i = 0; sent && i < messages; ++i) {
+            std::snprintf(msg.text, MAX_MESSAGE_LEN, "busy %d", i);
+            sent = ChatUtils::send_message(fd, msg);
+        }
+        return sent;
+    };
+    bool sent_a = false, sent_b = false;
+    std::thread flood_a([&]() { sent_a = flood(a[1], "a"); });
+    while (!entered) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::thread flood_b([&]() { sent_b = flood(b[1], "b"); });
+    while (first->backlog() < 8 || second->backlog() < 8) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gate = true;
+    flood_a.join();
+    flood_b.join();
+    assert(sent_a && sent_b);
+    auto room = context.rooms.get_or_create("turns");
+    while (room->last_sequence() < 2 * messages) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // The first turn is "a"'s, the next one "b"'s
+    std::lock_guard<std::mutex> lock(order_mutex);
+    size_t switches = 0;
+    for (size_t i = 1; i < order.size(); ++i) switches += order[i] != order[i - 1];
+    std::cout << "First \"b\" at " << order.find('b') << ", turns: " << switches + 1 << std::endl;
+    assert(order.size() == 2 * messages);
+    assert(order.find('b') <= 32);
+    assert(switches >= 4);
+
+    shutdown(a[1], SHUT_RDWR);
+    shutdown(b[1], SHUT_RDWR);
+    while (room->member_count() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    first.reset();
+    second.reset();
+    close(a[1]);
+    close(b[1]);
+    context.pool->stop();
+    room.reset();
+    context.rooms.clear();
+
+    std::cout << "✓ Strand fairness test passed" << std::endl;
+}
+
+void test_hdr_histogram() {
+    std::cout << "\n=== Test: HDR Histogram ===" << std::endl;
+
+    using ChatUtils::HdrHistogram;
+
+    // Bucket bounds tile the value range without gaps
+    for (size_t i = 1; i < HdrHistogram::kBucketCount; ++i) {
+        assert(HdrHistogram::bucket_lower(i) == HdrHistogram::bucket_upper(i - 1) + 1);
+        assert(HdrHistogram::bucket_index(HdrHistogram::bucket_lower(i)) == i);
+        assert(HdrHistogram::bucket_index(HdrHistogram::bucket_upper(i)) == i);
+    }
+
+    HdrHistogram h;
+    for (uint64_t v = 1; v <= 100000; ++v) h.record(v * 1000);  // 1us .. 100ms in ns
+    assert(h.count() == 100000);
+    assert(h.max() == 100000000ULL);
+
+    const double percentiles[] = {50, 90, 99, 99.9};
+    for (double p : percentiles) {
+        double expected = p / 100 * 100000 * 1000;
+        double got = static_cast<double>(h.value_at_percentile(p));
+        std::cout << "p" << p << " = " << got / 1e6 << " ms" << std::endl;
+        assert(got >= expected * 0.999 && got <= expected * 1.04);
+    }
+    assert(h.value_at_percentile(100) == h.max());
+
+    // Merging is the same as recording into one
+    HdrHistogram a, b;
+    a.record(10);
+    b.record(1000000);
+    a.merge(b);
+    assert(a.count() == 2 && a.max() == 1000000 && a.sum() == 1000010);
+
+    std::cout << "✓ Histogram test passed" << std::endl;
+}
+
+static std::string http_get(int fd, const char* path) {
+    std::string request = std::string("GET ") + path + " HTTP/1.0\r\n\r\n";
+    bool sent = ChatUtils::send_frame(fd, request.data(), request.size());
+    assert(sent);
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) response.append(buffer, static_cast<size_t>(n));
+    close(fd);
+    return response;
+}
+
+void test_metrics_endpoint() {
+    std::cout << "\n=== Test: Metrics Endpoint ===" << std::endl;
+
+    const int messages = 20;
+    ServerContext context;  // No pool: stages run inline
+
+    // One real client in room "metrics" over a socketpair
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 7, context);
+    handler->start();
+
+    Message msg;
+    strncpy(msg.user, "carol", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "metrics", MAX_ROOMNAME_LEN - 1);
+    strncpy(msg.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+    bool sent = ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    auto room = context.rooms.get_or_create("metrics");
+    for (int i = 0; i < 200 && room->member_count() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    uint64_t frames_in_before = Metrics::global().total(Counter::FRAMES_IN);
+    for (int i = 0; i < messages; ++i) {
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "hello %d", i);
+        sent = ChatUtils::send_message(sv[1], msg);
+        assert(sent);
+    }
+    // The sender gets its own messages back once they are sequenced
+    Message echo;
+    for (int i = 0; i < messages; ++i) {
+        bool received = ChatUtils::recv_message(sv[1], echo);
+        assert(received);
+    }
+    assert(Metrics::global().total(Counter::FRAMES_IN) - frames_in_before == static_cast<uint64_t>(messages));
+
+    const char* socket_path = "/tmp/chat_metrics_test.sock";
+    MetricsServer server;
+    server.add_route("/metrics", "text/plain; version=0.0.4", [&context] { return render_metrics(context); });
+    server.add_route("/bulk", "text/plain", [] { return std::string(16 << 20, 'x'); });  // Outgrows any buffer
+    bool listening = server.listen_tcp(0);
+    assert(listening);
+    listening = server.listen_unix(socket_path);
+    assert(listening);
+    server.start();
+
+    // Over TCP
+    int tcp = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(server.tcp_port()));
+    bool connected = connect(tcp, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    assert(connected);
+    std::string body = http_get(tcp, "/metrics");
+    std::cout << body.substr(0, body.find("chat_fanout_latency_seconds_bucket")) << "..." << std::endl;
+
+    assert(body.find("HTTP/1.1 200 OK") == 0);
+    assert(body.find("# TYPE chat_frames_in_total counter") != std::string::npos);
+    assert(body.find("chat_clients_connected 1\n") != std::string::npos);
+    assert(body.find("chat_room_members{room=\"metrics\"} 1\n") != std::string::npos);
+    assert(body.find("chat_client_backlog{room=\"metrics\",client=\"7\",user=\"carol\"} 0\n") != std::string::npos);
+    assert(body.find("chat_fanout_latency_seconds_bucket{le=\"+Inf\"}") != std::string::npos);
+    assert(body.find("chat_fanout_latency_seconds_quantile{quantile=\"0.99\"}") != std::string::npos);
+    assert(Metrics::global().merged(Histogram::FANOUT_LATENCY).count() >= static_cast<uint64_t>(messages));
+
+    // Over the Unix socket, and an unknown path
+    int unix_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un uaddr{};
+    uaddr.sun_family = AF_UNIX;
+    strncpy(uaddr.sun_path, socket_path, sizeof(uaddr.sun_path) - 1);
+    connected = connect(unix_fd, reinterpret_cast<sockaddr*>(&uaddr), sizeof(uaddr)) == 0;
+    assert(connected);
+    assert(http_get(unix_fd, "/nope").find("404") != std::string::npos);
+
+    // A scraper that asks for a lot and never reads is cut off; the next is served
+    int stalled = socket(AF_UNIX, SOCK_STREAM, 0);
+    connected = connect(stalled, reinterpret_cast<sockaddr*>(&uaddr), sizeof(uaddr)) == 0;
+    std::string request = "GET /bulk HTTP/1.0\r\n\r\n";
+    sent = ChatUtils::send_frame(stalled, request.data(), request.size());
+    assert(connected && sent);
+    auto asked = std::chrono::steady_clock::now();
+    unix_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    connected = connect(unix_fd, reinterpret_cast<sockaddr*>(&uaddr), sizeof(uaddr)) == 0;
+    assert(connected);
+    assert(http_get(unix_fd, "/nope").find("404") != std::string::npos);
+    double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - asked).count();
+    std::cout << "Served after a stalled scraper in " << waited << " s" << std::endl;
+    assert(waited < 3.0);
+    close(stalled);
+
+    server.stop();
+    assert(access(socket_path, F_OK) != 0);  // Cleaned up
+
+    // Drop our reference only after the handler has left the room, so the
+    // last one is never released on the handler's own thread
+    shutdown(sv[1], SHUT_RDWR);
+    while (room->member_count() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handler.reset();
+    close(sv[1]);
+    context.rooms.clear();
+
+    std::cout << "✓ Metrics endpoint test passed" << std::endl;
+}
+
+void test_message_tracing() {
+    std::cout << "\n=== Test: Message Tracing ===" << std::endl;
+
+    const int messages = 8;
+    Tracer& tracer = Tracer::global();
+    tracer.clear();
+    tracer.set_sample_every(2);  // Every other message per ingest thread
+
+    ServerContext context;
+    context.pool = std::make_unique<TaskPool>(2);
+    context.pool->start();
+
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 11, context);
+    handler->start();
+
+    Message msg;
+    strncpy(msg.user, "dave", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "traced", MAX_ROOMNAME_LEN - 1);
+    strncpy(msg.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+    bool sent = ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    for (int i = 0; i < messages; ++i) {
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "trace me %d", i);
+        sent = ChatUtils::send_message(sv[1], msg);
+        assert(sent);
+    }
+    Message echo;
+    for (int i = 0; i < messages; ++i) {
+        bool received = ChatUtils::recv_message(sv[1], echo);
+        assert(received);
+    }
+    auto room = context.rooms.get_or_create("traced");
+
+    std::string json = tracer.to_chrome_json();
+    std::cout << json.substr(0, 300) << "..." << std::endl;
+    assert(json.find("{\"displayTimeUnit\"") == 0);
+    assert(json.substr(json.size() - 3) == "]}\n");
+
+    // Every stage shows up once per sampled message
+    const char* stages[] = {"read", "decode", "queue", "stages", "sequence", "fan_out", "write"};
+    for (const char* stage : stages) {
+        std::string needle = std::string("\"name\":\"") + stage + "\"";
+        size_t count = 0;
+        for (size_t pos = json.find(needle); pos != std::string::npos; pos = json.find(needle, pos + 1)) count++;
+        std::cout << stage << ": " << count << std::endl;
+        assert(count == messages / 2);
+    }
+    assert(json.find("\"name\":\"thread_name\"") != std::string::npos);
+    assert(json.find("\"ph\":\"s\"") != std::string::npos);
+    assert(json.find("\"ph\":\"f\"") != std::string::npos);
+
+    // Cleared spans are gone; with sampling off nothing new is recorded
+    tracer.clear();
+    tracer.set_sample_every(0);
+    sent = ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    bool received = ChatUtils::recv_message(sv[1], echo);
+    assert(received);
+    assert(tracer.to_chrome_json().find("\"ph\":\"X\"") == std::string::npos);
+
+    // Drop our reference only after the handler has left the room, so the
+    // last one is never released on the handler's own thread
+    shutdown(sv[1], SHUT_RDWR);
+    while (room->member_count() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handler.reset();
+    close(sv[1]);
+    context.pool->stop();
+    context.rooms.clear();
+
+    std::cout << "✓ Tracing test passed" << std::endl;
+}
+
+void test_traffic_capture() {
+    std::cout << "\n=== Test: Traffic Capture ===" << std::endl;
+
+    const int messages = 20;
+    char path[] = "/tmp/chat_capture_XXXXXX";
+    int tmp = mkstemp(path);
+    assert(tmp >= 0);
+    close(tmp);
+
+    ServerContext context;
+    context.capture = std::make_unique<CaptureWriter>();
+    bool opened = context.capture->open(path);
+    assert(opened);
+
+    int sv[2];
+    int paired = socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    assert(paired == 0);
+    auto handler = std::make_shared<ClientHandler>(sv[0], 21, context);
+    handler->start();
+
+    Message msg;
+    strncpy(msg.user, "erin", MAX_USERNAME_LEN - 1);
+    strncpy(msg.room, "captured", MAX_ROOMNAME_LEN - 1);
+    strncpy(msg.text, "[JOINED]", MAX_MESSAGE_LEN - 1);
+    bool sent = ChatUtils::send_message(sv[1], msg);
+    assert(sent);
+    for (int i = 0; i < messages; ++i) {
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "say \"%d\"", i);
+        sent = ChatUtils::send_message(sv[1], msg);
+        assert(sent);
+    }
+    Message echo;
+    for (int i = 0; i < messages; ++i) {
+        bool received = ChatUtils::recv_message(sv[1], echo);
+        assert(received);
+    }
+    auto room = context.rooms.get_or_create("captured");
+
+    shutdown(sv[1], SHUT_RDWR);
+    while (room->member_count() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    handler.reset();
+    close(sv[1]);
+    context.capture->close();
+    assert(context.capture->recorded() == messages + 2);
+    assert(context.capture->dropped() == 0);
+
+    // HELLO, the frames exactly as sent and in order, then BYE
+    std::vector<ChatUtils::CaptureRecord> records;
+    bool loaded = ChatUtils::read_capture(path, records);
+    assert(loaded);
+    assert(records.size() == messages + 2);
+    assert(records.front().kind == ChatUtils::CaptureRecord::HELLO);
+    assert(records.back().kind == ChatUtils::CaptureRecord::BYE);
+    for (int i = 0; i < messages; ++i) {
+        const ChatUtils::CaptureRecord& r = records[static_cast<size_t>(i) + 1];
+        assert(r.kind == ChatUtils::CaptureRecord::FRAME);
+        assert(r.connection == 21);
+        assert(r.ns >= records[static_cast<size_t>(i)].ns);
+        Message parsed;
+        assert(Message::parse(r.payload.data(), r.payload.size(), parsed));
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "say \"%d\"", i);
+        assert(strcmp(parsed.text, msg.text) == 0);
+    }
+    std::remove(path);
+    context.rooms.clear();
+
+    std::cout << "✓ Capture test passed" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========== Server Core Tests ==========\n" << std::endl;
+
+    try {
+        test_sequencer_total_order();
+        test_sequence_on_wire();
+        test_replay_buffer();
+        test_token_bucket();
+        test_client_rate_limit();
+        test_filter_matcher();
+        test_filtered_resume();
+        test_timer_wheel();
+        test_idle_reaping();
+        test_throttled_not_idle();
+        test_outbox_lanes();
+        test_backlogged_client();
+        test_conflation();
+        test_compressed_batches();
+        test_interned_names();
+        test_task_pool();
+        test_strand_fairness();
+        test_hdr_histogram();
+        test_metrics_endpoint();
+        test_message_tracing();
+        test_traffic_capture();
+
+        std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "\nTest failed: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -7,15 +7,21 @@
 
 #include <iostream>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <semaphore.h>
+#include <sys/wait.h>
 #include <thread>
 #include <chrono>
+#include <string>
+#include <vector>
 #include "../shared/protocol.h"
+#include "../shared/shm_ring.h"
 
 void test_message_struct() {
     std::cout << "\n=== Test: Message Structure ===" << std::endl;
@@ -69,7 +75,8 @@ void test_shared_memory_creation() {
 
     // Set size
     size_t size = sizeof(ShmLayout);
-    assert(ftruncate(shm_fd, size) == 0);
+    int sized = ftruncate(shm_fd, size);
+    assert(sized == 0);
 
     // Map memory
     void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
@@ -85,9 +92,10 @@ void test_shared_memory_creation() {
     assert(layout->header.capacity == MAX_SLOTS);
 
     // Cleanup
-    assert(munmap(ptr, size) == 0);
-    assert(close(shm_fd) == 0);
-    assert(shm_unlink(shm_name) == 0);
+    int unmapped = munmap(ptr, size);
+    int closed = close(shm_fd);
+    int unlinked = shm_unlink(shm_name);
+    assert(unmapped == 0 && closed == 0 && unlinked == 0);
 
     std::cout << "✓ Shared memory test passed" << std::endl;
 }
@@ -171,6 +179,168 @@ void test_producer_consumer() {
     std::cout << "✓ Producer-consumer test passed" << std::endl;
 }
 
+// Child process: read until every message is either received or reported
+// as overrun, checking per-writer order survives every remap
+static int grow_reader(const char* shm_name, const char* mutex_name, int ready_fd,
+                       int writers, int per_writer) {
+    ShmRing ring;
+    if (!ring.open(shm_name, mutex_name)) return 10;
+    char ready = 'r';
+    if (write(ready_fd, &ready, 1) != 1) return 11;
+    close(ready_fd);
+
+    const unsigned long total = static_cast<unsigned long>(writers) * per_writer;
+    std::vector<int> last(writers, -1);
+    unsigned long received = 0;
+    Message msg;
+    while (received + ring.overruns() < total) {
+        if (!ring.read(msg, 5000)) return 12;  // Stalled
+        int writer = msg.user[1] - '0';
+        int n = std::atoi(msg.text);
+        if (writer < 0 || writer >= writers || n <= last[writer]) return 13;  // Duplicate or reordered
+        last[writer] = n;
+        received++;
+    }
+    if (received + ring.overruns() != total) return 14;
+    if (ring.generation() < 1 || ring.capacity() < 256) return 15;  // Never saw the grow
+    return 0;
+}
+
+static int grow_writer(const char* shm_name, const char* mutex_name, int id, int count) {
+    ShmRing ring;
+    if (!ring.open(shm_name, mutex_name)) return 20;
+    Message msg;
+    std::snprintf(msg.user, MAX_USERNAME_LEN, "w%d", id);
+    for (int n = 0; n < count; ++n) {
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "%d", n);
+        if (!ring.write(msg)) return 21;
+        if (n % 8 == 0) usleep(100);  // Keep the load running across the grow
+    }
+    return 0;
+}
+
+void test_growable_ring_multiprocess() {
+    std::cout << "\n=== Test: Growable Ring Under Multi-Process Load ===" << std::endl;
+
+    const char* shm_name = "/test_os_chat_grow";
+    const char* mutex_name = "/test_os_chat_grow_mutex";
+    const int writers = 3;
+    const int readers = 3;
+    const int per_writer = 3000;
+
+    ShmRing::unlink(shm_name, mutex_name);
+    ShmRing ring;
+    bool opened = ring.open(shm_name, mutex_name, 8);
+    assert(opened && ring.capacity() == 8);
+
+    std::vector<pid_t> children;
+    for (int r = 0; r < readers; ++r) {
+        int ready[2];
+        int piped = pipe(ready);
+        assert(piped == 0);
+        pid_t pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+            close(ready[0]);
+            _exit(grow_reader(shm_name, mutex_name, ready[1], writers, per_writer));
+        }
+        close(ready[1]);
+        char c;
+        ssize_t got = read(ready[0], &c, 1);
+        assert(got == 1);  // Reader has its cursor
+        close(ready[0]);
+        children.push_back(pid);
+    }
+
+    for (int w = 0; w < writers; ++w) {
+        pid_t pid = fork();
+        assert(pid >= 0);
+        if (pid == 0) {
+            _exit(grow_writer(shm_name, mutex_name, w, per_writer));
+        }
+        children.push_back(pid);
+    }
+
+    // Grow from this process while the children are busy
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bool grown = ring.grow(256);
+    assert(grown && ring.capacity() >= 256);
+    assert(ring.generation() >= 1);
+
+    for (pid_t pid : children) {
+        int status = 0;
+        pid_t waited = waitpid(pid, &status, 0);
+        assert(waited == pid);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cerr << "child " << pid << " failed with status " << WEXITSTATUS(status) << std::endl;
+        }
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    ring.close();
+    ShmRing::unlink(shm_name, mutex_name);
+
+    std::cout << "✓ Growable ring test passed" << std::endl;
+}
+
+void test_ring_index_past_32_bits() {
+    std::cout << "\n=== Test: Ring Indices Past 32 Bits ===" << std::endl;
+
+    const char* shm_name = "/test_os_chat_wide";
+    const char* mutex_name = "/test_os_chat_wide_mutex";
+    ShmRing::unlink(shm_name, mutex_name);
+    ShmRing writer;
+    bool opened = writer.open(shm_name, mutex_name, 24);  // Not a power of two: the modulo shows
+    assert(opened);
+
+    // Fast-forward the room to just short of 2^32 messages
+    const uint64_t start = (uint64_t(1) << 32) - 5;
+    int fd = shm_open(shm_name, O_RDWR, 0666);
+    assert(fd >= 0);
+    void* ptr = mmap(nullptr, sizeof(ShmHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    assert(ptr != MAP_FAILED);
+    ShmHeader* header = static_cast<ShmHeader*>(ptr);
+    header->read_index = start;
+    header->write_index = start;
+    header->wake = static_cast<uint32_t>(start);
+    munmap(ptr, sizeof(ShmHeader));
+    close(fd);
+
+    ShmRing reader;
+    opened = reader.open(shm_name, mutex_name);
+    assert(opened && reader.cursor() == start);
+
+    // A reader already waiting is woken through the 32-bit word as it wraps
+    Message first;
+    bool woken = false;
+    std::thread waiter([&]() { woken = reader.read(first, 2000); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    const int messages = 20;
+    Message msg;
+    strncpy(msg.user, "wide", MAX_USERNAME_LEN - 1);
+    for (int i = 0; i < messages; ++i) {
+        std::snprintf(msg.text, MAX_MESSAGE_LEN, "%d", i);
+        bool written = writer.write(msg);
+        assert(written);
+    }
+    waiter.join();
+    assert(woken && std::strcmp(first.text, "0") == 0);
+
+    for (int i = 1; i < messages; ++i) {
+        Message in;
+        bool got = reader.read(in, 0);
+        assert(got && std::atoi(in.text) == i);
+    }
+    assert(reader.cursor() == start + messages && reader.overruns() == 0);
+
+    reader.close();
+    writer.close();
+    ShmRing::unlink(shm_name, mutex_name);
+
+    std::cout << "✓ Wide index test passed" << std::endl;
+}
+
 int main() {
     std::cout << "\n========== Shared Memory System Tests ==========\n" << std::endl;
 
@@ -180,6 +350,8 @@ int main() {
         test_shared_memory_creation();
         test_ring_buffer_logic();
         test_producer_consumer();
+        test_growable_ring_multiprocess();
+        test_ring_index_past_32_bits();
 
         std::cout << "\n========== All Tests Passed! ==========\n" << std::endl;
         return 0;